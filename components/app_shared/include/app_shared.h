@@ -6,20 +6,119 @@ extern "C" {
 #endif
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
-#include "driver/gpio.h"
-#include "mqtt_client.h"
-
-// Event passed from debounce.c → main.c via gpio_event_queue
-typedef struct {
-    gpio_num_t pin;     // GPIO number
-    int        level;   // 0 = LOW, 1 = HIGH
-    const char *topic;  // MQTT topic for this pin
-} gpio_event_t;
-
-// Global handles (DEFINED exactly once in main.c)
-extern QueueHandle_t            gpio_event_queue;
-extern esp_mqtt_client_handle_t mqtt_client;
+#include "freertos/task.h"
+#include "pin_hal_types.h"
+#include "event_ring.h"
+#include "event_coalesce.h"
+#include "gpio_stats.h"
+#include "latency_hist.h"
+
+// One SPSC ring per producer context, so producers never share an index.
+typedef enum {
+    GPIO_EVENT_LANE_TASK = 0,  // Timer task (timer wheel, sampler)
+    GPIO_EVENT_LANE_ISR,       // Interrupt context (ISR-dispatched wheel)
+    GPIO_EVENT_LANE_GPIO,      // GPIO interrupt (leading-edge reports)
+    GPIO_EVENT_LANE_COUNT,
+} gpio_event_lane_t;
+
+_Static_assert(GPIO_EVENT_LANE_COUNT <= GPIO_STATS_MAX_LANES, "grow GPIO_STATS_MAX_LANES");
+
+// Global handles (DEFINED exactly once in pin_pipeline.c)
+extern gpio_event_ring_t        gpio_event_rings[GPIO_EVENT_LANE_COUNT];
+extern TaskHandle_t             gpio_event_consumer;  // Notified when a ring turns non-empty
+
+/**
+ * @brief Shared producer step: push to the lane's ring, or fold a level event
+ *        into the pin's coalesced record when that is pending or the ring is
+ *        full. Diagnostic kinds are never coalesced; they are dropped instead.
+ *
+ * @return false if the event was dropped
+ */
+FORCE_INLINE_ATTR bool gpio_event_push_lane(gpio_event_lane_t lane, const gpio_event_t *evt,
+                                            bool *need_wake) {
+    gpio_event_ring_t *ring = &gpio_event_rings[lane];
+#if CONFIG_APP_EVENT_OVERFLOW_COALESCE
+    bool coalescible = (evt->kind == GPIO_EVENT_LEVEL);
+    if (!(coalescible && gpio_event_coalesce_pending(evt->pin)) &&
+        gpio_event_ring_push(ring, evt, need_wake)) {
+        gpio_stats_stage_inc(GPIO_STAGE_STAT_POSTED);
+        gpio_stats_ring_depth(lane, gpio_event_ring_count(ring));
+        return true;
+    }
+    if (coalescible) {
+        gpio_event_coalesce(evt);
+        gpio_stats_stage_inc(GPIO_STAGE_STAT_COALESCED);
+        *need_wake = true;
+        return true;
+    }
+#else
+    if (gpio_event_ring_push(ring, evt, need_wake)) {
+        gpio_stats_stage_inc(GPIO_STAGE_STAT_POSTED);
+        gpio_stats_ring_depth(lane, gpio_event_ring_count(ring));
+        return true;
+    }
+#endif
+    gpio_stats_stage_inc(GPIO_STAGE_STAT_DROPPED);
+    gpio_stats_pin_inc(evt->pin, GPIO_PIN_STAT_DROPPED);
+    return false;
+}
+
+/**
+ * @brief Post an event from task context. Only notifies the consumer when it
+ *        may be waiting, so bursts cost no kernel calls after the first event.
+ *        With CONFIG_APP_EVENT_OVERFLOW_COALESCE, a full ring folds a level
+ *        event into the pin's coalesced record instead of losing it.
+ *
+ * @return false if the event was dropped
+ */
+static inline bool gpio_event_post(gpio_event_lane_t lane, const gpio_event_t *evt) {
+    bool need_wake = false;
+    if (!gpio_event_push_lane(lane, evt, &need_wake)) {
+        return false;
+    }
+    if (need_wake && gpio_event_consumer) {
+        xTaskNotifyGive(gpio_event_consumer);
+    }
+    return true;
+}
+
+/**
+ * @brief Post an event from an ISR; same contract as gpio_event_post().
+ */
+FORCE_INLINE_ATTR bool gpio_event_post_from_isr(gpio_event_lane_t lane, const gpio_event_t *evt,
+                                                BaseType_t *hp_task_woken) {
+    bool need_wake = false;
+    if (!gpio_event_push_lane(lane, evt, &need_wake)) {
+        return false;
+    }
+    if (need_wake && gpio_event_consumer) {
+        vTaskNotifyGiveFromISR(gpio_event_consumer, hp_task_woken);
+    }
+    return true;
+}
+
+/**
+ * @brief Take the next event across all lanes in sequence order (consumer only).
+ *
+ * @return false when every lane is empty
+ */
+static inline bool gpio_event_take(gpio_event_t *out) {
+    const gpio_event_t *best = NULL;
+    int best_lane = -1;
+    for (int lane = 0; lane < GPIO_EVENT_LANE_COUNT; lane++) {
+        const gpio_event_t *evt = gpio_event_ring_peek(&gpio_event_rings[lane]);
+        if (evt && (!best || (int32_t)(evt->seq - best->seq) < 0)) {
+            best = evt;
+            best_lane = lane;
+        }
+    }
+    if (!best) {
+        return false;
+    }
+    *out = *best;
+    gpio_event_ring_drop(&gpio_event_rings[best_lane]);
+    return true;
+}
 
 #ifdef __cplusplus
 }
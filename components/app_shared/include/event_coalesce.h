@@ -0,0 +1,55 @@
+#ifndef EVENT_COALESCE_H
+#define EVENT_COALESCE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_attr.h"
+#include "event_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Several events for one pin folded into a single record on ring overflow.
+// Timestamps are confirm times, same 32-bit wrapping clock as gpio_event_t.
+typedef struct {
+    uint8_t  pin;
+    uint8_t  level;        // Latest (final) level
+    uint32_t transitions;  // Events merged into this record
+    uint32_t first_seq;
+    uint32_t last_seq;
+    uint32_t first_us;
+    uint32_t last_us;
+} gpio_event_coalesced_t;
+
+// Dirty bitmap, bit n = GPIO n; two words so every access is a native 32-bit atomic.
+extern _Atomic uint32_t gpio_event_coalesce_dirty[2];
+
+/**
+ * @brief True if the pin has a coalesced record waiting. Producers must then
+ *        coalesce newer events too, so the record never goes stale.
+ */
+FORCE_INLINE_ATTR bool gpio_event_coalesce_pending(uint8_t pin) {
+    return (atomic_load_explicit(&gpio_event_coalesce_dirty[pin >> 5], memory_order_acquire)
+            >> (pin & 31)) & 1;
+}
+
+/**
+ * @brief Fold an event into its pin's record and mark the pin dirty.
+ *        Callable from task or ISR context.
+ */
+void gpio_event_coalesce(const gpio_event_t *evt);
+
+/**
+ * @brief Take the record of the lowest dirty pin (consumer only).
+ *
+ * @return false when no pin is dirty
+ */
+bool gpio_event_coalesce_take(gpio_event_coalesced_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_COALESCE_H
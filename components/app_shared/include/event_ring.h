@@ -0,0 +1,109 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_RING_SIZE   (1u << CONFIG_APP_EVENT_RING_SIZE_LOG2)
+#define EVENT_RING_MASK   (EVENT_RING_SIZE - 1)
+#define EVENT_RING_ALIGN  32  // Keep producer and consumer indices on separate cache lines
+
+// What a gpio_event_t reports.
+typedef enum {
+    GPIO_EVENT_LEVEL = 0,  // Debounced level change
+    GPIO_EVENT_CHATTER_START, // Edge rate limit hit; interrupt off, pin polled
+    GPIO_EVENT_CHATTER_END,   // Pin settled; interrupt back on (level = settled level)
+    GPIO_EVENT_COUNT,         // Pulse counter window closed (edge_us = window start)
+    GPIO_EVENT_POSITION,      // Encoder position report (edge_us = previous report)
+    GPIO_EVENT_PWM,           // PWM capture window closed (edge_us = window start)
+    GPIO_EVENT_FRAME,         // Burst frame decoded (edge_us = first edge, level = valid)
+} gpio_event_kind_t;
+
+// Compact event record passed from debounce.c → main.c through a gpio_event_ring_t.
+// Timestamps are the low 32 bits of esp_timer_get_time() and wrap every ~71.6 min,
+// also in the published messages: only compare them as a uint32_t difference,
+// (uint32_t)(later - earlier), which is right for spans under ~35 min. The topic
+// is looked up by pin on the consumer side.
+typedef struct {
+    uint8_t  pin;        // GPIO number
+    uint8_t  level;      // 0 = LOW, 1 = HIGH
+    uint8_t  kind;       // gpio_event_kind_t
+    uint8_t  reserved;
+    uint32_t seq;        // Global sequence number, assigned at confirmation
+    uint32_t edge_us;    // First edge of the burst (captured in the GPIO ISR)
+    uint32_t confirm_us; // Level confirmed stable by the debounce engine
+} gpio_event_t;
+
+_Static_assert(sizeof(gpio_event_t) == 16, "gpio_event_t must stay 16 bytes");
+
+// Lock-free single-producer/single-consumer ring. head and tail are free-running;
+// the producer only writes head, the consumer only writes tail.
+typedef struct {
+    _Atomic uint32_t head __attribute__((aligned(EVENT_RING_ALIGN)));
+    _Atomic uint32_t tail __attribute__((aligned(EVENT_RING_ALIGN)));
+    gpio_event_t     slots[EVENT_RING_SIZE] __attribute__((aligned(EVENT_RING_ALIGN)));
+} gpio_event_ring_t;
+
+/**
+ * @brief Append an event (producer side).
+ *
+ * @param ring      Ring owned by the calling producer
+ * @param evt       Event to copy in
+ * @param need_wake Set true if the consumer may have seen the ring empty and
+ *                  should be notified; left untouched otherwise
+ * @return false if the ring is full (event not stored)
+ */
+FORCE_INLINE_ATTR bool gpio_event_ring_push(gpio_event_ring_t *ring, const gpio_event_t *evt,
+                                            bool *need_wake) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= EVENT_RING_SIZE) {
+        return false;
+    }
+    ring->slots[head & EVENT_RING_MASK] = *evt;
+    // seq_cst store/load pair against the consumer's tail store/head load:
+    // either the consumer sees this event or we see that it drained up to it.
+    atomic_store_explicit(&ring->head, head + 1, memory_order_seq_cst);
+    if (atomic_load_explicit(&ring->tail, memory_order_seq_cst) == head) {
+        *need_wake = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Oldest pending event without removing it (consumer side), or NULL.
+ */
+static inline const gpio_event_t *gpio_event_ring_peek(gpio_event_ring_t *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_seq_cst);
+    return (head == tail) ? NULL : &ring->slots[tail & EVENT_RING_MASK];
+}
+
+/**
+ * @brief Release the event returned by gpio_event_ring_peek() (consumer side).
+ */
+static inline void gpio_event_ring_drop(gpio_event_ring_t *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_seq_cst);
+}
+
+/**
+ * @brief Number of events waiting (approximate from either side).
+ */
+FORCE_INLINE_ATTR uint32_t gpio_event_ring_count(gpio_event_ring_t *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_relaxed) -
+           atomic_load_explicit(&ring->tail, memory_order_relaxed);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_RING_H
@@ -0,0 +1,113 @@
+#ifndef GPIO_STATS_H
+#define GPIO_STATS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "pin_hal_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-pin counters.
+typedef enum {
+    GPIO_PIN_STAT_EDGES = 0,   // Edges seen by the GPIO interrupt
+    GPIO_PIN_STAT_BURSTS,      // Debounce windows that closed (edges / bursts = bounces per transition)
+    GPIO_PIN_STAT_EVENTS,      // Levels queued for publishing
+    GPIO_PIN_STAT_SUPPRESSED,  // Settled levels not reported (repeats, filtered direction)
+    GPIO_PIN_STAT_CHATTER,     // Interrupt moderation episodes
+    GPIO_PIN_STAT_DROPPED,     // Events lost to a full ring
+    GPIO_PIN_STAT_COUNT,
+} gpio_pin_stat_t;
+
+// Per-stage pipeline counters.
+typedef enum {
+    GPIO_STAGE_STAT_ISR = 0,          // GPIO interrupt entries
+    GPIO_STAGE_STAT_WHEEL_TICKS,      // Timer wheel ticks processed
+    GPIO_STAGE_STAT_WHEEL_EXPIRED,    // Deadlines expired (debounce windows and chatter polls)
+    GPIO_STAGE_STAT_SAMPLER_TICKS,    // Sampling engine ticks
+    GPIO_STAGE_STAT_POSTED,           // Events pushed to a ring
+    GPIO_STAGE_STAT_COALESCED,        // Events folded into a coalesced record
+    GPIO_STAGE_STAT_DROPPED,          // Events lost (ring full, not coalescible)
+    GPIO_STAGE_STAT_CONSUMED,         // Events and records taken by the consumer
+    GPIO_STAGE_STAT_PUBLISHED,        // MQTT publishes accepted
+    GPIO_STAGE_STAT_PUBLISH_FAILED,   // MQTT publishes refused or no client
+    GPIO_STAGE_STAT_COUNT,
+} gpio_stage_stat_t;
+
+#define GPIO_STATS_MAX_LANES 4  // >= GPIO_EVENT_LANE_COUNT
+
+// One block per core. Writers only ever touch the block of the core they run
+// on, so increments never bounce a cache line between cores; they are still
+// relaxed atomics because an ISR may preempt a task on the same core.
+typedef struct {
+    _Atomic uint32_t pin[GPIO_NUM_MAX][GPIO_PIN_STAT_COUNT];
+    _Atomic uint32_t stage[GPIO_STAGE_STAT_COUNT];
+    _Atomic uint32_t ring_hwm[GPIO_STATS_MAX_LANES];  // Highest ring depth seen after a push
+} gpio_stats_core_t;
+
+// Counters summed over cores.
+typedef struct {
+    uint32_t pin[GPIO_NUM_MAX][GPIO_PIN_STAT_COUNT];
+    uint32_t stage[GPIO_STAGE_STAT_COUNT];
+    uint32_t ring_hwm[GPIO_STATS_MAX_LANES];           // Max over cores
+    int64_t  since_us;                                 // pin_hal time of the last reset
+} gpio_stats_snapshot_t;
+
+extern gpio_stats_core_t gpio_stats_cores[portNUM_PROCESSORS];
+
+FORCE_INLINE_ATTR void gpio_stats_pin_inc(int pin, gpio_pin_stat_t stat) {
+#if CONFIG_APP_STATS
+    atomic_fetch_add_explicit(&gpio_stats_cores[xPortGetCoreID()].pin[pin][stat], 1,
+                              memory_order_relaxed);
+#endif
+}
+
+FORCE_INLINE_ATTR void gpio_stats_stage_add(gpio_stage_stat_t stat, uint32_t n) {
+#if CONFIG_APP_STATS
+    atomic_fetch_add_explicit(&gpio_stats_cores[xPortGetCoreID()].stage[stat], n,
+                              memory_order_relaxed);
+#endif
+}
+
+FORCE_INLINE_ATTR void gpio_stats_stage_inc(gpio_stage_stat_t stat) {
+    gpio_stats_stage_add(stat, 1);
+}
+
+FORCE_INLINE_ATTR void gpio_stats_ring_depth(int lane, uint32_t depth) {
+#if CONFIG_APP_STATS
+    _Atomic uint32_t *hwm = &gpio_stats_cores[xPortGetCoreID()].ring_hwm[lane];
+    uint32_t seen = atomic_load_explicit(hwm, memory_order_relaxed);
+    while (depth > seen &&
+           !atomic_compare_exchange_weak_explicit(hwm, &seen, depth, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+#endif
+}
+
+/**
+ * @brief Sum every core's counters into out; with reset, each counter is
+ *        swapped for zero as it is read, so no increment is lost in between.
+ */
+void gpio_stats_snapshot(gpio_stats_snapshot_t *out, bool reset);
+
+/**
+ * @brief Zero every counter.
+ */
+void gpio_stats_reset(void);
+
+/**
+ * @brief Short lowercase names for formatting ("edges", "posted", ...).
+ */
+const char *gpio_stats_pin_stat_name(gpio_pin_stat_t stat);
+const char *gpio_stats_stage_stat_name(gpio_stage_stat_t stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPIO_STATS_H
@@ -0,0 +1,73 @@
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Log-linear (HDR-style) histogram: 8 buckets per power of two, so any
+// recorded value is off by at most 12.5%. Covers 0 us .. ~8 s; longer values
+// land in the last bucket. Fixed size, no allocation.
+#define LATENCY_HIST_SUB_BITS 3
+#define LATENCY_HIST_BUCKETS  168
+
+typedef struct {
+    uint16_t buckets[LATENCY_HIST_BUCKETS];  // Saturating
+    uint32_t count;
+    uint32_t max_us;
+} latency_hist_t;
+
+void     latency_hist_record(latency_hist_t *hist, uint32_t us);
+// Upper bound of the bucket holding the given rank, in per mille (500 = p50,
+// 999 = p99.9). Returns 0 for an empty histogram.
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t per_mille);
+
+// Stages of the edge-to-publish path, all measured from gpio_event_t stamps.
+typedef enum {
+    GPIO_LAT_STAGE_CONFIRM = 0,  // First edge (GPIO ISR) -> debounce confirm
+    GPIO_LAT_STAGE_DEQUEUE,      // Confirm -> dequeued by the consumer
+    GPIO_LAT_STAGE_PUBLISH,      // Dequeue -> publish sink returned
+    GPIO_LAT_STAGE_TOTAL,        // First edge -> publish returned
+    GPIO_LAT_STAGE_COUNT,
+} gpio_lat_stage_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t p999_us;
+    uint32_t max_us;
+} gpio_latency_summary_t;
+
+/**
+ * @brief Record one stage latency for a pin. Histograms are owned by the
+ *        event consumer: call, summarize and reset from that task only.
+ *        The first CONFIG_APP_LATENCY_HIST_PINS pins seen get a slot; later
+ *        pins are not tracked. us is a span between two gpio_event_t
+ *        timestamps, taken as (uint32_t)(later - earlier) so it survives their wrap.
+ */
+void gpio_latency_record(int pin, gpio_lat_stage_t stage, uint32_t us);
+
+/**
+ * @brief p50/p99/p99.9/max of one pin and stage.
+ *
+ * @return false if the pin has no slot or no samples
+ */
+bool gpio_latency_summary(int pin, gpio_lat_stage_t stage, gpio_latency_summary_t *out);
+
+/**
+ * @brief Clear every histogram; pins keep their slots.
+ */
+void gpio_latency_reset(void);
+
+const char *gpio_latency_stage_name(gpio_lat_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LATENCY_HIST_H
@@ -0,0 +1,46 @@
+#include "freertos/FreeRTOS.h"
+#include "pin_hal_types.h"
+#include "event_coalesce.h"
+
+_Atomic uint32_t gpio_event_coalesce_dirty[2];
+
+static gpio_event_coalesced_t s_records[GPIO_NUM_MAX];
+static portMUX_TYPE s_coalesce_lock = portMUX_INITIALIZER_UNLOCKED;
+
+IRAM_ATTR void gpio_event_coalesce(const gpio_event_t *evt) {
+    gpio_event_coalesced_t *rec = &s_records[evt->pin];
+    uint32_t bit = 1u << (evt->pin & 31);
+
+    portENTER_CRITICAL_SAFE(&s_coalesce_lock);
+    if (!gpio_event_coalesce_pending(evt->pin)) {
+        rec->pin         = evt->pin;
+        rec->transitions = 0;
+        rec->first_seq   = evt->seq;
+        rec->first_us    = evt->confirm_us;
+        atomic_fetch_or_explicit(&gpio_event_coalesce_dirty[evt->pin >> 5], bit,
+                                 memory_order_release);
+    }
+    rec->level    = evt->level;
+    rec->last_seq = evt->seq;
+    rec->last_us  = evt->confirm_us;
+    rec->transitions++;
+    portEXIT_CRITICAL_SAFE(&s_coalesce_lock);
+}
+
+bool gpio_event_coalesce_take(gpio_event_coalesced_t *out) {
+    for (int word = 0; word < 2; word++) {
+        uint32_t dirty = atomic_load_explicit(&gpio_event_coalesce_dirty[word], memory_order_acquire);
+        if (!dirty) {
+            continue;
+        }
+        int pin = word * 32 + __builtin_ctz(dirty);
+
+        portENTER_CRITICAL(&s_coalesce_lock);
+        *out = s_records[pin];
+        atomic_fetch_and_explicit(&gpio_event_coalesce_dirty[word], ~(1u << (pin & 31)),
+                                  memory_order_release);
+        portEXIT_CRITICAL(&s_coalesce_lock);
+        return true;
+    }
+    return false;
+}
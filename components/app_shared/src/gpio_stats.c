@@ -0,0 +1,73 @@
+#include "pin_hal.h"
+#include "gpio_stats.h"
+
+gpio_stats_core_t gpio_stats_cores[portNUM_PROCESSORS];
+
+static int64_t s_since_us = 0;
+
+static const char *const s_pin_names[GPIO_PIN_STAT_COUNT] = {
+    "edges", "bursts", "events", "suppressed", "chatter", "dropped",
+};
+
+static const char *const s_stage_names[GPIO_STAGE_STAT_COUNT] = {
+    "isr", "wheel_ticks", "wheel_expired", "sampler_ticks", "posted",
+    "coalesced", "dropped", "consumed", "published", "publish_failed",
+};
+
+static inline uint32_t take(_Atomic uint32_t *counter, bool reset) {
+    return reset ? atomic_exchange_explicit(counter, 0, memory_order_relaxed)
+                 : atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+void gpio_stats_snapshot(gpio_stats_snapshot_t *out, bool reset) {
+    *out = (gpio_stats_snapshot_t){0};
+    out->since_us = s_since_us;
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        gpio_stats_core_t *c = &gpio_stats_cores[core];
+        for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+            for (int i = 0; i < GPIO_PIN_STAT_COUNT; i++) {
+                out->pin[pin][i] += take(&c->pin[pin][i], reset);
+            }
+        }
+        for (int i = 0; i < GPIO_STAGE_STAT_COUNT; i++) {
+            out->stage[i] += take(&c->stage[i], reset);
+        }
+        for (int i = 0; i < GPIO_STATS_MAX_LANES; i++) {
+            uint32_t hwm = take(&c->ring_hwm[i], reset);
+            if (hwm > out->ring_hwm[i]) {
+                out->ring_hwm[i] = hwm;
+            }
+        }
+    }
+
+    if (reset) {
+        s_since_us = pin_hal_time_us();
+    }
+}
+
+void gpio_stats_reset(void) {
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        gpio_stats_core_t *c = &gpio_stats_cores[core];
+        for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+            for (int i = 0; i < GPIO_PIN_STAT_COUNT; i++) {
+                atomic_store_explicit(&c->pin[pin][i], 0, memory_order_relaxed);
+            }
+        }
+        for (int i = 0; i < GPIO_STAGE_STAT_COUNT; i++) {
+            atomic_store_explicit(&c->stage[i], 0, memory_order_relaxed);
+        }
+        for (int i = 0; i < GPIO_STATS_MAX_LANES; i++) {
+            atomic_store_explicit(&c->ring_hwm[i], 0, memory_order_relaxed);
+        }
+    }
+    s_since_us = pin_hal_time_us();
+}
+
+const char *gpio_stats_pin_stat_name(gpio_pin_stat_t stat) {
+    return (unsigned)stat < GPIO_PIN_STAT_COUNT ? s_pin_names[stat] : "?";
+}
+
+const char *gpio_stats_stage_stat_name(gpio_stage_stat_t stat) {
+    return (unsigned)stat < GPIO_STAGE_STAT_COUNT ? s_stage_names[stat] : "?";
+}
@@ -0,0 +1,122 @@
+#include <string.h>
+#include "pin_hal_types.h"
+#include "latency_hist.h"
+
+#define SUB_COUNT (1u << LATENCY_HIST_SUB_BITS)
+
+static inline unsigned bucket_of(uint32_t us) {
+    if (us < SUB_COUNT) {
+        return us;
+    }
+    unsigned msb = 31 - __builtin_clz(us);
+    unsigned idx = ((msb - LATENCY_HIST_SUB_BITS + 1) << LATENCY_HIST_SUB_BITS) +
+                   ((us >> (msb - LATENCY_HIST_SUB_BITS)) & (SUB_COUNT - 1));
+    return idx < LATENCY_HIST_BUCKETS ? idx : LATENCY_HIST_BUCKETS - 1;
+}
+
+// Exclusive upper bound of a bucket, so percentiles err on the slow side.
+static uint32_t bucket_upper_us(unsigned idx) {
+    if (idx < SUB_COUNT) {
+        return idx + 1;
+    }
+    unsigned shift = (idx >> LATENCY_HIST_SUB_BITS) - 1;
+    unsigned sub = idx & (SUB_COUNT - 1);
+    return (SUB_COUNT + sub + 1) << shift;
+}
+
+void latency_hist_record(latency_hist_t *hist, uint32_t us) {
+    unsigned idx = bucket_of(us);
+    if (hist->buckets[idx] < UINT16_MAX) {
+        hist->buckets[idx]++;
+        hist->count++;
+    }
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t per_mille) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * per_mille + 999) / 1000);
+    uint32_t seen = 0;
+    for (unsigned idx = 0; idx < LATENCY_HIST_BUCKETS; idx++) {
+        seen += hist->buckets[idx];
+        if (seen >= rank) {
+            uint32_t upper = bucket_upper_us(idx);
+            return upper < hist->max_us ? upper : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+#if CONFIG_APP_LATENCY_HIST
+
+static latency_hist_t s_hist[CONFIG_APP_LATENCY_HIST_PINS][GPIO_LAT_STAGE_COUNT];
+static int8_t s_slot_of[GPIO_NUM_MAX];  // Slot + 1, 0 = none
+static int s_slots_used = 0;
+
+static latency_hist_t *hist_for(int pin, gpio_lat_stage_t stage, bool assign) {
+    if (pin < 0 || pin >= GPIO_NUM_MAX || (unsigned)stage >= GPIO_LAT_STAGE_COUNT) {
+        return NULL;
+    }
+    if (!s_slot_of[pin]) {
+        if (!assign || s_slots_used >= CONFIG_APP_LATENCY_HIST_PINS) {
+            return NULL;
+        }
+        s_slot_of[pin] = (int8_t)(++s_slots_used);
+    }
+    return &s_hist[s_slot_of[pin] - 1][stage];
+}
+
+void gpio_latency_record(int pin, gpio_lat_stage_t stage, uint32_t us) {
+    latency_hist_t *hist = hist_for(pin, stage, true);
+    if (hist) {
+        latency_hist_record(hist, us);
+    }
+}
+
+bool gpio_latency_summary(int pin, gpio_lat_stage_t stage, gpio_latency_summary_t *out) {
+    const latency_hist_t *hist = hist_for(pin, stage, false);
+    if (!hist || hist->count == 0) {
+        return false;
+    }
+    out->count   = hist->count;
+    out->p50_us  = latency_hist_percentile(hist, 500);
+    out->p99_us  = latency_hist_percentile(hist, 990);
+    out->p999_us = latency_hist_percentile(hist, 999);
+    out->max_us  = hist->max_us;
+    return true;
+}
+
+void gpio_latency_reset(void) {
+    memset(s_hist, 0, sizeof(s_hist));
+}
+
+#else
+
+void gpio_latency_record(int pin, gpio_lat_stage_t stage, uint32_t us) {
+    (void)pin;
+    (void)stage;
+    (void)us;
+}
+
+bool gpio_latency_summary(int pin, gpio_lat_stage_t stage, gpio_latency_summary_t *out) {
+    (void)pin;
+    (void)stage;
+    (void)out;
+    return false;
+}
+
+void gpio_latency_reset(void) {
+}
+
+#endif // CONFIG_APP_LATENCY_HIST
+
+const char *gpio_latency_stage_name(gpio_lat_stage_t stage) {
+    static const char *const names[GPIO_LAT_STAGE_COUNT] = {
+        "confirm", "dequeue", "publish", "total",
+    };
+    return (unsigned)stage < GPIO_LAT_STAGE_COUNT ? names[stage] : "?";
+}
@@ -1,26 +1,433 @@
 #pragma once
 
-#include "driver/gpio.h"
+#include <stddef.h>
+#include "esp_err.h"
+#include "pin_hal_types.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/// @brief Debounce engine used for a pin.
+/// DEBOUNCE_ENGINE_TIMER arms a one-shot timer from the GPIO interrupt on every edge.
+/// DEBOUNCE_ENGINE_SAMPLED has no interrupt: the GPIO input registers are sampled on a
+/// periodic tick and all sampled pins are debounced at once with vertical counters.
+/// DEBOUNCE_ENGINE_PCNT hands the pin to a hardware pulse counter unit
+/// (CONFIG_DEBOUNCE_PCNT): no CPU work per pulse, the glitch filter replaces the
+/// debounce window, and counts and rates are reported once per window instead of
+/// levels per edge. There are PIN_HAL_PCNT_UNITS units.
+/// DEBOUNCE_ENGINE_ENCODER decodes a quadrature encoder on pin (A) and encoder_b_pin (B)
+/// with a pulse counter unit (x4, up when A leads B). The position is extended to
+/// 64 bits and reported with its velocity once per window, or as soon as it has moved
+/// by encoder_threshold counts since the last report.
+/// DEBOUNCE_ENGINE_PWM timestamps both edges of a PWM or tachometer signal with an MCPWM
+/// capture channel (CONFIG_DEBOUNCE_PWM) at the capture timer's resolution (the APB clock),
+/// so interrupt latency does not show in the figures. Period, high time and duty cycle are
+/// reported as min/mean/max once per window. There are
+/// PIN_HAL_CAP_GROUPS * PIN_HAL_CAP_CHANNELS channels.
+/// DEBOUNCE_ENGINE_BURST records short serial bursts (Wiegand, IR remotes) with an RMT
+/// receive channel per line (CONFIG_DEBOUNCE_BURST): the peripheral stores every level and
+/// its duration without CPU work, the interrupt only fires at the end of a burst, and the
+/// pin's decoder (debounce_decoder.h) turns the bursts into frames, which are reported
+/// instead of edges. There are PIN_HAL_RMT_RX_CHANNELS channels.
+typedef enum {
+    DEBOUNCE_ENGINE_TIMER = 0,
+    DEBOUNCE_ENGINE_SAMPLED,
+    DEBOUNCE_ENGINE_PCNT,
+    DEBOUNCE_ENGINE_ENCODER,
+    DEBOUNCE_ENGINE_PWM,
+    DEBOUNCE_ENGINE_BURST,
+} debounce_engine_t;
+
+struct debounce_decoder;
+
+/// @brief Where a DEBOUNCE_ENGINE_TIMER pin's expiry is handled.
+/// DEBOUNCE_DISPATCH_TASK runs it in the esp_timer task (default).
+/// DEBOUNCE_DISPATCH_ISR runs it straight from the timer interrupt and posts with
+/// gpio_event_post_from_isr(); requires CONFIG_DEBOUNCE_ISR_DISPATCH, otherwise it falls back to
+/// task dispatch.
+typedef enum {
+    DEBOUNCE_DISPATCH_TASK = 0,
+    DEBOUNCE_DISPATCH_ISR,
+    DEBOUNCE_DISPATCH_MAX,
+} debounce_dispatch_t;
+
+/// @brief How a DEBOUNCE_ENGINE_TIMER pin turns a burst of edges into a report.
+/// DEBOUNCE_POLICY_TRAILING reports the level once the pin has been quiet for
+/// debounce_time_us (default; one report per burst, at least one window late).
+/// DEBOUNCE_POLICY_LEADING reports the first edge of a burst immediately, from
+/// the GPIO interrupt, then ignores the pin until it has been quiet for
+/// debounce_time_us. If it settled on the other level meanwhile, that level is
+/// reported at the end of the lockout.
+/// DEBOUNCE_POLICY_ASYMMETRIC is trailing with separate windows: press_time_us
+/// when the pin leaves its idle level (HIGH with pull_up, LOW without) and
+/// release_time_us when it returns. A zero time falls back to debounce_time_us.
+typedef enum {
+    DEBOUNCE_POLICY_TRAILING = 0,
+    DEBOUNCE_POLICY_LEADING,
+    DEBOUNCE_POLICY_ASYMMETRIC,
+} debounce_policy_t;
+
 /// @brief 
 /// debounce_config_t is a structure that defines the configuration for a debounced GPIO pin.
 /// It includes fields for the pin number (pin), interrupt type (intr_type), pull-up configuration
 /// (pull_up), debounce time in microseconds (debounce_time_us), and an optional MQTT topic
-/// (mqtt_topic).
+/// (mqtt_topic). engine selects the debounce engine; for DEBOUNCE_ENGINE_SAMPLED the
+/// window is fixed at four sample ticks (CONFIG_DEBOUNCE_SAMPLE_PERIOD_US) and
+/// debounce_time_us is ignored, while intr_type still selects which edges are reported.
+/// dispatch picks task or ISR delivery for timer-engine pins.
+/// policy, press_time_us and release_time_us select the debounce policy of timer-engine pins.
+/// state_change_only tracks the last stable level of the pin and suppresses reports that
+/// would repeat it. Any policy other than trailing, or state_change_only, watches both edges
+/// in hardware so the level stays tracked; intr_type then only filters which levels are
+/// reported (POSEDGE: HIGH, NEGEDGE: LOW). The sampled engine is inherently state-change-only.
+/// adaptive lets the engine learn debounce_time_us from the bounce observed on the pin (see
+/// debounce_adapt_run()), between adapt_min_us (0: CONFIG_DEBOUNCE_ADAPT_MIN_US) and
+/// adapt_max_us (0: the configured debounce_time_us). Asymmetric press/release times left at
+/// zero follow the learned window.
+/// For DEBOUNCE_ENGINE_PCNT, intr_type selects the counted edges (POSEDGE, NEGEDGE or ANYEDGE),
+/// count_window_ms the reporting period (0: CONFIG_DEBOUNCE_PCNT_WINDOW_MS) and glitch_ns the
+/// filter width (0: CONFIG_DEBOUNCE_PCNT_GLITCH_NS; at most about 12.7us on the ESP32-S3);
+/// debounce_time_us and the policy fields are ignored.
+/// DEBOUNCE_ENGINE_ENCODER uses count_window_ms and glitch_ns the same way, pull_up for both
+/// inputs, encoder_b_pin for the B input (required, and must not be registered itself) and
+/// encoder_threshold (0: reports per window only).
+/// DEBOUNCE_ENGINE_PWM uses count_window_ms as its window (0: CONFIG_DEBOUNCE_PWM_WINDOW_MS)
+/// and pull_up; the edges, debounce and policy fields are ignored.
+/// DEBOUNCE_ENGINE_BURST requires decoder, takes the second line of a two-line protocol
+/// (Wiegand D1) from burst_b_pin, which must not be registered itself, and uses pull_up for
+/// both; the edges, debounce and policy fields are ignored.
+/// encoder_b_pin and burst_b_pin have no default: 0, the value a designated initialiser
+/// leaves, is refused with ESP_ERR_INVALID_ARG (GPIO 0 is a strapping pin).
 typedef struct {
     gpio_num_t pin;
     gpio_int_type_t intr_type;
     bool pull_up;
     uint32_t debounce_time_us;
     const char* mqtt_topic;
+    debounce_engine_t engine;
+    debounce_dispatch_t dispatch;
+    debounce_policy_t policy;
+    uint32_t press_time_us;
+    uint32_t release_time_us;
+    bool state_change_only;
+    bool adaptive;
+    uint32_t adapt_min_us;
+    uint32_t adapt_max_us;
+    uint32_t count_window_ms;
+    uint32_t glitch_ns;
+    gpio_num_t encoder_b_pin;
+    uint32_t encoder_threshold;
+    const struct debounce_decoder *decoder;
+    gpio_num_t burst_b_pin;
 } debounce_config_t;
 
+/// @brief One reporting window of a DEBOUNCE_ENGINE_PCNT pin.
+/// total is extended to 64 bits across counter wraps and never goes backwards;
+/// rate_milli_hz is delta per second over the window, times 1000.
+typedef struct {
+    uint64_t total;           // Pulses since registration, at the end of the window
+    uint32_t delta;           // Pulses in the window
+    uint32_t rate_milli_hz;
+    int64_t  window_start_us; // pin_hal time
+    uint32_t window_us;
+} debounce_count_t;
+
+/// @brief One position report of a DEBOUNCE_ENGINE_ENCODER pin.
+/// position is extended to 64 bits and zero at registration; velocity is delta
+/// over the time since the previous report.
+typedef struct {
+    int64_t  position;        // Counts, x4 decoded
+    int32_t  delta;           // Counts since the previous report
+    int32_t  velocity;        // Counts per second
+    int64_t  since_us;        // pin_hal time of the previous report (or registration)
+    uint32_t interval_us;     // Time since then
+} debounce_position_t;
+
+/// @brief One window of a DEBOUNCE_ENGINE_PWM pin.
+/// A cycle runs from a rising edge to the next one and its high time up to the
+/// falling edge in between; a cycle with a missed edge is dropped. Times are
+/// rounded to ns from capture timer ticks (12.5ns at 80 MHz) and cycles longer
+/// than CONFIG_DEBOUNCE_PWM_MAX_PERIOD_MS are not measured. Duty cycles are in
+/// basis points (10000 = always high): min and max per cycle, mean as the total
+/// high time over the total period. With no cycle in the window only level is
+/// meaningful and duty_mean_bp is 0 or 10000 to match it.
+typedef struct {
+    uint32_t cycles;          // Complete cycles in the window
+    uint32_t period_min_ns;
+    uint32_t period_mean_ns;
+    uint32_t period_max_ns;
+    uint32_t high_min_ns;
+    uint32_t high_mean_ns;
+    uint32_t high_max_ns;
+    uint16_t duty_min_bp;
+    uint16_t duty_mean_bp;
+    uint16_t duty_max_bp;
+    uint8_t  level;           // Pin level at the end of the window
+    int64_t  window_start_us; // pin_hal time
+    uint32_t window_us;
+} debounce_pwm_t;
+
+/// @brief One decoded frame of a DEBOUNCE_ENGINE_BURST pin.
+/// data holds the bits as laid out by the decoder (by default in the order
+/// received, MSB first within each byte; see debounce_decoder.h) and valid is
+/// its verdict on parity or checksum. Bursts in which the decoder found no
+/// frame of its protocol are dropped.
+typedef struct {
+    const char *protocol;     // Decoder name
+    uint16_t    bits;
+    bool        valid;
+    uint8_t     data[16];
+    int64_t     start_us;     // pin_hal time of the first edge
+    uint32_t    duration_us;  // First to last edge
+} debounce_frame_t;
+
+/// @brief Edge-to-enqueue latency for one dispatch mode.
+/// Measured from the last edge of a burst to the moment its event is queued.
+/// The overshoot figures subtract the pin's debounce window, leaving the delay
+/// added by tick granularity and dispatch. Leading-edge reports made from the
+/// GPIO interrupt are not counted.
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t overshoot_min_us;
+    uint32_t overshoot_max_us;
+    uint64_t overshoot_sum_us;
+} debounce_latency_stats_t;
+
 void debounce_init(void);
-void debounce_register_pin(const debounce_config_t* config);
+
+/**
+ * @brief Register a pin for debouncing.
+ *
+ * Pins are stored in a table indexed by GPIO number, so any valid GPIO of the
+ * SoC can be registered and lookups from the ISR are O(1). With
+ * CONFIG_DEBOUNCE_TPL, timer-engine pins run on the C++ Debouncer template.
+ *
+ * @param config Pin configuration (copied)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an invalid GPIO or a
+ *         missing B input, ESP_ERR_INVALID_STATE if the pin is already registered,
+ *         ESP_ERR_NO_MEM if its template instance is full
+ */
+esp_err_t debounce_register_pin(const debounce_config_t* config);
+
+/**
+ * @brief Register a table of pins at once.
+ *
+ * All entries are validated before anything is touched, every GPIO is
+ * configured with a single gpio_config() call, then each pin's interrupt is
+ * enabled and it is attached as by debounce_register_pin(). Pin tables are
+ * usually declared with the DEBOUNCE_TABLE_* macros of debounce_table.h.
+ *
+ * @param configs Pin configurations (copied)
+ * @param count   Number of entries
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an invalid or repeated
+ *         GPIO, ESP_ERR_INVALID_STATE if a pin is already registered. On any
+ *         failure no pin of the table stays registered.
+ */
+esp_err_t debounce_register_pins(const debounce_config_t* configs, size_t count);
+
+/**
+ * @brief Remove a pin from debouncing.
+ *
+ * Detaches the ISR, cancels any pending debounce timer and frees the slot.
+ * Safe to call while other pins keep interrupting.
+ *
+ * @param pin GPIO to remove
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the pin is not registered
+ */
+esp_err_t debounce_unregister_pin(gpio_num_t pin);
+
+/**
+ * @brief Change the configuration of a registered pin in place.
+ *
+ * Interrupt type, pull-up, debounce time and topic are applied while the
+ * pin stays live; an edge racing the update sees either the old or the new
+ * settings, never a mix.
+ *
+ * @param config New configuration; config->pin selects the pin
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the pin is not registered
+ */
+esp_err_t debounce_update_pin(const debounce_config_t* config);
+
+/**
+ * @brief Re-tune the windows of adaptive pins.
+ *
+ * For each adaptive timer-engine pin with enough samples, takes the
+ * CONFIG_DEBOUNCE_ADAPT_PERCENTILE of its bounce durations, adds
+ * CONFIG_DEBOUNCE_ADAPT_MARGIN_PCT, clamps to the pin's bounds and applies the
+ * result if it moved by more than 10%. Changed windows are saved to NVS
+ * (namespace "debounce") and restored on the next registration.
+ *
+ * Call periodically from a task; it may write flash. No-op without
+ * CONFIG_DEBOUNCE_ADAPTIVE.
+ */
+void debounce_adapt_run(void);
+
+/**
+ * @brief MQTT topic configured for a registered pin, or NULL.
+ */
+const char *debounce_get_topic(gpio_num_t pin);
+
+/**
+ * @brief Last finished window of a pulse counter pin.
+ *
+ * Each window also posts a GPIO_EVENT_COUNT event whose edge_us is the low 32
+ * bits of window_start_us; a consumer that fell behind by a window sees a
+ * newer start here and can skip the stale event.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the pin is not a registered
+ *         DEBOUNCE_ENGINE_PCNT pin, ESP_ERR_INVALID_STATE before its first
+ *         window closed
+ */
+esp_err_t debounce_get_count(gpio_num_t pin, debounce_count_t *out);
+
+/**
+ * @brief Latest report of an encoder pin (pin is its A input).
+ *
+ * Each report also posts a GPIO_EVENT_POSITION event whose edge_us is the low
+ * 32 bits of since_us, so a stale event can be told apart as for
+ * debounce_get_count().
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the pin is not a registered
+ *         DEBOUNCE_ENGINE_ENCODER pin, ESP_ERR_INVALID_STATE before its first
+ *         report
+ */
+esp_err_t debounce_get_position(gpio_num_t pin, debounce_position_t *out);
+
+/**
+ * @brief Last finished window of a PWM capture pin.
+ *
+ * Each window also posts a GPIO_EVENT_PWM event whose edge_us is the low 32
+ * bits of window_start_us, so a stale event can be told apart as for
+ * debounce_get_count().
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the pin is not a registered
+ *         DEBOUNCE_ENGINE_PWM pin, ESP_ERR_INVALID_STATE before its first
+ *         window closed
+ */
+esp_err_t debounce_get_pwm(gpio_num_t pin, debounce_pwm_t *out);
+
+/**
+ * @brief Last decoded frame of a burst pin.
+ *
+ * Each frame also posts a GPIO_EVENT_FRAME event whose edge_us is the low 32
+ * bits of start_us, so a stale event can be told apart as for
+ * debounce_get_count().
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the pin is not a registered
+ *         DEBOUNCE_ENGINE_BURST pin, ESP_ERR_INVALID_STATE before its first
+ *         frame
+ */
+esp_err_t debounce_get_frame(gpio_num_t pin, debounce_frame_t *out);
+
+/**
+ * @brief Read edge-to-enqueue latency measured for a dispatch mode.
+ *
+ * @param dispatch Mode to query
+ * @param out      Receives a consistent copy of the counters
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for a bad mode or NULL out
+ */
+esp_err_t debounce_get_latency_stats(debounce_dispatch_t dispatch, debounce_latency_stats_t* out);
+
+/**
+ * @brief Log latency for both dispatch modes and ISR drops, and optionally reset the counters.
+ */
+void debounce_log_latency_stats(bool reset);
+
+/**
+ * @brief Start recording raw edges (CONFIG_DEBOUNCE_CAPTURE).
+ *
+ * Every GPIO interrupt of a pin in pin_mask is logged with its timestamp and
+ * the level read in the interrupt, before any debouncing, into a RAM ring of
+ * 2^CONFIG_DEBOUNCE_CAPTURE_DEPTH_LOG2 records. When the ring is full the
+ * oldest records are folded into the starting levels, so the ring always
+ * holds the latest edges. Starting clears the previous capture. Only
+ * interrupt-driven (timer engine) pins have edges to record.
+ *
+ * @param pin_mask Bit n selects GPIO n
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for an empty mask,
+ *         ESP_ERR_NOT_SUPPORTED without CONFIG_DEBOUNCE_CAPTURE
+ */
+esp_err_t debounce_capture_start(uint64_t pin_mask);
+
+/**
+ * @brief Stop recording; the capture stays available for export.
+ */
+void debounce_capture_stop(void);
+
+/**
+ * @brief Upper bound of the exported size of the current capture, in bytes.
+ */
+size_t debounce_capture_export_size(void);
+
+/**
+ * @brief Serialise the stopped capture.
+ *
+ * Format (version 1, little-endian):
+ *  - header, 28 bytes: "DBCP", u8 version, u8 pin count, u16 reserved,
+ *    u32 edge count, u32 edges lost to overwrite, u32 start time (low 32
+ *    bits of the microsecond clock), u64 levels at the start time
+ *  - one 20-byte entry per captured registered pin: u8 pin, engine, policy,
+ *    intr_type, flags (bit0 pull_up, bit1 state_change_only, bit2 adaptive),
+ *    dispatch, u16 reserved, u32 debounce_time_us, press_time_us,
+ *    release_time_us
+ *  - edges: u8 (pin | level << 7) followed by the time since the previous
+ *    edge (the start time for the first) as an unsigned LEB128 varint
+ *
+ * @param buf     Destination
+ * @param len     Size of buf; debounce_capture_export_size() always suffices
+ * @param out_len Receives the number of bytes written
+ * @return ESP_OK, ESP_ERR_INVALID_STATE while recording,
+ *         ESP_ERR_INVALID_SIZE if buf is too small, ESP_ERR_NOT_SUPPORTED
+ *         without CONFIG_DEBOUNCE_CAPTURE
+ */
+esp_err_t debounce_capture_export(uint8_t *buf, size_t len, size_t *out_len);
+
+/// @brief Called once the last captured edge has been replayed.
+typedef void (*debounce_replay_done_cb_t)(void *arg);
+
+/// @brief Replay of an exported capture.
+/// pin_map, if set, holds one entry per GPIO number giving the pin each
+/// captured pin is replayed on (GPIO_NUM_NC skips it); NULL replays on the
+/// captured pins. Replay pins must not be registered: replay drives them as
+/// outputs looped back into their own input, registers them with the captured
+/// configuration (adaptive learning off, no topic) and reproduces every edge
+/// at its captured offset from the replay start. Nothing else may be wired to
+/// them. On the linux target the timing is exact, so the engine makes the
+/// same decisions as during capture; on a device it is as good as the
+/// one-shot timer.
+typedef struct {
+    const uint8_t            *data;
+    size_t                    len;
+    const gpio_num_t         *pin_map;
+    debounce_replay_done_cb_t done;
+    void                     *done_arg;
+} debounce_replay_config_t;
+
+/**
+ * @brief Parse a capture and start replaying it.
+ *
+ * The capture is decoded up front; data need not outlive this call.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for a malformed capture,
+ *         ESP_ERR_INVALID_STATE if a replay is running or a replay pin is
+ *         registered, ESP_ERR_NO_MEM, ESP_ERR_NOT_SUPPORTED without
+ *         CONFIG_DEBOUNCE_CAPTURE
+ */
+esp_err_t debounce_replay_start(const debounce_replay_config_t *config);
+
+/**
+ * @brief Stop a replay (finished or not) and release its pins.
+ */
+void debounce_replay_stop(void);
+
+/**
+ * @brief True while captured edges are still being replayed.
+ */
+bool debounce_replay_active(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,249 @@
+#pragma once
+
+/**
+ * Header-only C++ debounce engine, specialised at compile time.
+ *
+ *     debounce::Debouncer<debounce::Trailing, debounce::PinHalClock, 4> buttons;
+ *     buttons.add(GPIO_NUM_4, 20000, initial_level);
+ *     // GPIO ISR:   debounce::Report r; if (buttons.edge(pin, level, r)) { ... }
+ *     // task/tick:  buttons.poll([](const debounce::Report &r) { ... });
+ *
+ * Policy picks how a burst of edges becomes a report (Trailing, Leading,
+ * Asymmetric), Clock supplies microseconds through a static now_us() (the
+ * pin_hal clock on target and on the simulator, ManualClock in host tests and
+ * benchmarks) and N fixes the number of pins. Storage is a fixed array, the
+ * policy hooks are static and inline, and there is no virtual dispatch, so
+ * every board gets code for exactly the policies it instantiates.
+ *
+ * Every policy reports state changes only (like state_change_only of the C
+ * engine). The engine does not touch GPIO: the caller feeds edges, with the
+ * level read in the interrupt, and calls poll() often enough for its
+ * resolution. Lock guards edge() against poll() when they run in different
+ * contexts; NoLock is enough when both run on one task or in a host loop.
+ *
+ * With CONFIG_DEBOUNCE_TPL, debounce_register_pin() runs timer-engine pins on
+ * one instance per policy (debounce_tpl.cpp).
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "freertos/FreeRTOS.h"
+#include "debounce.h"
+#include "pin_hal.h"
+
+// Hot paths are forced inline so an IRAM_ATTR caller keeps them in IRAM.
+#define DEBOUNCE_HOT __attribute__((always_inline)) inline
+
+namespace debounce {
+
+/// A confirmed level.
+struct Report {
+    gpio_num_t pin;
+    uint8_t    level;
+    int64_t    edge_us;     // First edge of the burst
+    int64_t    confirm_us;  // When the level was confirmed
+};
+
+/// Per-pin state, shared by all policies.
+struct Slot {
+    int64_t    first_edge_us;
+    int64_t    deadline_us;
+    uint32_t   press_us;    // Window; for Asymmetric, when leaving the idle level
+    uint32_t   release_us;  // Asymmetric: when returning to the idle level
+    gpio_num_t pin;
+    uint8_t    stable;      // Last reported level
+    uint8_t    level;       // Level at the latest edge
+    uint8_t    idle;        // Asymmetric: level with no input (HIGH with pull-up)
+};
+
+// ---- Clocks ----
+
+/// pin_hal time: esp_timer on target, virtual time on the linux simulator.
+struct PinHalClock {
+    DEBOUNCE_HOT static int64_t now_us() { return pin_hal_time_us(); }
+};
+
+/// Clock set by hand, for host tests and benchmarks.
+struct ManualClock {
+    static inline int64_t t_us = 0;
+    static int64_t now_us() { return t_us; }
+};
+
+// ---- Locks ----
+
+struct NoLock {
+    void lock() {}
+    void unlock() {}
+};
+
+/// Spinlock usable from task and ISR, for edge() in the GPIO ISR and poll() in a task.
+struct PortMuxLock {
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    DEBOUNCE_HOT void lock() { portENTER_CRITICAL_SAFE(&mux); }
+    DEBOUNCE_HOT void unlock() { portEXIT_CRITICAL_SAFE(&mux); }
+};
+
+// ---- Policies ----
+// on_edge() runs for every edge of an armed or idle pin and returns true to
+// report at once; on_expire() runs once the deadline passed and returns true
+// to report. Both leave the deadline in s.deadline_us; pending is tracked by
+// the engine.
+
+/// Report once the pin has been quiet for the window.
+struct Trailing {
+    DEBOUNCE_HOT static bool on_edge(Slot &s, int64_t now_us, bool /*pending*/) {
+        s.deadline_us = now_us + s.press_us;
+        return false;
+    }
+    DEBOUNCE_HOT static bool on_expire(Slot &s) { return s.level != s.stable; }
+};
+
+/// Report the first edge of a burst at once, then ignore the pin until it has
+/// been quiet for the window; report the level it settled on if it differs.
+struct Leading {
+    DEBOUNCE_HOT static bool on_edge(Slot &s, int64_t now_us, bool pending) {
+        s.deadline_us = now_us + s.press_us;
+        return !pending && s.level != s.stable;
+    }
+    DEBOUNCE_HOT static bool on_expire(Slot &s) { return s.level != s.stable; }
+};
+
+/// Trailing with separate press (leaving idle) and release windows.
+struct Asymmetric {
+    DEBOUNCE_HOT static bool on_edge(Slot &s, int64_t now_us, bool /*pending*/) {
+        s.deadline_us = now_us + (s.level != s.idle ? s.press_us : s.release_us);
+        return false;
+    }
+    DEBOUNCE_HOT static bool on_expire(Slot &s) { return s.level != s.stable; }
+};
+
+// ---- Engine ----
+
+template <class Policy, class Clock, std::size_t N, class Lock = NoLock>
+class Debouncer {
+    static_assert(N > 0 && N <= 64, "pending pins are tracked in one 64-bit word");
+
+public:
+    static constexpr std::size_t capacity = N;
+    static constexpr int64_t     never = std::numeric_limits<int64_t>::max();
+
+    Debouncer() { index_.fill(-1); }
+
+    /**
+     * Add a pin at its current level. release_us only matters for
+     * Asymmetric (0: same as window_us). Returns false if the pin is
+     * invalid, already added or the engine is full.
+     */
+    bool add(gpio_num_t pin, uint32_t window_us, int level, uint32_t release_us = 0,
+             bool idle_high = false) {
+        if (!GPIO_IS_VALID_GPIO(pin) || index_[pin] >= 0 || used_ == full_mask()) {
+            return false;
+        }
+        std::size_t i = static_cast<std::size_t>(__builtin_ctzll(~used_));
+        slots_[i] = Slot{};
+        slots_[i].pin = pin;
+        slots_[i].press_us = window_us;
+        slots_[i].release_us = release_us ? release_us : window_us;
+        slots_[i].stable = slots_[i].level = static_cast<uint8_t>(level != 0);
+        slots_[i].idle = idle_high;
+        lock_.lock();
+        used_ |= bit(i);
+        index_[pin] = static_cast<int8_t>(i);
+        lock_.unlock();
+        return true;
+    }
+
+    bool remove(gpio_num_t pin) {
+        if (!GPIO_IS_VALID_GPIO(pin) || index_[pin] < 0) {
+            return false;
+        }
+        lock_.lock();
+        std::size_t i = static_cast<std::size_t>(index_[pin]);
+        used_ &= ~bit(i);
+        pending_ &= ~bit(i);
+        index_[pin] = -1;
+        lock_.unlock();
+        return true;
+    }
+
+    /**
+     * Feed one edge of a pin with the level read for it. Callable from ISR
+     * with a suitable Lock. Returns true and fills out if the policy reports
+     * this edge at once.
+     */
+    DEBOUNCE_HOT bool edge(gpio_num_t pin, int level, Report &out) {
+        if (!GPIO_IS_VALID_GPIO(pin)) {
+            return false;
+        }
+        int64_t now_us = Clock::now_us();
+        lock_.lock();
+        int idx = index_[pin];
+        if (idx < 0) {
+            lock_.unlock();
+            return false;
+        }
+        Slot &s = slots_[static_cast<std::size_t>(idx)];
+        bool pending = (pending_ & bit(static_cast<std::size_t>(idx))) != 0;
+        if (!pending) {
+            s.first_edge_us = now_us;
+        }
+        s.level = static_cast<uint8_t>(level != 0);
+        bool now = Policy::on_edge(s, now_us, pending);
+        pending_ |= bit(static_cast<std::size_t>(idx));
+        if (now) {
+            s.stable = s.level;
+            out = Report{ s.pin, s.level, s.first_edge_us, now_us };
+        }
+        lock_.unlock();
+        return now;
+    }
+
+    /**
+     * Expire every deadline that has passed, calling sink(const Report &) for
+     * each report. Returns the earliest deadline still pending, or never.
+     */
+    template <class Sink>
+    DEBOUNCE_HOT int64_t poll(Sink &&sink) {
+        int64_t now_us = Clock::now_us();
+        int64_t next = never;
+        lock_.lock();
+        for (uint64_t pending = pending_; pending; pending &= pending - 1) {
+            std::size_t i = static_cast<std::size_t>(__builtin_ctzll(pending));
+            Slot &s = slots_[i];
+            if (s.deadline_us > now_us) {
+                next = s.deadline_us < next ? s.deadline_us : next;
+                continue;
+            }
+            pending_ &= ~bit(i);
+            if (Policy::on_expire(s)) {
+                s.stable = s.level;
+                Report r{ s.pin, s.level, s.first_edge_us, now_us };
+                lock_.unlock();
+                sink(r);
+                lock_.lock();
+            }
+        }
+        lock_.unlock();
+        return next;
+    }
+
+    /// Last reported level of a pin, or -1 if it is not added.
+    int level(gpio_num_t pin) const {
+        return GPIO_IS_VALID_GPIO(pin) && index_[pin] >= 0
+               ? slots_[static_cast<std::size_t>(index_[pin])].stable : -1;
+    }
+
+private:
+    static constexpr uint64_t bit(std::size_t i) { return 1ULL << i; }
+    static constexpr uint64_t full_mask() { return N == 64 ? ~0ULL : (1ULL << N) - 1; }
+
+    std::array<Slot, N>              slots_{};
+    std::array<int8_t, GPIO_NUM_MAX> index_{};  // GPIO -> slot, -1 if not added
+    uint64_t                         used_ = 0;
+    uint64_t                         pending_ = 0;
+    Lock                             lock_{};
+};
+
+} // namespace debounce
@@ -0,0 +1,70 @@
+#pragma once
+
+/**
+ * Protocol decoders for DEBOUNCE_ENGINE_BURST pins.
+ *
+ * The burst engine collects the edges of one frame from every line of a pin,
+ * merged in time order, and hands them to the pin's decoder once no line has
+ * received anything for frame_gap_us:
+ *
+ *     static const debounce_config_t reader = {
+ *         .pin = GPIO_NUM_10, .burst_b_pin = GPIO_NUM_11, .pull_up = true,
+ *         .engine = DEBOUNCE_ENGINE_BURST, .decoder = &debounce_decoder_wiegand,
+ *     };
+ *
+ * A decoder is a const table, so a board adds a protocol by defining its own
+ * debounce_decoder_t next to its pin table; nothing needs registering.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "debounce.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief One edge of a frame.
+typedef struct {
+    uint32_t t_us;   // Since the first edge of the frame
+    uint8_t  line;   // 0: pin, 1: burst_b_pin
+    uint8_t  level;  // Level after the edge
+} debounce_edge_t;
+
+/**
+ * @brief A protocol the burst engine can decode.
+ *
+ * min_pulse_ns is the RMT glitch filter (at most about 3.1us); a burst ends
+ * once its line has had no edge for idle_us (at most 32767), and a frame once
+ * no line has finished a burst for frame_gap_us. Times are only as accurate
+ * as the done interrupt between the bursts of different lines, and exact
+ * within one burst.
+ *
+ * decode runs in the timer task with the edges of one frame. It returns false
+ * if they hold no frame of the protocol (the frame is dropped), otherwise it
+ * fills bits, data and valid of out.
+ */
+typedef struct debounce_decoder {
+    const char *name;
+    uint8_t     lines;         // 1, or 2 with burst_b_pin
+    uint32_t    min_pulse_ns;
+    uint32_t    idle_us;
+    uint32_t    frame_gap_us;
+    bool      (*decode)(const debounce_edge_t *edges, size_t count, debounce_frame_t *out);
+} debounce_decoder_t;
+
+/// @brief Wiegand on D0 (pin) and D1 (burst_b_pin): a low pulse on D0 is a 0
+/// bit, on D1 a 1 bit. 26- and 34-bit frames are checked for their leading
+/// even and trailing odd parity; other lengths are reported as valid.
+extern const debounce_decoder_t debounce_decoder_wiegand;
+
+/// @brief NEC infrared from an active-low demodulating receiver: data is
+/// address, inverted address, command, inverted command, each byte sent LSB
+/// first; valid if the command checks against its inverse. A repeat code is
+/// reported as a 0-bit valid frame.
+extern const debounce_decoder_t debounce_decoder_nec;
+
+#ifdef __cplusplus
+}
+#endif
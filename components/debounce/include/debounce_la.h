@@ -0,0 +1,125 @@
+#pragma once
+
+/**
+ * Logic analyzer capture (CONFIG_DEBOUNCE_LA).
+ *
+ * Samples up to 16 pins together at a fixed rate through the parallel sampler
+ * (the camera interface and DMA on the ESP32-S3) and run-length encodes the
+ * samples on the fly, so idle stretches cost next to nothing. A capture is
+ * armed with a trigger and keeps about pre_samples of history before it; it
+ * ends post_samples after the trigger:
+ *
+ *     static const gpio_num_t pins[] = { GPIO_NUM_4, GPIO_NUM_5 };
+ *     static const debounce_la_config_t la = {
+ *         .pins = pins, .pin_count = 2, .clock_pin = GPIO_NUM_40,
+ *         .sample_hz = 1000000, .trigger_mask = 0x1, .trigger_value = 0x0,
+ *         .trigger_edge = true, .pre_samples = 10000, .post_samples = 100000,
+ *     };
+ *     debounce_la_arm(&la);
+ *
+ * The pins are tapped through the GPIO matrix, so debouncing and the raw edge
+ * capture of the same pins carry on unchanged while the analyzer runs.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "pin_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEBOUNCE_LA_MAX_PINS PIN_HAL_PAR_MAX_PINS
+
+typedef enum {
+    DEBOUNCE_LA_IDLE,       // Never armed
+    DEBOUNCE_LA_ARMED,      // Sampling, waiting for the trigger
+    DEBOUNCE_LA_TRIGGERED,  // Sampling the post-trigger samples
+    DEBOUNCE_LA_DONE,       // Stopped; the capture can be exported
+} debounce_la_state_t;
+
+/// @brief Called from the timer task once a capture has ended.
+typedef void (*debounce_la_done_cb_t)(void *arg);
+
+/**
+ * @brief Logic analyzer capture setup.
+ *
+ * Bit i of a sample, of trigger_mask and of trigger_value is pins[i]. The
+ * trigger fires on the first sample whose masked bits equal trigger_value; with
+ * trigger_edge the sample before must not have matched, so a pattern already
+ * present when arming does not count. A zero trigger_mask triggers at once.
+ */
+typedef struct {
+    const gpio_num_t     *pins;
+    size_t                pin_count;     // 1..DEBOUNCE_LA_MAX_PINS
+    gpio_num_t            clock_pin;     // Unused GPIO for the sample clock loopback
+    uint32_t              sample_hz;     // PIN_HAL_PAR_MIN_HZ..PIN_HAL_PAR_MAX_HZ
+    uint32_t              trigger_mask;
+    uint32_t              trigger_value;
+    bool                  trigger_edge;
+    uint32_t              pre_samples;
+    uint32_t              post_samples;
+    debounce_la_done_cb_t on_done;
+    void                 *arg;
+} debounce_la_config_t;
+
+typedef struct {
+    debounce_la_state_t state;
+    uint32_t            sample_hz;  // Actual rate
+    uint64_t            samples;    // Encoded so far
+    uint32_t            records;    // Run-length records held
+    bool                triggered;
+    bool                truncated;  // Record buffer filled before the post-trigger samples
+    bool                overrun;    // Encoder fell behind the DMA; the capture ended there
+} debounce_la_status_t;
+
+/**
+ * @brief Start a capture, replacing the previous one.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for a bad configuration,
+ *         ESP_ERR_INVALID_STATE while a capture is running, ESP_ERR_NO_MEM,
+ *         ESP_ERR_NOT_SUPPORTED without CONFIG_DEBOUNCE_LA
+ */
+esp_err_t debounce_la_arm(const debounce_la_config_t *config);
+
+/**
+ * @brief End a running capture now; it stays available for export. A capture
+ * stopped before its trigger is exported as untriggered.
+ */
+void debounce_la_stop(void);
+
+void debounce_la_get_status(debounce_la_status_t *out);
+
+/// @brief Sink for debounce_la_export(); returns ESP_OK to go on.
+typedef esp_err_t (*debounce_la_write_t)(const void *data, size_t len, void *ctx);
+
+/**
+ * @brief Exported size of the finished capture, in bytes; 0 if there is none.
+ */
+size_t debounce_la_export_size(void);
+
+/**
+ * @brief Serialise the finished capture through write, in a few calls.
+ *
+ * Format (version 1, little-endian):
+ *  - header, 40 bytes: "DBLA", u8 version, u8 pin count, u8 bytes per sample
+ *    (1 for up to 8 pins, else 2), u8 flags (bit0 triggered, bit1 truncated,
+ *    bit2 overrun), u32 sample rate in Hz, u32 record count, u64 sample
+ *    count, u64 trigger sample (from the first sample; the sample count if
+ *    untriggered), i64 microsecond clock at the first sample
+ *  - one byte per pin: its GPIO number, in bit order
+ *  - records, u32 each: the sample value in the top 8 bits per sample byte,
+ *    the number of samples it lasted (at least 1) in the rest
+ *
+ * tools/la_convert.py turns a capture into a VCD or sigrok file.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE without a finished capture, the
+ *         first error of write, ESP_ERR_NOT_SUPPORTED without CONFIG_DEBOUNCE_LA
+ */
+esp_err_t debounce_la_export(debounce_la_write_t write, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
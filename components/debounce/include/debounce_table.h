@@ -0,0 +1,65 @@
+#pragma once
+
+/**
+ * Compile-time pin tables for fixed board builds.
+ *
+ * A board lists its pins once as an X-macro. Each entry is a GPIO number, an
+ * MQTT topic string literal and any further debounce_config_t fields as
+ * designated initializers:
+ *
+ *     #define BOARD_PINS(X) \
+ *         X(4, "/board/button", .intr_type = GPIO_INTR_POSEDGE, .pull_up = true, \
+ *           .debounce_time_us = 50000, .policy = DEBOUNCE_POLICY_LEADING) \
+ *         X(5, "/board/door", .intr_type = GPIO_INTR_NEGEDGE, .debounce_time_us = 75000)
+ *
+ *     DEBOUNCE_TABLE_CHECK(BOARD_PINS)          // file scope; fails the build on bad entries
+ *     DEBOUNCE_TABLE_DEFINE(s_pins, BOARD_PINS) // static const debounce_config_t s_pins[]
+ *     debounce_register_pins(s_pins, DEBOUNCE_TABLE_COUNT(BOARD_PINS));
+ *
+ * DEBOUNCE_TABLE_CHECK rejects invalid GPIOs, pins listed twice and topics
+ * longer than DEBOUNCE_TOPIC_MAX. Write every pin the same way (always 4 or
+ * always GPIO_NUM_4) so repeats are caught, and check one table per file.
+ */
+
+#include "debounce.h"
+
+#define DEBOUNCE_TOPIC_MAX 64
+
+/// @brief Number of pins in a table.
+#define DEBOUNCE_TABLE_COUNT(table) (0 table(DEBOUNCE_TABLE_ONE_))
+
+/// @brief uint64_t mask with the bit of every pin in a table set.
+#define DEBOUNCE_TABLE_MASK(table)  (0ULL table(DEBOUNCE_TABLE_BIT_))
+
+/// @brief Braced initializer of a gpio_num_t array with the pins of a table.
+#define DEBOUNCE_TABLE_PINS(table)  { table(DEBOUNCE_TABLE_PIN_) }
+
+/// @brief Define a static const array of debounce_config_t from a table.
+#define DEBOUNCE_TABLE_DEFINE(name, table) \
+    static const debounce_config_t name[] = { table(DEBOUNCE_TABLE_ENTRY_) }
+
+/// @brief Compile-time checks of a table, at file scope.
+#define DEBOUNCE_TABLE_CHECK(table) \
+    table(DEBOUNCE_TABLE_ASSERT_)   \
+    enum { table(DEBOUNCE_TABLE_UNIQUE_) }
+
+// ---- Expansions of one entry (internal) ----
+
+#ifdef __cplusplus
+#define DEBOUNCE_STATIC_ASSERT_ static_assert
+#else
+#define DEBOUNCE_STATIC_ASSERT_ _Static_assert
+#endif
+
+#define DEBOUNCE_TABLE_ONE_(gpio, ...) + 1
+#define DEBOUNCE_TABLE_BIT_(gpio, ...) | (1ULL << (gpio))
+#define DEBOUNCE_TABLE_PIN_(gpio, ...) (gpio_num_t)(gpio),
+#define DEBOUNCE_TABLE_ENTRY_(gpio, topic, ...) \
+    { .pin = (gpio_num_t)(gpio), .mqtt_topic = (topic), __VA_ARGS__ },
+// A pin listed twice declares the same enumerator twice.
+#define DEBOUNCE_TABLE_UNIQUE_(gpio, ...) debounce_table_gpio_##gpio##_listed_twice,
+#define DEBOUNCE_TABLE_ASSERT_(gpio, topic, ...)                           \
+    DEBOUNCE_STATIC_ASSERT_(GPIO_IS_VALID_GPIO(gpio),                      \
+                            "GPIO " #gpio " is not a valid GPIO");         \
+    DEBOUNCE_STATIC_ASSERT_(sizeof(topic) - 1 <= DEBOUNCE_TOPIC_MAX,       \
+                            "topic of GPIO " #gpio " is too long");
@@ -0,0 +1,104 @@
+#pragma once
+
+/**
+ * Deep-sleep pin monitoring on the ULP coprocessor (CONFIG_DEBOUNCE_ULP).
+ *
+ * For battery installs the main CPU, Wi-Fi and the debounce engine stay off.
+ * The ULP polls the RTC-capable pins of the pin table, debounces them and
+ * queues their changes with timestamps in RTC memory, which survives deep
+ * sleep. It wakes the CPU once the queue reaches a watermark, a priority pin
+ * changes or the oldest change has waited max_latency_ms; a heartbeat timer
+ * wakes it regardless. Every boot then runs the same short cycle:
+ *
+ *     debounce_ulp_start(board_pins, count, &ulp, NULL);
+ *     size_t n = debounce_ulp_peek(events, max, &lost);
+ *     if (upload(events, n, lost)) {
+ *         debounce_ulp_consume(n);
+ *     }
+ *     debounce_ulp_sleep();
+ *
+ * Events stay queued until consumed, so a failed upload is retried on the next
+ * wake-up; events already peeked no longer count toward the watermark or the
+ * latency, so a failed upload does not wake the CPU again at once.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "debounce.h"
+#include "pin_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Why the CPU woke (a mask); 0 after a cold boot or reset.
+typedef enum {
+    DEBOUNCE_ULP_WAKE_WATERMARK = PIN_HAL_LP_WAKE_WATERMARK,
+    DEBOUNCE_ULP_WAKE_PRIORITY  = PIN_HAL_LP_WAKE_PRIORITY,
+    DEBOUNCE_ULP_WAKE_LATENCY   = PIN_HAL_LP_WAKE_LATENCY,
+    DEBOUNCE_ULP_WAKE_HEARTBEAT = PIN_HAL_LP_WAKE_TIMER,
+} debounce_ulp_wake_t;
+
+/// @brief One debounced change: pin, new level and how long before the peek.
+typedef pin_hal_lp_event_t debounce_ulp_event_t;
+
+/**
+ * @brief Low-power monitoring setup. Zero fields take their Kconfig default,
+ * where a zero latency or heartbeat turns that wake-up off.
+ */
+typedef struct {
+    uint32_t poll_us;         // CONFIG_DEBOUNCE_ULP_POLL_US
+    uint32_t watermark;       // CONFIG_DEBOUNCE_ULP_WATERMARK; at most PIN_HAL_LP_EVENTS
+    uint64_t priority_mask;   // Bit n = GPIO n: a change wakes the CPU at once
+    uint32_t max_latency_ms;  // CONFIG_DEBOUNCE_ULP_MAX_LATENCY_S
+    uint32_t heartbeat_s;     // CONFIG_DEBOUNCE_ULP_HEARTBEAT_S
+} debounce_ulp_config_t;
+
+/**
+ * @brief Hand the pins to the ULP, or pick up where it left off.
+ *
+ * Call on every boot. Pins that are not RTC-capable, or use an engine other
+ * than DEBOUNCE_ENGINE_TIMER or DEBOUNCE_ENGINE_SAMPLED, are skipped with a
+ * warning. A pin takes a new level once it has read it for its debounce window
+ * (four sample ticks for the sampled engine), rounded up to whole polls, like
+ * DEBOUNCE_POLICY_TRAILING; both levels are queued whatever intr_type says.
+ * After a wake-up from debounce_ulp_sleep() the ULP keeps its levels and queue
+ * and only the wake conditions are updated; resumed (optional) tells which.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_NOT_FOUND if no pin can be
+ *         monitored, ESP_ERR_NOT_SUPPORTED without CONFIG_DEBOUNCE_ULP
+ */
+esp_err_t debounce_ulp_start(const debounce_config_t *pins, size_t count,
+                             const debounce_ulp_config_t *config, bool *resumed);
+
+/// @brief Why this boot happened, as a debounce_ulp_wake_t mask.
+uint32_t debounce_ulp_wake_cause(void);
+
+/**
+ * @brief Copy up to max of the oldest queued events without removing them.
+ *
+ * @param lost Receives the events dropped on a full queue since the last
+ *             consume (optional)
+ * @return Number of events copied
+ */
+size_t debounce_ulp_peek(debounce_ulp_event_t *out, size_t max, uint32_t *lost);
+
+/// @brief Remove the n oldest events and acknowledge the lost count of the last peek.
+void debounce_ulp_consume(size_t n);
+
+/**
+ * @brief Enter deep sleep until the ULP or the heartbeat wakes the CPU.
+ *
+ * Does not return on hardware; the wake-up is a fresh boot. In the simulator
+ * it returns at the virtual time of the wake-up.
+ *
+ * @return Only on failure: ESP_ERR_INVALID_STATE if not started,
+ *         ESP_ERR_NOT_SUPPORTED without CONFIG_DEBOUNCE_ULP
+ */
+esp_err_t debounce_ulp_sleep(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,23 +1,148 @@
 #ifndef DEBOUNCE_INTERNAL_H
 #define DEBOUNCE_INTERNAL_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
 #include "debounce.h"     // debounce_config_t
-#include "esp_timer.h"    // esp_timer_handle_t
-#include "driver/gpio.h"  // gpio_num_t
+#include "app_shared.h"   // gpio_event_kind_t, gpio_event_lane_t
+#include "pin_hal.h"      // gpio_num_t, pin_hal_timer_t, input levels
+
+// Intrusive timer wheel link; lives inside each entry so arming never allocates.
+typedef struct debounce_wheel_node {
+    struct debounce_wheel_node *next;
+    struct debounce_wheel_node *prev;  // NULL when not armed
+    uint32_t                    expires; // Absolute wheel tick
+} debounce_wheel_node_t;
+
+struct debounce_wheel;
 
 // Internal tracking for each debounced pin.
 typedef struct {
-    debounce_config_t   config;      // Public-facing pin config (includes mqtt_topic)
-    esp_timer_handle_t  timer;       // One-shot debounce timer
-    const char         *mqtt_topic;  // Cached pointer to config.mqtt_topic (optional convenience)
+    debounce_config_t      config;      // Public-facing pin config (includes mqtt_topic)
+    debounce_wheel_node_t  wheel_node;  // Pending debounce deadline (timer engine)
+    struct debounce_wheel *wheel;       // Wheel matching config.dispatch
+    volatile int64_t       first_edge_us; // pin_hal time of the first edge of the burst
+    volatile int64_t       last_edge_us; // pin_hal time of the latest edge
+    const char            *mqtt_topic;  // Cached pointer to config.mqtt_topic (optional convenience)
+    volatile bool          in_use;      // Slot is registered; ISR/timer ignore free slots
+    uint32_t               window_us;   // Debounce window of the current burst
+    uint8_t                stable_level; // Last settled level, reported or not
+    // Interrupt moderation (CONFIG_DEBOUNCE_CHATTER_MODERATION)
+    int64_t                rate_window_us;   // Start of the current rate window
+    uint32_t               rate_edges;       // Edges seen in that window
+    volatile bool          chatter;          // Interrupt off, pin is being polled
+    bool                   chatter_reported; // Start diagnostic already emitted
+    uint16_t               calm_polls;       // Consecutive polls at poll_level
+    uint8_t                poll_level;
 } debounce_entry_t;
 
-// Storage defined in debounce.c
-extern debounce_entry_t debounce_pins[];
+// Storage defined in debounce.c, indexed directly by GPIO number.
+extern debounce_entry_t debounce_pins[GPIO_NUM_MAX];
 extern int              debounce_count;
 
+// Push a level or diagnostic event for a pin to the event
+// rings (task context only). Drops silently if the entry was unregistered meanwhile.
+void debounce_emit_event(debounce_entry_t *entry, gpio_event_kind_t kind, int level);
+// Same from interrupt context, to the lane owned by that interrupt
+// (GPIO_EVENT_LANE_ISR for the ISR-dispatched wheel, GPIO_EVENT_LANE_GPIO for the GPIO ISR).
+void debounce_emit_event_from_isr(debounce_entry_t *entry, gpio_event_lane_t lane,
+                                  gpio_event_kind_t kind, int level, BaseType_t *hp_task_woken);
+
+// Sampling engine (debounce_sampler.c)
+esp_err_t debounce_sampler_add(const debounce_config_t *config);
+void      debounce_sampler_remove(gpio_num_t pin);
+// Emit one event per set bit in changed, taking levels from state.
+void      debounce_sampler_dispatch(uint64_t changed, uint64_t state, int64_t edge_us);
+
+// Pulse counter engine (debounce_pcnt.c, CONFIG_DEBOUNCE_PCNT)
+// Start counting for an entry whose config is filled in and GPIO configured.
+// An encoder's B input is configured here; debounce.c releases it again.
+esp_err_t debounce_pcnt_add(debounce_entry_t *entry);
+void      debounce_pcnt_remove(gpio_num_t pin);
+// True if pin is the B input of a registered encoder.
+bool      debounce_pcnt_claims(gpio_num_t pin);
+
+// PWM capture engine (debounce_pwm.c, CONFIG_DEBOUNCE_PWM)
+// Start capturing for an entry whose config is filled in and GPIO configured.
+esp_err_t debounce_pwm_add(debounce_entry_t *entry);
+void      debounce_pwm_remove(gpio_num_t pin);
+
+// Burst capture engine (debounce_burst.c, CONFIG_DEBOUNCE_BURST)
+// Start receiving for an entry whose config is filled in and GPIO configured.
+// A two-line decoder's burst_b_pin is configured here; debounce.c releases it again.
+esp_err_t debounce_burst_add(debounce_entry_t *entry);
+void      debounce_burst_remove(gpio_num_t pin);
+// True if pin is the second line of a registered burst pin.
+bool      debounce_burst_claims(gpio_num_t pin);
+
+// Replace a pin's debounce window under the pins lock (debounce.c).
+void      debounce_set_window(debounce_entry_t *entry, uint32_t window_us);
+
+// Adaptive windows (debounce_adapt.c, CONFIG_DEBOUNCE_ADAPTIVE)
+// Set up learning on register/update; applies a previously learned window.
+void      debounce_adapt_add(debounce_entry_t *entry);
+// Record the bounce of a finished burst; callable from ISR.
+void      debounce_adapt_record(debounce_entry_t *entry);
+
+// Raw edge capture (debounce_capture.c, CONFIG_DEBOUNCE_CAPTURE)
+// Pins being captured; 0 while capture is stopped. Checked inline by the GPIO ISR.
+extern volatile uint64_t debounce_capture_mask;
+// Record the current level of every pin in pins at now_us; callable from ISR.
+void      debounce_capture_record(uint64_t pins, int64_t now_us);
+
+static inline IRAM_ATTR void debounce_capture_edges(uint64_t pins, int64_t now_us) {
+#if CONFIG_DEBOUNCE_CAPTURE
+    if (debounce_capture_mask & pins) {
+        debounce_capture_record(pins, now_us);
+    }
+#else
+    (void)pins;
+    (void)now_us;
+#endif
+}
+
+// Timer wheel (debounce_wheel.c)
+#define DEBOUNCE_WHEEL_L0_BITS  8
+#define DEBOUNCE_WHEEL_L1_BITS  6
+#define DEBOUNCE_WHEEL_L0_SLOTS (1u << DEBOUNCE_WHEEL_L0_BITS)
+#define DEBOUNCE_WHEEL_L1_SLOTS (1u << DEBOUNCE_WHEEL_L1_BITS)
+
+// Receives every entry whose deadline fell on the same tick, in one call.
+typedef void (*debounce_wheel_expired_cb_t)(debounce_entry_t **batch, size_t count);
+
+// Two-level hashed wheel: level 0 holds deadlines within 256 ticks, level 1
+// holds later ones in 256-tick buckets and cascades down as the cursor wraps.
+typedef struct debounce_wheel {
+    debounce_wheel_node_t       l0[DEBOUNCE_WHEEL_L0_SLOTS]; // List heads
+    debounce_wheel_node_t       l1[DEBOUNCE_WHEEL_L1_SLOTS];
+    uint32_t                    now;       // Last processed tick
+    int64_t                     base_us;   // pin_hal time of tick 0
+    uint32_t                    pending;   // Armed nodes
+    bool                        running;   // Tick timer active
+    pin_hal_timer_t             timer;
+    debounce_wheel_expired_cb_t expired;
+    portMUX_TYPE                lock;
+} debounce_wheel_t;
+
+esp_err_t debounce_wheel_init(debounce_wheel_t *wheel, const char *name,
+                              bool isr_dispatch,
+                              debounce_wheel_expired_cb_t expired);
+// O(1); callable from ISR. Re-arming an armed entry moves its deadline.
+// Returns true if the entry was idle, i.e. this edge starts a new burst.
+bool      debounce_wheel_arm(debounce_wheel_t *wheel, debounce_entry_t *entry, uint32_t delay_us);
+// Arm several entries under one lock acquisition (count <= 64). Bit i of the
+// result is set if entries[i] started a new burst.
+uint64_t  debounce_wheel_arm_batch(debounce_wheel_t *wheel, debounce_entry_t **entries,
+                                   const uint32_t *delays_us, size_t count);
+void      debounce_wheel_cancel(debounce_wheel_t *wheel, debounce_entry_t *entry);
+
 // NOTE:
 // - ISR and timer callback are intentionally NOT declared here.
 //   They are file-local (static) in debounce.c, so no external prototypes are exposed.
+// - The ISR receives a debounce_entry_t* as its argument, so no lookup is needed per edge.
 
 #endif // DEBOUNCE_INTERNAL_H
@@ -0,0 +1,41 @@
+#ifndef DEBOUNCE_TPL_H
+#define DEBOUNCE_TPL_H
+
+/**
+ * Timer-engine back end on the C++ Debouncer template (CONFIG_DEBOUNCE_TPL).
+ *
+ * debounce_register_pin() hands DEBOUNCE_ENGINE_TIMER pins to one Debouncer
+ * instance per policy (debounce.hpp) instead of the timer wheel. The GPIO ISR
+ * in debounce.c feeds their edges here; expiry runs on a tick timer in the
+ * esp_timer task that only runs while a deadline is pending. Reports come
+ * back through debounce_tpl_report() so they get the same filtering and
+ * event path as the C engine. Shared by debounce.c and debounce_tpl.cpp,
+ * so C and C++ only.
+ */
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "debounce.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Add a configured pin to the instance of its policy, at its current level.
+esp_err_t debounce_tpl_add(const debounce_config_t *config);
+void      debounce_tpl_remove(gpio_num_t pin);
+// GPIO ISR: one edge with the level read for it. A leading-edge report is
+// made at once through debounce_tpl_report().
+void      debounce_tpl_edge(gpio_num_t pin, int level, BaseType_t *hp_task_woken);
+
+// Implemented in debounce.c: a level confirmed by the template. From the GPIO
+// ISR hp_task_woken is set, from the tick it is NULL.
+void      debounce_tpl_report(gpio_num_t pin, int level, int64_t edge_us,
+                              BaseType_t *hp_task_woken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEBOUNCE_TPL_H
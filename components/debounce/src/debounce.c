@@ -1,131 +1,1001 @@
+#include "sdkconfig.h"
 #include "debounce.h"
-#include "esp_timer.h"
-#include "driver/gpio.h"
+#include "pin_hal.h"
+#include "debounce_decoder.h"
 #include "private/debounce_internal.h"
+#include "private/debounce_tpl.h"
 #include "esp_log.h"
-#include "app_shared.h"   // for gpio_event_t and gpio_event_queue
-
-#define MAX_DEBOUNCE_PINS 10
+#include "app_shared.h"   // for gpio_event_t and gpio_event_post()
+#include <stdatomic.h>
 
 static const char *TAG = "Debounce";
 
-debounce_entry_t debounce_pins[MAX_DEBOUNCE_PINS];
+debounce_entry_t debounce_pins[GPIO_NUM_MAX];
 int debounce_count = 0;
 
+// Guards entry config against concurrent register/unregister/update.
+static portMUX_TYPE s_pins_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Shared deadline wheel for every timer-engine pin.
+static debounce_wheel_t s_wheel;
+#if CONFIG_DEBOUNCE_ISR_DISPATCH
+// Second wheel whose tick runs in the esp_timer ISR (DEBOUNCE_DISPATCH_ISR pins).
+static debounce_wheel_t s_isr_wheel;
+#endif
+
+// Timer-engine pins run on the Debouncer template (debounce_tpl.cpp) instead of the wheels.
+#if CONFIG_DEBOUNCE_TPL
+#define TPL_ENGINE 1
+#else
+#define TPL_ENGINE 0
+#endif
+
+// Allocation flags for the GPIO interrupt (per-pin service or global handler).
+#if CONFIG_DEBOUNCE_ISR_LEVEL == 3
+#define DEBOUNCE_INTR_FLAGS PIN_HAL_INTR_LEVEL3
+#elif CONFIG_DEBOUNCE_ISR_LEVEL == 2
+#define DEBOUNCE_INTR_FLAGS PIN_HAL_INTR_LEVEL2
+#else
+#define DEBOUNCE_INTR_FLAGS PIN_HAL_INTR_LEVEL1
+#endif
+#if CONFIG_DEBOUNCE_IRAM_SAFE
+#define DEBOUNCE_INTR_ALLOC_FLAGS (DEBOUNCE_INTR_FLAGS | PIN_HAL_INTR_IRAM)
+#else
+#define DEBOUNCE_INTR_ALLOC_FLAGS DEBOUNCE_INTR_FLAGS
+#endif
+
+#if CONFIG_DEBOUNCE_GLOBAL_ISR
+static pin_hal_intr_handle_t s_gpio_intr = NULL;
+#endif
+
+// Global event sequence; every confirmed level takes the next number, even if
+// it is then dropped, so consumers can spot gaps and reordering.
+static atomic_uint_fast32_t s_event_seq = 0;
+
+// Edge-to-enqueue latency per dispatch mode.
+static debounce_latency_stats_t s_latency[DEBOUNCE_DISPATCH_MAX];
+static uint32_t s_isr_dropped = 0; // Events lost in ISR context (cannot log there); under s_latency_lock
+static portMUX_TYPE s_latency_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static IRAM_ATTR void record_latency(debounce_dispatch_t dispatch, int64_t edge_us,
+                                     uint32_t window_us) {
+    uint32_t lat = (uint32_t)(pin_hal_time_us() - edge_us);
+    uint32_t over = lat > window_us ? lat - window_us : 0;
+
+    portENTER_CRITICAL_SAFE(&s_latency_lock);
+    debounce_latency_stats_t *st = &s_latency[dispatch];
+    if (st->count == 0 || lat < st->min_us) {
+        st->min_us = lat;
+    }
+    if (lat > st->max_us) {
+        st->max_us = lat;
+    }
+    if (st->count == 0 || over < st->overshoot_min_us) {
+        st->overshoot_min_us = over;
+    }
+    if (over > st->overshoot_max_us) {
+        st->overshoot_max_us = over;
+    }
+    st->sum_us += lat;
+    st->overshoot_sum_us += over;
+    st->count++;
+    portEXIT_CRITICAL_SAFE(&s_latency_lock);
+}
+
 /**
- * Timer callback (NOT ISR). Reads the stable pin level and pushes a gpio_event_t
- * to gpio_event_queue so main.c can publish over MQTT.
+ * Snapshot what an event needs from the entry and stamp it with the
+ * confirmation time and the next sequence number. Returns false if the pin
+ * was unregistered while its event was pending.
  */
-static void debounce_timer_callback(void *arg) {
-    gpio_num_t pin = (gpio_num_t)(intptr_t)arg;
+static IRAM_ATTR bool build_event(debounce_entry_t *entry, gpio_event_kind_t kind, int level,
+                                  gpio_event_t *evt) {
+    int64_t now_us = pin_hal_time_us();
 
-    for (int i = 0; i < debounce_count; i++) {
-        if (debounce_pins[i].config.pin == pin) {
-            int level = gpio_get_level(pin);
+    portENTER_CRITICAL_SAFE(&s_pins_lock);
+    bool in_use = entry->in_use;
+    evt->pin   = (uint8_t)entry->config.pin;
+    portEXIT_CRITICAL_SAFE(&s_pins_lock);
 
-            gpio_event_t evt = {
-                .pin   = pin,
-                .level = level,
-                .topic = debounce_pins[i].config.mqtt_topic,
-            };
+    if (!in_use) {
+        return false;
+    }
+    evt->level      = (uint8_t)level;
+    evt->kind       = (uint8_t)kind;
+    evt->reserved   = 0;
+    evt->edge_us    = (uint32_t)entry->first_edge_us;
+    evt->confirm_us = (uint32_t)now_us;
+    evt->seq        = (uint32_t)atomic_fetch_add_explicit(&s_event_seq, 1, memory_order_relaxed);
+    return true;
+}
 
-            if (gpio_event_queue) {
-                BaseType_t ok = xQueueSend(gpio_event_queue, &evt, 0); // non-blocking
-                if (ok != pdTRUE) {
-                    ESP_LOGW(TAG, "Queue full; dropped GPIO %d event", pin);
-                }
-            } else {
-                ESP_LOGW(TAG, "gpio_event_queue is NULL; event lost (GPIO %d)", pin);
-            }
-            break;
+/**
+ * Push a stable level (or diagnostic) to the task lane of the event rings so
+ * main.c can publish over MQTT. Shared by every engine; runs in task context.
+ */
+void debounce_emit_event(debounce_entry_t *entry, gpio_event_kind_t kind, int level) {
+    gpio_event_t evt;
+    if (!build_event(entry, kind, level, &evt)) {
+        return; // Unregistered while the event was pending
+    }
+
+    if (!gpio_event_post(GPIO_EVENT_LANE_TASK, &evt)) {
+        ESP_LOGW(TAG, "Event ring full; dropped GPIO %d event", evt.pin);
+    } else if (kind == GPIO_EVENT_LEVEL) {
+        gpio_stats_pin_inc(evt.pin, GPIO_PIN_STAT_EVENTS);
+        if (entry->config.engine == DEBOUNCE_ENGINE_TIMER) {
+            record_latency(DEBOUNCE_DISPATCH_TASK, entry->last_edge_us, entry->window_us);
         }
     }
 }
 
 /**
- * GPIO ISR: keep it tiny. Just arm the per-pin debounce one-shot timer.
+ * ISR flavour of debounce_emit_event(). No logging here; drops are counted
+ * and show up in debounce_log_latency_stats().
  */
-static void gpio_isr_handler(void *arg) {
-    gpio_num_t pin = (gpio_num_t)(intptr_t)arg;
+IRAM_ATTR void debounce_emit_event_from_isr(debounce_entry_t *entry, gpio_event_lane_t lane,
+                                            gpio_event_kind_t kind, int level,
+                                            BaseType_t *hp_task_woken) {
+    gpio_event_t evt;
+    if (!build_event(entry, kind, level, &evt)) {
+        return;
+    }
 
-    for (int i = 0; i < debounce_count; i++) {
-        if (debounce_pins[i].config.pin == pin) {
-            // Stop any pending one-shot so rapid edges don't queue multiple callbacks
-            (void)esp_timer_stop(debounce_pins[i].timer);
-            (void)esp_timer_start_once(debounce_pins[i].timer,
-                                       debounce_pins[i].config.debounce_time_us);
-            break;
+    if (!gpio_event_post_from_isr(lane, &evt, hp_task_woken)) {
+        portENTER_CRITICAL_SAFE(&s_latency_lock);
+        s_isr_dropped++; // Ring full
+        portEXIT_CRITICAL_SAFE(&s_latency_lock);
+    } else if (kind == GPIO_EVENT_LEVEL) {
+        gpio_stats_pin_inc(evt.pin, GPIO_PIN_STAT_EVENTS);
+        // Leading-edge reports from the GPIO ISR skip the expiry path, so they
+        // stay out of the stats that compare the two dispatch modes.
+        if (lane != GPIO_EVENT_LANE_GPIO) {
+            record_latency(entry->wheel == &s_wheel ? DEBOUNCE_DISPATCH_TASK
+                                                    : DEBOUNCE_DISPATCH_ISR,
+                           entry->last_edge_us, entry->window_us);
         }
     }
 }
 
+// Where a report is made decides which lane its events go to.
+typedef struct {
+    bool              from_isr;
+    gpio_event_lane_t lane;       // Interrupt lane when from_isr
+    BaseType_t        hp_task_woken;
+} emit_ctx_t;
+
+static IRAM_ATTR void emit(emit_ctx_t *ctx, debounce_entry_t *entry,
+                           gpio_event_kind_t kind, int level) {
+    if (ctx->from_isr) {
+        debounce_emit_event_from_isr(entry, ctx->lane, kind, level, &ctx->hp_task_woken);
+    } else {
+        debounce_emit_event(entry, kind, level);
+    }
+}
+
+// Pins whose policy needs the last stable level see both edges in hardware;
+// intr_type then only filters which levels are reported. The template engine
+// tracks the level of every pin.
+static inline IRAM_ATTR bool tracks_state(const debounce_config_t *config) {
+#if CONFIG_DEBOUNCE_TPL
+    (void)config;
+    return true;
+#else
+    return config->policy != DEBOUNCE_POLICY_TRAILING || config->state_change_only;
+#endif
+}
+
+static inline gpio_int_type_t hw_intr_type(const debounce_config_t *config) {
+    return tracks_state(config) ? GPIO_INTR_ANYEDGE : config->intr_type;
+}
+
+// Window for the burst an edge belongs to. Asymmetric pins pick press or
+// release time by where the pin is heading: away from its stable level.
+static inline IRAM_ATTR uint32_t edge_window_us(const debounce_entry_t *entry) {
+    const debounce_config_t *config = &entry->config;
+    if (config->policy == DEBOUNCE_POLICY_ASYMMETRIC) {
+        uint8_t idle_level = config->pull_up ? 1 : 0;
+        uint32_t window_us = (entry->stable_level == idle_level) ? config->press_time_us
+                                                                 : config->release_time_us;
+        if (window_us) {
+            return window_us;
+        }
+    }
+    return config->debounce_time_us;
+}
+
+/**
+ * Apply the pin's reporting rules to a settled level. The stable level is
+ * tracked for every pin; state-tracking pins drop repeats (state_change_only,
+ * or the end of a leading-edge lockout) and levels their intr_type excludes.
+ */
+static IRAM_ATTR void report_level(emit_ctx_t *ctx, debounce_entry_t *entry, int level) {
+    const debounce_config_t *config = &entry->config;
+    bool changed = (level != entry->stable_level);
+    entry->stable_level = (uint8_t)level;
+
+    if (tracks_state(config)) {
+        if ((!changed && (config->state_change_only || config->policy == DEBOUNCE_POLICY_LEADING)) ||
+            (config->intr_type == GPIO_INTR_POSEDGE && !level) ||
+            (config->intr_type == GPIO_INTR_NEGEDGE && level)) {
+            gpio_stats_pin_inc(config->pin, GPIO_PIN_STAT_SUPPRESSED);
+            return;
+        }
+    }
+    emit(ctx, entry, GPIO_EVENT_LEVEL, level);
+}
+
+#if !CONFIG_DEBOUNCE_TPL
+/**
+ * First edge of a burst, from the GPIO ISR. Leading-edge pins report the
+ * level the pin is moving to right away; their wheel deadline is the lockout.
+ */
+static IRAM_ATTR void on_burst_start(emit_ctx_t *ctx, debounce_entry_t *entry, int64_t now_us) {
+    entry->first_edge_us = now_us;
+    if (entry->config.policy == DEBOUNCE_POLICY_LEADING) {
+        report_level(ctx, entry, !entry->stable_level);
+    }
+}
+#endif
+
+#if CONFIG_DEBOUNCE_TPL
+/**
+ * Level confirmed by the Debouncer template (debounce_tpl.cpp): from the GPIO
+ * ISR for a leading edge, otherwise from its tick in the esp_timer task.
+ */
+IRAM_ATTR void debounce_tpl_report(gpio_num_t pin, int level, int64_t edge_us,
+                                   BaseType_t *hp_task_woken) {
+    debounce_entry_t *entry = &debounce_pins[pin];
+    emit_ctx_t ctx = { .from_isr = hp_task_woken != NULL, .lane = GPIO_EVENT_LANE_GPIO,
+                       .hp_task_woken = pdFALSE };
+    entry->first_edge_us = edge_us;
+    if (!ctx.from_isr) {
+        gpio_stats_pin_inc(pin, GPIO_PIN_STAT_BURSTS);
+    }
+    report_level(&ctx, entry, level);
+    if (hp_task_woken && ctx.hp_task_woken) {
+        *hp_task_woken = pdTRUE;
+    }
+}
+#endif
+
+#if CONFIG_DEBOUNCE_CHATTER_MODERATION
+#define CHATTER_WINDOW_US ((int64_t)CONFIG_DEBOUNCE_CHATTER_WINDOW_MS * 1000)
+#define CHATTER_POLL_US   ((uint32_t)CONFIG_DEBOUNCE_CHATTER_POLL_MS * 1000)
+
+/**
+ * Called from the GPIO ISR for every edge. Counts edges in a fixed window;
+ * past the limit the pin's interrupt is switched off and the wheel deadline
+ * is turned into a poll, so a broken input costs at most one poll per
+ * CONFIG_DEBOUNCE_CHATTER_POLL_MS. Returns true if the edge was absorbed.
+ */
+static IRAM_ATTR bool chatter_on_edge(debounce_entry_t *entry, debounce_wheel_t *wheel,
+                                      int64_t now_us) {
+    if (now_us - entry->rate_window_us >= CHATTER_WINDOW_US) {
+        entry->rate_window_us = now_us;
+        entry->rate_edges = 0;
+    }
+    if (++entry->rate_edges <= CONFIG_DEBOUNCE_CHATTER_MAX_EDGES) {
+        return false;
+    }
+
+    (void)pin_hal_intr_disable(entry->config.pin);
+    gpio_stats_pin_inc(entry->config.pin, GPIO_PIN_STAT_CHATTER);
+    entry->chatter = true;
+    entry->chatter_reported = false;
+    entry->calm_polls = 0;
+    entry->poll_level = (uint8_t)((pin_hal_read_levels() >> entry->config.pin) & 1);
+    (void)debounce_wheel_arm(wheel, entry, CHATTER_POLL_US);
+    return true;
+}
+
 /**
- * Register a pin for debouncing: configures GPIO, creates a one-shot timer,
- * and attaches the ISR handler.
+ * Poll of a chattering pin, in place of the debounce expiry. The start
+ * diagnostic is emitted here rather than in the GPIO ISR so each lane keeps
+ * a single producer. Once the level has held for enough polls, the settled
+ * level is reported and the interrupt comes back.
  */
-void debounce_register_pin(const debounce_config_t *config) {
-    if (debounce_count >= MAX_DEBOUNCE_PINS) {
-        ESP_LOGW(TAG, "Max debounce pins reached. Pin %d not added.", config->pin);
+static IRAM_ATTR void chatter_poll(emit_ctx_t *ctx, debounce_entry_t *entry, int level) {
+    if (!entry->chatter_reported) {
+        entry->chatter_reported = true;
+        emit(ctx, entry, GPIO_EVENT_CHATTER_START, level);
+    }
+
+    if (level == entry->poll_level) {
+        entry->calm_polls++;
+    } else {
+        entry->poll_level = (uint8_t)level;
+        entry->calm_polls = 0;
+    }
+
+    if (entry->calm_polls < CONFIG_DEBOUNCE_CHATTER_CALM_POLLS) {
+        (void)debounce_wheel_arm(entry->wheel, entry, CHATTER_POLL_US);
         return;
     }
 
-    gpio_config_t io_conf = {
-        .intr_type = config->intr_type,
-        .mode = GPIO_MODE_INPUT,
-        .pin_bit_mask = (1ULL << config->pin),
-        .pull_up_en = config->pull_up ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-    };
-    esp_err_t err = gpio_config(&io_conf);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "gpio_config failed for GPIO %d: %s", config->pin, esp_err_to_name(err));
+    entry->chatter = false;
+    entry->rate_edges = 0;
+    entry->rate_window_us = pin_hal_time_us();
+    emit(ctx, entry, GPIO_EVENT_CHATTER_END, level);
+    report_level(ctx, entry, level);
+    (void)pin_hal_intr_enable(entry->config.pin);
+}
+#endif
+
+static IRAM_ATTR void handle_expiry(emit_ctx_t *ctx, debounce_entry_t *entry, int level) {
+#if CONFIG_DEBOUNCE_CHATTER_MODERATION
+    if (entry->chatter) {
+        chatter_poll(ctx, entry, level);
         return;
     }
+#endif
+    gpio_stats_pin_inc(entry->config.pin, GPIO_PIN_STAT_BURSTS);
+#if CONFIG_DEBOUNCE_ADAPTIVE
+    debounce_adapt_record(entry);
+#endif
+    report_level(ctx, entry, level);
+}
 
-    char timer_name[16];
-    snprintf(timer_name, sizeof(timer_name), "debounce_%d", config->pin);
+/**
+ * Wheel expiry (NOT ISR). Every pin whose window closed on this tick arrives
+ * together; the input registers are read once for the whole batch.
+ */
+static void debounce_wheel_expired(debounce_entry_t **batch, size_t count) {
+    emit_ctx_t ctx = { .from_isr = false };
+    uint64_t levels = pin_hal_read_levels();
+    gpio_stats_stage_add(GPIO_STAGE_STAT_WHEEL_EXPIRED, count);
+    for (size_t i = 0; i < count; i++) {
+        gpio_num_t pin = batch[i]->config.pin;
+        handle_expiry(&ctx, batch[i], (int)((levels >> pin) & 1));
+    }
+}
 
-    esp_timer_create_args_t timer_args = {
-        .callback = debounce_timer_callback,
-        .arg = (void *)(intptr_t)config->pin,
-        .name = timer_name,
-        .dispatch_method = ESP_TIMER_TASK
-    };
+#if CONFIG_DEBOUNCE_ISR_DISPATCH
+/**
+ * Wheel expiry from the esp_timer ISR: same batch handling, posted straight
+ * to the ISR lane of the event rings without waiting for the esp_timer task.
+ */
+static IRAM_ATTR void debounce_wheel_expired_isr(debounce_entry_t **batch, size_t count) {
+    emit_ctx_t ctx = { .from_isr = true, .lane = GPIO_EVENT_LANE_ISR, .hp_task_woken = pdFALSE };
+    uint64_t levels = pin_hal_read_levels();
+    gpio_stats_stage_add(GPIO_STAGE_STAT_WHEEL_EXPIRED, count);
+    for (size_t i = 0; i < count; i++) {
+        gpio_num_t pin = batch[i]->config.pin;
+        handle_expiry(&ctx, batch[i], (int)((levels >> pin) & 1));
+    }
+    if (ctx.hp_task_woken) {
+        pin_hal_timer_isr_yield();
+    }
+}
+#endif
 
-    esp_timer_handle_t timer = NULL;
-    err = esp_timer_create(&timer_args, &timer);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "esp_timer_create failed for GPIO %d: %s", config->pin, esp_err_to_name(err));
+static debounce_wheel_t *wheel_for(const debounce_config_t *config) {
+#if CONFIG_DEBOUNCE_ISR_DISPATCH
+    if (config->dispatch == DEBOUNCE_DISPATCH_ISR) {
+        return &s_isr_wheel;
+    }
+#else
+    if (config->dispatch == DEBOUNCE_DISPATCH_ISR) {
+        ESP_LOGW(TAG, "GPIO %d: ISR dispatch disabled (CONFIG_DEBOUNCE_ISR_DISPATCH); using task",
+                 config->pin);
+    }
+#endif
+    return &s_wheel;
+}
+
+/**
+ * GPIO ISR: keep it tiny. Timestamp the edge and push the pin's deadline out
+ * on the wheel. IRAM-resident like everything it calls, so edges are still
+ * captured while the flash cache is off.
+ */
+static IRAM_ATTR void gpio_isr_handler(void *arg) {
+    debounce_entry_t *entry = (debounce_entry_t *)arg;
+
+    int64_t now_us = pin_hal_time_us();
+    debounce_capture_edges(1ULL << entry->config.pin, now_us);
+
+    portENTER_CRITICAL_ISR(&s_pins_lock);
+    bool in_use = entry->in_use;
+    uint32_t window_us = edge_window_us(entry);
+    debounce_wheel_t *wheel = entry->wheel;
+    portEXIT_CRITICAL_ISR(&s_pins_lock);
+
+    gpio_stats_stage_inc(GPIO_STAGE_STAT_ISR);
+    if (!in_use) {
         return;
     }
+    gpio_stats_pin_inc(entry->config.pin, GPIO_PIN_STAT_EDGES);
 
-    debounce_pins[debounce_count++] = (debounce_entry_t){
-        .config = *config,
-        .timer  = timer,
-        .mqtt_topic = config->mqtt_topic, // if your internal struct mirrors this member
-    };
+#if CONFIG_DEBOUNCE_TPL
+    entry->last_edge_us = now_us;
+    entry->window_us = window_us;
+    BaseType_t hp_task_woken = pdFALSE;
+    debounce_tpl_edge(entry->config.pin,
+                      (int)((pin_hal_read_levels() >> entry->config.pin) & 1), &hp_task_woken);
+    if (hp_task_woken) {
+        portYIELD_FROM_ISR();
+    }
+    (void)wheel;
+#else
+#if CONFIG_DEBOUNCE_CHATTER_MODERATION
+    if (entry->chatter || chatter_on_edge(entry, wheel, now_us)) {
+        return; // Being polled; a late edge from before the disable is ignored
+    }
+#endif
+
+    entry->last_edge_us = now_us;
+    entry->window_us = window_us;
+    if (debounce_wheel_arm(wheel, entry, window_us)) {
+        // Deadline is >= 1 tick away, so this lands before the expiry
+        emit_ctx_t ctx = { .from_isr = true, .lane = GPIO_EVENT_LANE_GPIO, .hp_task_woken = pdFALSE };
+        on_burst_start(&ctx, entry, now_us);
+        if (ctx.hp_task_woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+#endif // CONFIG_DEBOUNCE_TPL
+}
+
+#if CONFIG_DEBOUNCE_GLOBAL_ISR
+/**
+ * Push the deadlines of one wheel's pins out in a single lock acquisition.
+ * Chattering pins are taken out first; the arrays are compacted in place.
+ */
+static IRAM_ATTR void arm_edge_group(emit_ctx_t *ctx, debounce_wheel_t *wheel,
+                                     debounce_entry_t **entries, uint32_t *delays_us,
+                                     size_t count, int64_t now_us) {
+#if CONFIG_DEBOUNCE_TPL
+    uint64_t levels = pin_hal_read_levels();
+    for (size_t i = 0; i < count; i++) {
+        gpio_num_t pin = entries[i]->config.pin;
+        entries[i]->last_edge_us = now_us;
+        entries[i]->window_us = delays_us[i];
+        debounce_tpl_edge(pin, (int)((levels >> pin) & 1), &ctx->hp_task_woken);
+    }
+    (void)wheel;
+#else
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        debounce_entry_t *entry = entries[i];
+#if CONFIG_DEBOUNCE_CHATTER_MODERATION
+        if (entry->chatter || chatter_on_edge(entry, wheel, now_us)) {
+            continue;
+        }
+#endif
+        entry->last_edge_us = now_us;
+        entry->window_us = delays_us[i];
+        entries[kept] = entry;
+        delays_us[kept] = delays_us[i];
+        kept++;
+    }
+    if (kept == 0) {
+        return;
+    }
+
+    uint64_t fresh = debounce_wheel_arm_batch(wheel, entries, delays_us, kept);
+    for (size_t i = 0; i < kept; i++) {
+        if (fresh & (1ULL << i)) {
+            on_burst_start(ctx, entries[i], now_us);
+        }
+    }
+#endif // CONFIG_DEBOUNCE_TPL
+}
+
+/**
+ * Global GPIO interrupt (CONFIG_DEBOUNCE_GLOBAL_ISR). Reads and clears both
+ * status registers once, then handles every pending pin in one pass: one
+ * timestamp, one snapshot under the pins lock and one wheel lock per wheel,
+ * however many pins of a connector bounced together.
+ */
+static IRAM_ATTR void gpio_global_isr(void *arg) {
+    uint64_t pending = pin_hal_take_intr_status();
+    int64_t now_us = pin_hal_time_us();
+    gpio_stats_stage_inc(GPIO_STAGE_STAT_ISR);
+    debounce_capture_edges(pending, now_us);
+
+    // Task-wheel pins fill the arrays from the front, ISR-wheel pins from the back.
+    debounce_entry_t *entries[GPIO_NUM_MAX];
+    uint32_t delays_us[GPIO_NUM_MAX];
+    size_t task_count = 0;
+    size_t isr_first = GPIO_NUM_MAX;
 
-    err = gpio_isr_handler_add(config->pin, gpio_isr_handler, (void *)(intptr_t)config->pin);
+    portENTER_CRITICAL_ISR(&s_pins_lock);
+    while (pending) {
+        int pin = __builtin_ctzll(pending);
+        pending &= pending - 1;
+        if (pin >= GPIO_NUM_MAX) {
+            break;
+        }
+        debounce_entry_t *entry = &debounce_pins[pin];
+        if (!entry->in_use || entry->config.engine != DEBOUNCE_ENGINE_TIMER) {
+            continue;
+        }
+        gpio_stats_pin_inc(pin, GPIO_PIN_STAT_EDGES);
+        size_t i = (entry->wheel == &s_wheel) ? task_count++ : --isr_first;
+        entries[i] = entry;
+        delays_us[i] = edge_window_us(entry);
+    }
+    portEXIT_CRITICAL_ISR(&s_pins_lock);
+
+    emit_ctx_t ctx = { .from_isr = true, .lane = GPIO_EVENT_LANE_GPIO, .hp_task_woken = pdFALSE };
+    arm_edge_group(&ctx, &s_wheel, entries, delays_us, task_count, now_us);
+#if CONFIG_DEBOUNCE_ISR_DISPATCH
+    arm_edge_group(&ctx, &s_isr_wheel, &entries[isr_first], &delays_us[isr_first],
+                   GPIO_NUM_MAX - isr_first, now_us);
+#endif
+    if (ctx.hp_task_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+#endif
+
+static bool uses_pcnt(const debounce_config_t *config) {
+    return config->engine == DEBOUNCE_ENGINE_PCNT || config->engine == DEBOUNCE_ENGINE_ENCODER;
+}
+
+// Engines whose peripheral is set up at registration and has no GPIO interrupt.
+static bool uses_peripheral(const debounce_config_t *config) {
+    return uses_pcnt(config) || config->engine == DEBOUNCE_ENGINE_PWM ||
+           config->engine == DEBOUNCE_ENGINE_BURST;
+}
+
+// Second input a pin's engine takes over, or GPIO_NUM_NC.
+static gpio_num_t second_pin(const debounce_config_t *config) {
+    if (config->engine == DEBOUNCE_ENGINE_ENCODER) {
+        return config->encoder_b_pin;
+    }
+    if (config->engine == DEBOUNCE_ENGINE_BURST && config->decoder &&
+        config->decoder->lines == 2) {
+        return config->burst_b_pin;
+    }
+    return GPIO_NUM_NC;
+}
+
+static esp_err_t peripheral_add(debounce_entry_t *entry) {
+    switch (entry->config.engine) {
+    case DEBOUNCE_ENGINE_PWM:   return debounce_pwm_add(entry);
+    case DEBOUNCE_ENGINE_BURST: return debounce_burst_add(entry);
+    default:                    return debounce_pcnt_add(entry);
+    }
+}
+
+/**
+ * Put a pin whose GPIO is already configured under the engine: hand it to the
+ * sampling engine, a pulse counter, a capture or RMT channel, or fill its entry and
+ * attach the ISR handler that drives the wheel.
+ */
+static esp_err_t attach_pin(const debounce_config_t *config) {
+    debounce_entry_t *entry = &debounce_pins[config->pin];
+    esp_err_t err;
+
+    if (uses_peripheral(config)) {
+        portENTER_CRITICAL(&s_pins_lock);
+        entry->config = *config;
+        entry->mqtt_topic = config->mqtt_topic;
+        entry->in_use = true;
+        debounce_count++;
+        portEXIT_CRITICAL(&s_pins_lock);
+
+        err = peripheral_add(entry);
+        if (err != ESP_OK) {
+            portENTER_CRITICAL(&s_pins_lock);
+            entry->in_use = false;
+            debounce_count--;
+            portEXIT_CRITICAL(&s_pins_lock);
+            return err;
+        }
+        ESP_LOGI(TAG, "Debounce registered: GPIO %d, %s", config->pin,
+                 config->engine == DEBOUNCE_ENGINE_ENCODER ? "encoder" :
+                 config->engine == DEBOUNCE_ENGINE_PWM ? "PWM capture" :
+                 config->engine == DEBOUNCE_ENGINE_BURST ? "burst capture" : "pulse counter");
+        return ESP_OK;
+    }
+
+    if (config->engine == DEBOUNCE_ENGINE_SAMPLED) {
+        portENTER_CRITICAL(&s_pins_lock);
+        entry->config = *config;
+        entry->mqtt_topic = config->mqtt_topic;
+        entry->in_use = true;
+        debounce_count++;
+        portEXIT_CRITICAL(&s_pins_lock);
+
+        err = debounce_sampler_add(config);
+        if (err != ESP_OK) {
+            portENTER_CRITICAL(&s_pins_lock);
+            entry->in_use = false;
+            debounce_count--;
+            portEXIT_CRITICAL(&s_pins_lock);
+            return err;
+        }
+        ESP_LOGI(TAG, "Debounce registered: GPIO %d, sampled every %uus",
+                 config->pin, (unsigned)CONFIG_DEBOUNCE_SAMPLE_PERIOD_US);
+        return ESP_OK;
+    }
+
+    debounce_wheel_t *wheel = wheel_for(config);
+
+    portENTER_CRITICAL(&s_pins_lock);
+    entry->config = *config;
+    entry->wheel = wheel;
+    entry->mqtt_topic = config->mqtt_topic;
+    entry->window_us = config->debounce_time_us;
+    entry->stable_level = (uint8_t)((pin_hal_read_levels() >> config->pin) & 1);
+    entry->rate_window_us = 0;
+    entry->rate_edges = 0;
+    entry->chatter = false;
+    entry->in_use = true;
+    debounce_count++;
+    portEXIT_CRITICAL(&s_pins_lock);
+
+#if CONFIG_DEBOUNCE_TPL
+    err = debounce_tpl_add(config);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "gpio_isr_handler_add failed for GPIO %d: %s", config->pin, esp_err_to_name(err));
-        // Clean up timer on failure to attach ISR
-        (void)esp_timer_delete(timer);
+        portENTER_CRITICAL(&s_pins_lock);
+        entry->in_use = false;
         debounce_count--;
-        return;
+        portEXIT_CRITICAL(&s_pins_lock);
+        return err;
     }
-    ESP_LOGI(TAG, "Debounce registered: GPIO %d, %sedge, %uus",
+#endif
+#if CONFIG_DEBOUNCE_GLOBAL_ISR
+    // pin_hal_config_input() already enabled the pin; gpio_global_isr() routes it.
+    err = ESP_OK;
+#else
+    err = pin_hal_isr_handler_add(config->pin, gpio_isr_handler, entry);
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ISR handler add failed for GPIO %d: %s", config->pin, esp_err_to_name(err));
+#if CONFIG_DEBOUNCE_TPL
+        debounce_tpl_remove(config->pin);
+#endif
+        portENTER_CRITICAL(&s_pins_lock);
+        entry->in_use = false;
+        debounce_count--;
+        portEXIT_CRITICAL(&s_pins_lock);
+        return err;
+    }
+#if CONFIG_DEBOUNCE_ADAPTIVE && !CONFIG_DEBOUNCE_TPL
+    debounce_adapt_add(entry);
+#endif
+    ESP_LOGI(TAG, "Debounce registered: GPIO %d, %sedge, %uus, %s%s, %s dispatch",
              config->pin,
              (config->intr_type == GPIO_INTR_POSEDGE ? "pos" :
               config->intr_type == GPIO_INTR_NEGEDGE ? "neg" : "any "),
-             (unsigned)config->debounce_time_us);
+             (unsigned)config->debounce_time_us,
+             (config->policy == DEBOUNCE_POLICY_LEADING ? "leading" :
+              config->policy == DEBOUNCE_POLICY_ASYMMETRIC ? "asymmetric" : "trailing"),
+             (config->state_change_only ? " (changes only)" : ""),
+             (TPL_ENGINE ? "template" : wheel == &s_wheel ? "task" : "ISR"));
+    return ESP_OK;
+}
+
+static esp_err_t check_new_pin(const debounce_config_t *config) {
+    if (!config || !GPIO_IS_VALID_GPIO(config->pin)) {
+        ESP_LOGE(TAG, "Invalid GPIO %d", config ? config->pin : -1);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (debounce_pins[config->pin].in_use || debounce_pcnt_claims(config->pin) ||
+        debounce_burst_claims(config->pin)) {
+        ESP_LOGW(TAG, "GPIO %d already registered", config->pin);
+        return ESP_ERR_INVALID_STATE;
+    }
+    // 0 is what a designated initialiser leaves in a forgotten B pin field;
+    // GPIO 0 is a strapping pin and never taken as a second input.
+    if (second_pin(config) == GPIO_NUM_0) {
+        ESP_LOGE(TAG, "GPIO %d: second input (encoder_b_pin / burst_b_pin) not set",
+                 config->pin);
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+// Undo pin_hal_config_input(s) for pins that were never attached: interrupt
+// and pull-up off. A loopback drive (replay) is left alone.
+static void release_gpios(uint64_t mask) {
+    for (uint64_t pins = mask; pins; pins &= pins - 1) {
+        gpio_num_t pin = (gpio_num_t)__builtin_ctzll(pins);
+        (void)pin_hal_intr_disable(pin);
+        (void)pin_hal_set_intr_type(pin, GPIO_INTR_DISABLE);
+        (void)pin_hal_set_pull_up(pin, false);
+    }
+}
+
+// Bit of the second input (encoder B, burst B) the engine of config configures
+// itself, unless it is invalid or another pin owns that GPIO.
+static uint64_t second_pin_bit(const debounce_config_t *config) {
+    gpio_num_t second = second_pin(config);
+    if (!GPIO_IS_VALID_GPIO(second) || second == config->pin || debounce_pins[second].in_use ||
+        debounce_pcnt_claims(second) || debounce_burst_claims(second)) {
+        return 0;
+    }
+    return 1ULL << second;
+}
+
+/**
+ * Register a pin for debouncing: configures GPIO, then attaches it. If the
+ * attach fails its GPIOs (with an encoder or burst B input) are released again.
+ */
+esp_err_t debounce_register_pin(const debounce_config_t *config) {
+    esp_err_t err = check_new_pin(config);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    bool gpio_intr = (config->engine == DEBOUNCE_ENGINE_TIMER);
+    err = pin_hal_config_input(config->pin, config->pull_up,
+                               gpio_intr ? hw_intr_type(config) : GPIO_INTR_DISABLE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO config failed for GPIO %d: %s", config->pin, esp_err_to_name(err));
+        return err;
+    }
+    err = attach_pin(config);
+    if (err != ESP_OK) {
+        release_gpios((1ULL << config->pin) | second_pin_bit(config));
+    }
+    return err;
 }
 
 /**
- * Install the ISR service once. It's OK if it's already installed.
+ * Register a whole pin table: validate everything first, configure every GPIO
+ * with one pin_hal_config_inputs() call, then enable interrupts and attach.
+ * On failure the pins attached so far are unregistered again and the GPIOs of
+ * the rest are released.
+ */
+esp_err_t debounce_register_pins(const debounce_config_t *configs, size_t count) {
+    uint64_t mask = 0;
+    uint64_t claimed = 0;  // Second inputs (encoder B, burst B)
+    uint64_t pull_ups = 0;
+
+    if (!configs) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < count; i++) {
+        esp_err_t err = check_new_pin(&configs[i]);
+        if (err != ESP_OK) {
+            return err;
+        }
+        uint64_t bit = 1ULL << configs[i].pin;
+        if ((mask | claimed) & bit) {
+            ESP_LOGE(TAG, "GPIO %d listed twice", configs[i].pin);
+            return ESP_ERR_INVALID_ARG;
+        }
+        gpio_num_t second = second_pin(&configs[i]);
+        if (GPIO_IS_VALID_GPIO(second)) {
+            uint64_t b = 1ULL << second;
+            if ((mask | claimed) & b) {
+                ESP_LOGE(TAG, "GPIO %d listed twice", second);
+                return ESP_ERR_INVALID_ARG;
+            }
+            claimed |= b;
+        }
+        mask |= bit;
+        pull_ups |= configs[i].pull_up ? bit : 0;
+    }
+
+    esp_err_t err = pin_hal_config_inputs(mask, pull_ups);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO config failed for mask 0x%llx: %s",
+                 (unsigned long long)mask, esp_err_to_name(err));
+        return err;
+    }
+
+    size_t attached = 0;
+    for (; attached < count; attached++) {
+        const debounce_config_t *config = &configs[attached];
+        if (config->engine == DEBOUNCE_ENGINE_TIMER) {
+            err = pin_hal_set_intr_type(config->pin, hw_intr_type(config));
+            if (err == ESP_OK) {
+                err = pin_hal_intr_enable(config->pin);
+            }
+        }
+        if (err == ESP_OK) {
+            err = attach_pin(config);
+        }
+        if (err != ESP_OK) {
+            break;
+        }
+    }
+    if (err != ESP_OK) {
+        uint64_t rest = mask | second_pin_bit(&configs[attached]);
+        while (attached--) {
+            rest &= ~(1ULL << configs[attached].pin);
+            (void)debounce_unregister_pin(configs[attached].pin);
+        }
+        release_gpios(rest);
+        return err;
+    }
+    ESP_LOGI(TAG, "Registered %u pins, mask 0x%llx", (unsigned)count, (unsigned long long)mask);
+    return ESP_OK;
+}
+
+/**
+ * Unregister a pin: detach the ISR first so no new edges arrive, then retire
+ * the slot and its pending deadline. An expiry batch already in flight sees
+ * in_use == false and drops the pin.
+ */
+esp_err_t debounce_unregister_pin(gpio_num_t pin) {
+    if (!GPIO_IS_VALID_GPIO(pin) || !debounce_pins[pin].in_use) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    debounce_entry_t *entry = &debounce_pins[pin];
+
+    if (uses_pcnt(&entry->config)) {
+        debounce_pcnt_remove(pin);
+    } else if (entry->config.engine == DEBOUNCE_ENGINE_PWM) {
+        debounce_pwm_remove(pin);
+    } else if (entry->config.engine == DEBOUNCE_ENGINE_BURST) {
+        debounce_burst_remove(pin);
+    } else if (entry->config.engine == DEBOUNCE_ENGINE_SAMPLED) {
+        debounce_sampler_remove(pin);
+    } else {
+        (void)pin_hal_intr_disable(pin);
+#if !CONFIG_DEBOUNCE_GLOBAL_ISR
+        (void)pin_hal_isr_handler_remove(pin);
+#endif
+#if CONFIG_DEBOUNCE_TPL
+        debounce_tpl_remove(pin);
+#else
+        debounce_wheel_cancel(entry->wheel, entry);
+#endif
+    }
+    // The engine configured its second input itself and has let go of it now.
+    release_gpios(second_pin_bit(&entry->config));
+
+    portENTER_CRITICAL(&s_pins_lock);
+    entry->in_use = false;
+    debounce_count--;
+    portEXIT_CRITICAL(&s_pins_lock);
+    ESP_LOGI(TAG, "Debounce unregistered: GPIO %d", pin);
+    return ESP_OK;
+}
+
+/**
+ * Reconfigure a registered pin without detaching it. Hardware settings go
+ * first; the software copy is swapped under the lock the ISR snapshots from.
+ */
+esp_err_t debounce_update_pin(const debounce_config_t *config) {
+    if (!config || !GPIO_IS_VALID_GPIO(config->pin) || !debounce_pins[config->pin].in_use) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    debounce_entry_t *entry = &debounce_pins[config->pin];
+
+    // Switching engine or dispatch swaps the whole edge path, and pulse
+    // counters, capture and RMT channels are set up at creation, like the
+    // windows of template-engine pins; re-register instead.
+    if (config->engine != entry->config.engine || config->dispatch != entry->config.dispatch ||
+        uses_peripheral(config) ||
+        (TPL_ENGINE && config->engine == DEBOUNCE_ENGINE_TIMER)) {
+        (void)debounce_unregister_pin(config->pin);
+        return debounce_register_pin(config);
+    }
+
+    bool sampled = (config->engine == DEBOUNCE_ENGINE_SAMPLED);
+    esp_err_t err = pin_hal_set_pull_up(config->pin, config->pull_up);
+    if (err == ESP_OK && !sampled) {
+        err = pin_hal_set_intr_type(config->pin, hw_intr_type(config));
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Reconfigure failed for GPIO %d: %s", config->pin, esp_err_to_name(err));
+        return err;
+    }
+
+    portENTER_CRITICAL(&s_pins_lock);
+    entry->config = *config;
+    entry->mqtt_topic = config->mqtt_topic;
+    portEXIT_CRITICAL(&s_pins_lock);
+
+    if (sampled) {
+        // Re-adding refreshes the edge masks and reseeds the counter.
+        err = debounce_sampler_add(config);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+#if CONFIG_DEBOUNCE_ADAPTIVE && !CONFIG_DEBOUNCE_TPL
+    else {
+        debounce_adapt_add(entry);
+    }
+#endif
+
+    ESP_LOGI(TAG, "Debounce updated: GPIO %d, %uus",
+             config->pin, (unsigned)config->debounce_time_us);
+    return ESP_OK;
+}
+
+// Runs on the core that should own the GPIO interrupt (directly or via IPC).
+static void install_gpio_isr(void *arg) {
+    esp_err_t *err = (esp_err_t *)arg;
+#if CONFIG_DEBOUNCE_GLOBAL_ISR
+    *err = s_gpio_intr ? ESP_ERR_INVALID_STATE
+                       : pin_hal_isr_register(gpio_global_isr, NULL, DEBOUNCE_INTR_ALLOC_FLAGS,
+                                              &s_gpio_intr);
+#else
+    *err = pin_hal_isr_service_install(DEBOUNCE_INTR_ALLOC_FLAGS);
+#endif
+}
+
+/**
+ * Set up the deadline wheel and install the GPIO interrupt once: the per-pin
+ * ISR service, or the single global handler with CONFIG_DEBOUNCE_GLOBAL_ISR.
+ * It's OK if it is already installed.
  */
 void debounce_init(void) {
-    esp_err_t retval = gpio_install_isr_service(0);
+    static bool s_wheel_ready = false;
+    if (!s_wheel_ready) {
+        s_wheel_ready = (debounce_wheel_init(&s_wheel, "debounce_wheel", false,
+                                             debounce_wheel_expired) == ESP_OK);
+#if CONFIG_DEBOUNCE_ISR_DISPATCH
+        s_wheel_ready &= (debounce_wheel_init(&s_isr_wheel, "debounce_wheel_isr", true,
+                                              debounce_wheel_expired_isr) == ESP_OK);
+#endif
+    }
+
+    esp_err_t retval = ESP_FAIL;
+    // Interrupts are allocated on the calling core; hop over if that is not the one asked for.
+    esp_err_t hop = pin_hal_run_on_core(CONFIG_DEBOUNCE_ISR_CPU, install_gpio_isr, &retval);
+    if (hop != ESP_OK) {
+        retval = hop;
+    }
     if (retval != ESP_OK && retval != ESP_ERR_INVALID_STATE) {
-        ESP_LOGE(TAG, "Failed to install ISR service: %s", esp_err_to_name(retval));
+        ESP_LOGE(TAG, "Failed to install GPIO interrupt: %s", esp_err_to_name(retval));
+    }
+}
+
+void debounce_set_window(debounce_entry_t *entry, uint32_t window_us) {
+    portENTER_CRITICAL(&s_pins_lock);
+    entry->config.debounce_time_us = window_us;
+    portEXIT_CRITICAL(&s_pins_lock);
+}
+
+const char *debounce_get_topic(gpio_num_t pin) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return NULL;
+    }
+    portENTER_CRITICAL(&s_pins_lock);
+    const char *topic = debounce_pins[pin].in_use ? debounce_pins[pin].config.mqtt_topic : NULL;
+    portEXIT_CRITICAL(&s_pins_lock);
+    return topic;
+}
+
+esp_err_t debounce_get_latency_stats(debounce_dispatch_t dispatch, debounce_latency_stats_t *out) {
+    if (dispatch >= DEBOUNCE_DISPATCH_MAX || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_latency_lock);
+    *out = s_latency[dispatch];
+    portEXIT_CRITICAL(&s_latency_lock);
+    return ESP_OK;
+}
+
+void debounce_log_latency_stats(bool reset) {
+    static const char *names[DEBOUNCE_DISPATCH_MAX] = { "task", "ISR" };
+    debounce_latency_stats_t snap[DEBOUNCE_DISPATCH_MAX];
+
+    portENTER_CRITICAL(&s_latency_lock);
+    for (int i = 0; i < DEBOUNCE_DISPATCH_MAX; i++) {
+        snap[i] = s_latency[i];
+        if (reset) {
+            s_latency[i] = (debounce_latency_stats_t){0};
+        }
+    }
+    uint32_t isr_dropped = s_isr_dropped;
+    if (reset) {
+        s_isr_dropped = 0;
+    }
+    portEXIT_CRITICAL(&s_latency_lock);
+
+    for (int i = 0; i < DEBOUNCE_DISPATCH_MAX; i++) {
+        const debounce_latency_stats_t *st = &snap[i];
+        if (st->count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%s dispatch: %u events, edge->enqueue min/avg/max %u/%u/%u us, "
+                 "over window %u/%u/%u us",
+                 names[i], (unsigned)st->count,
+                 (unsigned)st->min_us, (unsigned)(st->sum_us / st->count), (unsigned)st->max_us,
+                 (unsigned)st->overshoot_min_us, (unsigned)(st->overshoot_sum_us / st->count),
+                 (unsigned)st->overshoot_max_us);
+    }
+    if (isr_dropped) {
+        ESP_LOGW(TAG, "%u events dropped in ISR dispatch (ring full)", (unsigned)isr_dropped);
     }
 }
@@ -0,0 +1,226 @@
+#include "sdkconfig.h"
+#include <string.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "private/debounce_internal.h"
+
+#if CONFIG_DEBOUNCE_ADAPTIVE
+
+static const char *TAG = "DebounceAdapt";
+
+#define NVS_NS_DEBOUNCE "debounce"
+
+// Log-linear histogram: four buckets per power of two, 0 us .. ~2 s.
+#define ADAPT_SUB_BITS  2
+#define ADAPT_BUCKETS   80
+#define ADAPT_AGE_AT    4096  // Halve the histogram at this many samples so old wear fades out
+
+typedef struct {
+    uint16_t buckets[ADAPT_BUCKETS];  // Bounce durations (first to last edge of a burst)
+    uint32_t count;
+    uint32_t min_us;                  // Resolved bounds for the learned window
+    uint32_t max_us;
+    uint32_t window_us;               // Learned window in effect, 0 until there is one
+    uint32_t saved_us;                // Value last written to NVS
+} adapt_state_t;
+
+// Allocated on the first adaptive registration of a pin and kept, so an
+// expiry racing an unregister never touches freed memory.
+static adapt_state_t *s_adapt[GPIO_NUM_MAX];
+static portMUX_TYPE s_adapt_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline IRAM_ATTR unsigned bucket_of(uint32_t us) {
+    if (us < (1u << ADAPT_SUB_BITS)) {
+        return us;
+    }
+    unsigned msb = 31 - __builtin_clz(us);
+    unsigned idx = ((msb - ADAPT_SUB_BITS + 1) << ADAPT_SUB_BITS) +
+                   ((us >> (msb - ADAPT_SUB_BITS)) & ((1u << ADAPT_SUB_BITS) - 1));
+    return idx < ADAPT_BUCKETS ? idx : ADAPT_BUCKETS - 1;
+}
+
+// Exclusive upper bound of a bucket, so the percentile errs on the long side.
+static uint32_t bucket_upper_us(unsigned idx) {
+    if (idx < (1u << ADAPT_SUB_BITS)) {
+        return idx + 1;
+    }
+    unsigned msb = (idx >> ADAPT_SUB_BITS) + ADAPT_SUB_BITS - 1;
+    unsigned sub = idx & ((1u << ADAPT_SUB_BITS) - 1);
+    unsigned shift = msb - ADAPT_SUB_BITS;
+    return (((1u << ADAPT_SUB_BITS) + sub + 1) << shift);
+}
+
+static void nvs_key(gpio_num_t pin, char *key, size_t len) {
+    snprintf(key, len, "win%d", (int)pin);
+}
+
+static bool load_window(gpio_num_t pin, uint32_t *window_us) {
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NS_DEBOUNCE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
+    }
+    char key[16];
+    nvs_key(pin, key, sizeof(key));
+    esp_err_t err = nvs_get_u32(nvs, key, window_us);
+    nvs_close(nvs);
+    return err == ESP_OK;
+}
+
+static void save_window(gpio_num_t pin, uint32_t window_us) {
+#if CONFIG_DEBOUNCE_ADAPT_PERSIST
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(NVS_NS_DEBOUNCE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        char key[16];
+        nvs_key(pin, key, sizeof(key));
+        err = nvs_set_u32(nvs, key, window_us);
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save window for GPIO %d: %s", pin, esp_err_to_name(err));
+    }
+#else
+    (void)pin;
+    (void)window_us;
+#endif
+}
+
+/**
+ * Set up learning for a timer-engine pin on register/update. The configured
+ * debounce_time_us is the upper bound unless adapt_max_us says otherwise.
+ * A window learned earlier (this boot, or from NVS) is applied right away.
+ */
+void debounce_adapt_add(debounce_entry_t *entry) {
+    const debounce_config_t *config = &entry->config;
+    if (!config->adaptive) {
+        return;
+    }
+
+    gpio_num_t pin = config->pin;
+    adapt_state_t *st = s_adapt[pin];
+    if (!st) {
+        // Touched from the expiry path, which may run with the cache off.
+        st = heap_caps_calloc(1, sizeof(*st), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!st) {
+            ESP_LOGE(TAG, "No memory for GPIO %d histogram; window stays fixed", pin);
+            return;
+        }
+        if (load_window(pin, &st->saved_us)) {
+            st->window_us = st->saved_us;
+        }
+        s_adapt[pin] = st;
+    }
+
+    st->max_us = config->adapt_max_us ? config->adapt_max_us : config->debounce_time_us;
+    st->min_us = config->adapt_min_us ? config->adapt_min_us : CONFIG_DEBOUNCE_ADAPT_MIN_US;
+    if (st->min_us > st->max_us) {
+        st->min_us = st->max_us;
+    }
+
+    if (st->window_us >= st->min_us && st->window_us <= st->max_us) {
+        debounce_set_window(entry, st->window_us);
+        ESP_LOGI(TAG, "GPIO %d: learned window %uus (bounds %u..%uus)", pin,
+                 (unsigned)st->window_us, (unsigned)st->min_us, (unsigned)st->max_us);
+    }
+}
+
+/**
+ * End of a burst (wheel expiry, task or ISR). Records how long the contact
+ * bounced: first to last edge.
+ */
+IRAM_ATTR void debounce_adapt_record(debounce_entry_t *entry) {
+    adapt_state_t *st = s_adapt[entry->config.pin];
+    if (!st || !entry->config.adaptive) {
+        return;
+    }
+    uint32_t bounce_us = (uint32_t)(entry->last_edge_us - entry->first_edge_us);
+    unsigned idx = bucket_of(bounce_us);
+
+    portENTER_CRITICAL_SAFE(&s_adapt_lock);
+    if (st->buckets[idx] < UINT16_MAX) {
+        st->buckets[idx]++;
+        st->count++;
+    }
+    portEXIT_CRITICAL_SAFE(&s_adapt_lock);
+}
+
+void debounce_adapt_run(void) {
+    uint16_t hist[ADAPT_BUCKETS];
+
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        adapt_state_t *st = s_adapt[pin];
+        debounce_entry_t *entry = &debounce_pins[pin];
+        if (!st || !entry->in_use || !entry->config.adaptive ||
+            entry->config.engine != DEBOUNCE_ENGINE_TIMER) {
+            continue;
+        }
+
+        portENTER_CRITICAL(&s_adapt_lock);
+        memcpy(hist, st->buckets, sizeof(hist));
+        if (st->count >= ADAPT_AGE_AT) {
+            st->count = 0;
+            for (unsigned i = 0; i < ADAPT_BUCKETS; i++) {
+                st->buckets[i] >>= 1;
+                st->count += st->buckets[i];
+            }
+        }
+        portEXIT_CRITICAL(&s_adapt_lock);
+
+        uint32_t count = 0;
+        for (unsigned i = 0; i < ADAPT_BUCKETS; i++) {
+            count += hist[i];
+        }
+        if (count < CONFIG_DEBOUNCE_ADAPT_MIN_SAMPLES) {
+            continue;
+        }
+
+        uint32_t rank = (uint32_t)(((uint64_t)count * CONFIG_DEBOUNCE_ADAPT_PERCENTILE + 99) / 100);
+        uint32_t seen = 0;
+        unsigned idx = 0;
+        for (; idx < ADAPT_BUCKETS - 1; idx++) {
+            seen += hist[idx];
+            if (seen >= rank) {
+                break;
+            }
+        }
+
+        uint32_t bounce_us = bucket_upper_us(idx);
+        uint32_t window_us = bounce_us +
+                             (uint32_t)((uint64_t)bounce_us * CONFIG_DEBOUNCE_ADAPT_MARGIN_PCT / 100);
+        if (window_us < st->min_us) {
+            window_us = st->min_us;
+        } else if (window_us > st->max_us) {
+            window_us = st->max_us;
+        }
+
+        // 10% hysteresis keeps the window (and NVS) from flapping between buckets.
+        uint32_t current_us = entry->config.debounce_time_us;
+        uint32_t diff_us = window_us > current_us ? window_us - current_us : current_us - window_us;
+        if (diff_us * 10 < current_us) {
+            continue;
+        }
+
+        ESP_LOGI(TAG, "GPIO %d: window %u -> %uus (p%d bounce <%uus, n=%u)", pin,
+                 (unsigned)current_us, (unsigned)window_us, CONFIG_DEBOUNCE_ADAPT_PERCENTILE,
+                 (unsigned)bounce_us, (unsigned)count);
+        debounce_set_window(entry, window_us);
+        st->window_us = window_us;
+        if (window_us != st->saved_us) {
+            save_window((gpio_num_t)pin, window_us);
+            st->saved_us = window_us;
+        }
+    }
+}
+
+#else
+
+void debounce_adapt_run(void) {
+}
+
+#endif // CONFIG_DEBOUNCE_ADAPTIVE
@@ -0,0 +1,444 @@
+#include <string.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "debounce_decoder.h"
+#include "private/debounce_internal.h"
+
+#if CONFIG_DEBOUNCE_BURST
+
+static const char *TAG = "DebounceBurst";
+
+#define BURST_RESOLUTION_HZ 1000000  // One tick per microsecond
+#define BURST_MAX_FILTER_NS 3187     // 255 cycles of the 80 MHz RMT clock
+#define BURST_MAX_IDLE_US   32767    // 15-bit symbol durations
+#define BURST_QUEUE         4        // Power of two
+#define BURST_MAX_EDGES     (4 * CONFIG_DEBOUNCE_BURST_SYMBOLS)
+
+struct burst_slot;
+
+// One RMT channel receiving one line into two buffers in turn: while the task
+// decodes a finished burst from one, the next burst goes to the other.
+typedef struct {
+    pin_hal_rmt_rx_t     chan;           // NULL while the line is free
+    struct burst_slot   *slot;
+    uint8_t              index;          // 0: pin, 1: burst_b_pin
+    uint8_t              armed;          // Buffer being received into
+    uint8_t              busy;           // Bit per buffer, set until the task is done with it
+    pin_hal_rmt_symbol_t buf[2][CONFIG_DEBOUNCE_BURST_SYMBOLS];
+} burst_line_t;
+
+typedef struct {
+    uint8_t  line;
+    uint8_t  buf;
+    uint16_t symbols;
+    int64_t  done_us;
+} burst_done_t;
+
+// A burst pin and its frame timer.
+typedef struct burst_slot {
+    debounce_entry_t         *entry;       // NULL while the slot is free
+    const debounce_decoder_t *decoder;
+    burst_line_t             *lines[2];
+    pin_hal_timer_t           timer;
+    burst_done_t              done[BURST_QUEUE]; // Written by the done ISR
+    uint32_t                  done_head;
+    uint32_t                  done_tail;
+    uint32_t                  lost;        // Bursts overwritten while both buffers were busy
+    debounce_edge_t          *edges;       // Frame being assembled; t_us is pin_hal time
+    size_t                    edge_count;
+    bool                      open;
+    bool                      overflow;    // Frame lost edges
+    int64_t                   start_us;    // First edge of the frame
+    int64_t                   last_done_us;
+    debounce_frame_t          frame;       // Last decoded frame
+    bool                      have_frame;
+} burst_slot_t;
+
+static burst_slot_t s_slots[PIN_HAL_RMT_RX_CHANNELS];
+static burst_line_t s_lines[PIN_HAL_RMT_RX_CHANNELS];
+static portMUX_TYPE s_burst_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static IRAM_ATTR esp_err_t line_receive(burst_line_t *line) {
+    const debounce_decoder_t *decoder = line->slot->decoder;
+    return pin_hal_rmt_rx_receive(line->chan, line->buf[line->armed],
+                                  CONFIG_DEBOUNCE_BURST_SYMBOLS, decoder->min_pulse_ns,
+                                  decoder->idle_us * 1000);
+}
+
+/**
+ * Receive-done ISR, once per burst: queue the buffer for the task and re-arm
+ * the channel on the other one straight away, so a burst that follows within
+ * microseconds is not missed. If the task still holds the other buffer, the
+ * burst just received is overwritten instead.
+ */
+static IRAM_ATTR bool on_done(pin_hal_rmt_rx_t chan, const pin_hal_rmt_rx_event_t *edata,
+                              void *arg) {
+    (void)chan;
+    burst_line_t *line = (burst_line_t *)arg;
+    burst_slot_t *slot = line->slot;
+    int64_t now_us = pin_hal_time_us();
+    uint8_t done = line->armed;
+
+    portENTER_CRITICAL_ISR(&s_burst_lock);
+    if (line->busy & (1u << (done ^ 1))) {
+        slot->lost++;
+    } else {
+        // At most one buffer per line is busy, so the queue cannot fill.
+        slot->done[slot->done_head++ % BURST_QUEUE] = (burst_done_t){
+            .line = line->index,
+            .buf = done,
+            .symbols = (uint16_t)edata->num_symbols,
+            .done_us = now_us,
+        };
+        line->busy |= (uint8_t)(1u << done);
+        line->armed = done ^ 1;
+    }
+    portEXIT_CRITICAL_ISR(&s_burst_lock);
+
+    (void)line_receive(line);
+    (void)pin_hal_timer_start_once(slot->timer, 0);
+    return false;
+}
+
+static IRAM_ATTR uint32_t half_ticks(const pin_hal_rmt_symbol_t *sym, size_t half) {
+    return (half & 1) ? sym[half / 2].duration1 : sym[half / 2].duration0;
+}
+
+static IRAM_ATTR uint8_t half_level(const pin_hal_rmt_symbol_t *sym, size_t half) {
+    return (uint8_t)((half & 1) ? sym[half / 2].level1 : sym[half / 2].level0);
+}
+
+/**
+ * Merge one burst into the frame. Each symbol half is a level and how long it
+ * lasted; the burst ended idle_us after its last edge, which dates the whole
+ * burst. Bursts of the other line may start earlier, so the edges are merged
+ * in time order from the back.
+ */
+static void frame_add(burst_slot_t *slot, const burst_done_t *done) {
+    const pin_hal_rmt_symbol_t *sym = slot->lines[done->line]->buf[done->buf];
+    size_t halves = 2 * (size_t)done->symbols;
+    size_t n = 0;
+    uint32_t total_us = 0;
+    bool ended = false;
+
+    slot->last_done_us = done->done_us;
+    // Edges run up to the zero-duration end marker, which is the last edge.
+    while (n < halves && !ended) {
+        uint32_t ticks = half_ticks(sym, n++);
+        ended = (ticks == 0);
+        total_us += ticks;
+    }
+    if (!ended || slot->edge_count + n > BURST_MAX_EDGES) {
+        slot->overflow = true;
+        return;
+    }
+
+    int64_t start_us = done->done_us - slot->decoder->idle_us - total_us;
+    if (!slot->open || start_us < slot->start_us) {
+        slot->start_us = start_us;
+    }
+    slot->open = true;
+
+    debounce_edge_t *edges = slot->edges;
+    size_t i = slot->edge_count;
+    size_t k = slot->edge_count + n;
+    uint32_t t_us = (uint32_t)(start_us + total_us);
+    slot->edge_count = k;
+    while (n) {
+        n--;
+        while (i && (int32_t)(edges[i - 1].t_us - t_us) > 0) {
+            edges[--k] = edges[--i];
+        }
+        edges[--k] = (debounce_edge_t){ .t_us = t_us, .line = done->line,
+                                        .level = half_level(sym, n) };
+        if (n) {
+            t_us -= half_ticks(sym, n - 1);
+        }
+    }
+}
+
+// Hand the frame to the decoder and publish what it found.
+static void frame_close(burst_slot_t *slot) {
+    debounce_entry_t *entry = slot->entry;
+    size_t count = slot->edge_count;
+    bool overflow = slot->overflow;
+
+    slot->open = false;
+    slot->overflow = false;
+    slot->edge_count = 0;
+    if (overflow) {
+        ESP_LOGW(TAG, "GPIO %d frame dropped: more than %u edges or a full burst buffer",
+                 entry->config.pin, (unsigned)BURST_MAX_EDGES);
+        return;
+    }
+
+    uint32_t first_us = (uint32_t)slot->start_us;
+    for (size_t i = 0; i < count; i++) {
+        slot->edges[i].t_us -= first_us;
+    }
+    debounce_frame_t frame = {
+        .protocol = slot->decoder->name,
+        .start_us = slot->start_us,
+        .duration_us = count ? slot->edges[count - 1].t_us : 0,
+    };
+    if (!slot->decoder->decode(slot->edges, count, &frame)) {
+        ESP_LOGD(TAG, "GPIO %d: %u edges, no %s frame", entry->config.pin, (unsigned)count,
+                 slot->decoder->name);
+        return;
+    }
+    portENTER_CRITICAL(&s_burst_lock);
+    slot->frame = frame;
+    slot->have_frame = true;
+    portEXIT_CRITICAL(&s_burst_lock);
+
+    entry->first_edge_us = frame.start_us;
+    debounce_emit_event(entry, GPIO_EVENT_FRAME, frame.valid);
+}
+
+/**
+ * Frame timer (timer task), started from the done ISR: merge the finished
+ * bursts, then close the frame once no line has finished one for
+ * frame_gap_us, or check again when that time is up.
+ */
+static void frame_callback(void *arg) {
+    burst_slot_t *slot = (burst_slot_t *)arg;
+    if (!slot->entry) {
+        return;
+    }
+    for (;;) {
+        burst_done_t done;
+        portENTER_CRITICAL(&s_burst_lock);
+        bool have = (slot->done_tail != slot->done_head);
+        if (have) {
+            done = slot->done[slot->done_tail++ % BURST_QUEUE];
+        }
+        portEXIT_CRITICAL(&s_burst_lock);
+        if (!have) {
+            break;
+        }
+        frame_add(slot, &done);
+        portENTER_CRITICAL(&s_burst_lock);
+        slot->lines[done.line]->busy &= (uint8_t)~(1u << done.buf);
+        portEXIT_CRITICAL(&s_burst_lock);
+    }
+    if (!slot->open && !slot->overflow) {
+        return;
+    }
+    uint32_t quiet_us = (uint32_t)(pin_hal_time_us() - slot->last_done_us);
+    if (quiet_us < slot->decoder->frame_gap_us) {
+        // Not once debounce_burst_remove() has taken the slot, and its timer, away.
+        portENTER_CRITICAL(&s_burst_lock);
+        if (slot->entry) {
+            (void)pin_hal_timer_start_once(slot->timer, slot->decoder->frame_gap_us - quiet_us);
+        }
+        portEXIT_CRITICAL(&s_burst_lock);
+        return;
+    }
+    frame_close(slot);
+}
+
+static burst_slot_t *slot_of(gpio_num_t pin) {
+    for (size_t i = 0; i < PIN_HAL_RMT_RX_CHANNELS; i++) {
+        if (s_slots[i].entry && s_slots[i].entry->config.pin == pin) {
+            return &s_slots[i];
+        }
+    }
+    return NULL;
+}
+
+bool debounce_burst_claims(gpio_num_t pin) {
+    for (size_t i = 0; i < PIN_HAL_RMT_RX_CHANNELS; i++) {
+        const debounce_entry_t *entry = s_slots[i].entry;
+        if (entry && s_slots[i].decoder->lines == 2 && entry->config.burst_b_pin == pin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void line_release(burst_line_t *line) {
+    if (line && line->chan) {
+        (void)pin_hal_rmt_rx_delete(line->chan);
+        line->chan = NULL;
+    }
+}
+
+// Claim a free line and start receiving pin on it.
+static esp_err_t line_start(burst_slot_t *slot, uint8_t index, gpio_num_t pin) {
+    burst_line_t *line = NULL;
+    for (size_t i = 0; i < PIN_HAL_RMT_RX_CHANNELS && !line; i++) {
+        line = s_lines[i].chan ? NULL : &s_lines[i];
+    }
+    if (!line) {
+        ESP_LOGE(TAG, "No free RMT receive channel for GPIO %d", pin);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    pin_hal_rmt_rx_config_t config = {
+        .pin = pin,
+        .resolution_hz = BURST_RESOLUTION_HZ,
+        .mem_symbols = PIN_HAL_RMT_MEM_SYMBOLS,
+    };
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+#if CONFIG_DEBOUNCE_BURST_DMA
+    // Only some channels can use DMA; the others fall back to channel memory.
+    config.dma = true;
+    config.mem_symbols = CONFIG_DEBOUNCE_BURST_SYMBOLS;
+    err = pin_hal_rmt_rx_create(&config, on_done, line, &line->chan);
+    config.dma = false;
+    config.mem_symbols = PIN_HAL_RMT_MEM_SYMBOLS;
+#endif
+    if (err != ESP_OK) {
+        err = pin_hal_rmt_rx_create(&config, on_done, line, &line->chan);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "RMT receive setup failed for GPIO %d: %s", pin, esp_err_to_name(err));
+        return err;
+    }
+    line->slot = slot;
+    line->index = index;
+    line->armed = 0;
+    line->busy = 0;
+    slot->lines[index] = line;
+    err = line_receive(line);
+    if (err != ESP_OK) {
+        line_release(line);
+        slot->lines[index] = NULL;
+    }
+    return err;
+}
+
+esp_err_t debounce_burst_add(debounce_entry_t *entry) {
+    const debounce_config_t *config = &entry->config;
+    const debounce_decoder_t *decoder = config->decoder;
+    if (!decoder || !decoder->decode || decoder->lines < 1 || decoder->lines > 2 ||
+        decoder->min_pulse_ns > BURST_MAX_FILTER_NS || decoder->idle_us == 0 ||
+        decoder->idle_us > BURST_MAX_IDLE_US) {
+        ESP_LOGE(TAG, "GPIO %d: missing or unsupported decoder", config->pin);
+        return ESP_ERR_INVALID_ARG;
+    }
+    burst_slot_t *slot = NULL;
+    for (size_t i = 0; i < PIN_HAL_RMT_RX_CHANNELS && !slot; i++) {
+        slot = s_slots[i].entry ? NULL : &s_slots[i];
+    }
+    if (!slot) {
+        ESP_LOGE(TAG, "No free burst slot for GPIO %d", config->pin);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (decoder->lines == 2) {
+        gpio_num_t b = config->burst_b_pin;
+        if (!GPIO_IS_VALID_GPIO(b) || b == config->pin || debounce_pins[b].in_use ||
+            debounce_pcnt_claims(b) || debounce_burst_claims(b)) {
+            ESP_LOGE(TAG, "GPIO %d: second line GPIO %d invalid or in use", config->pin, b);
+            return ESP_ERR_INVALID_ARG;
+        }
+        esp_err_t err = pin_hal_config_input(b, config->pull_up, GPIO_INTR_DISABLE);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (!slot->timer) {
+        esp_err_t err = pin_hal_timer_create(frame_callback, slot, "debounce_burst", false,
+                                             &slot->timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (!slot->edges) {
+        // Kept across registrations.
+        slot->edges = heap_caps_calloc(BURST_MAX_EDGES, sizeof(*slot->edges),
+                                       MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!slot->edges) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    slot->decoder = decoder;
+    slot->lines[0] = slot->lines[1] = NULL;
+    slot->done_head = slot->done_tail = 0;
+    slot->lost = 0;
+    slot->edge_count = 0;
+    slot->open = false;
+    slot->overflow = false;
+    slot->have_frame = false;
+    // The ISR reads the slot through its lines, so it is complete before they start.
+    slot->entry = entry;
+    esp_err_t err = line_start(slot, 0, config->pin);
+    if (err == ESP_OK && decoder->lines == 2) {
+        err = line_start(slot, 1, config->burst_b_pin);
+    }
+    if (err != ESP_OK) {
+        line_release(slot->lines[0]);
+        (void)pin_hal_timer_stop(slot->timer);
+        slot->entry = NULL;
+        return err;
+    }
+    if (decoder->lines == 2) {
+        ESP_LOGI(TAG, "GPIO %d/%d receiving %s bursts, idle %uus", config->pin,
+                 config->burst_b_pin, decoder->name, (unsigned)decoder->idle_us);
+    } else {
+        ESP_LOGI(TAG, "GPIO %d receiving %s bursts, idle %uus", config->pin, decoder->name,
+                 (unsigned)decoder->idle_us);
+    }
+    return ESP_OK;
+}
+
+void debounce_burst_remove(gpio_num_t pin) {
+    burst_slot_t *slot = slot_of(pin);
+    if (!slot) {
+        return;
+    }
+    line_release(slot->lines[0]);
+    line_release(slot->lines[1]);
+    if (slot->lost) {
+        ESP_LOGW(TAG, "GPIO %d lost %u bursts", pin, (unsigned)slot->lost);
+    }
+    portENTER_CRITICAL(&s_burst_lock);
+    slot->entry = NULL;
+    slot->have_frame = false;
+    portEXIT_CRITICAL(&s_burst_lock);
+    (void)pin_hal_timer_stop(slot->timer);
+    (void)pin_hal_timer_delete(slot->timer);
+    slot->timer = NULL;
+}
+
+esp_err_t debounce_get_frame(gpio_num_t pin, debounce_frame_t *out) {
+    if (!out || !GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    portENTER_CRITICAL(&s_burst_lock);
+    burst_slot_t *slot = slot_of(pin);
+    if (slot) {
+        err = slot->have_frame ? ESP_OK : ESP_ERR_INVALID_STATE;
+        *out = slot->frame;
+    }
+    portEXIT_CRITICAL(&s_burst_lock);
+    return err;
+}
+
+#else // !CONFIG_DEBOUNCE_BURST
+
+esp_err_t debounce_burst_add(debounce_entry_t *entry) {
+    (void)entry;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void debounce_burst_remove(gpio_num_t pin) {
+    (void)pin;
+}
+
+bool debounce_burst_claims(gpio_num_t pin) {
+    (void)pin;
+    return false;
+}
+
+esp_err_t debounce_get_frame(gpio_num_t pin, debounce_frame_t *out) {
+    (void)pin;
+    (void)out;
+    return ESP_ERR_NOT_FOUND;
+}
+
+#endif // CONFIG_DEBOUNCE_BURST
@@ -0,0 +1,199 @@
+#include "sdkconfig.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "private/debounce_internal.h"
+
+#if CONFIG_DEBOUNCE_CAPTURE
+
+static const char *TAG = "DebounceCapture";
+
+#define CAPTURE_DEPTH       (1u << CONFIG_DEBOUNCE_CAPTURE_DEPTH_LOG2)
+#define CAPTURE_VERSION     1
+#define CAPTURE_HEADER_LEN  28
+#define CAPTURE_PIN_LEN     20
+#define CAPTURE_EDGE_MAX    6   // Pin/level byte plus a 32-bit varint
+
+// Raw edge as seen by the GPIO interrupt.
+typedef struct {
+    uint32_t t_us;
+    uint8_t  pin;
+    uint8_t  level;
+} capture_rec_t;
+
+volatile uint64_t debounce_capture_mask = 0;
+
+// The ring is written from the GPIO ISR only; export runs once the mask is
+// cleared, and clearing it under the lock waits out an ISR still writing.
+static DRAM_ATTR capture_rec_t s_ring[CAPTURE_DEPTH];
+static uint32_t s_written;     // Records ever written since start
+static uint64_t s_base_levels; // Levels just before the oldest record in the ring
+static uint32_t s_base_us;
+static uint64_t s_pins;        // Mask of the capture, kept after stop for export
+static portMUX_TYPE s_capture_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void IRAM_ATTR debounce_capture_record(uint64_t pins, int64_t now_us) {
+    uint64_t levels = pin_hal_read_levels();
+
+    portENTER_CRITICAL_SAFE(&s_capture_lock);
+    pins &= debounce_capture_mask;
+    while (pins) {
+        int pin = __builtin_ctzll(pins);
+        pins &= pins - 1;
+
+        capture_rec_t *rec = &s_ring[s_written & (CAPTURE_DEPTH - 1)];
+        if (s_written >= CAPTURE_DEPTH) {
+            // Fold the record about to be overwritten into the starting state.
+            uint64_t bit = 1ULL << rec->pin;
+            s_base_levels = rec->level ? (s_base_levels | bit) : (s_base_levels & ~bit);
+            s_base_us = rec->t_us;
+        }
+        rec->t_us = (uint32_t)now_us;
+        rec->pin = (uint8_t)pin;
+        rec->level = (uint8_t)((levels >> pin) & 1);
+        s_written++;
+    }
+    portEXIT_CRITICAL_SAFE(&s_capture_lock);
+}
+
+esp_err_t debounce_capture_start(uint64_t pin_mask) {
+    pin_mask &= (GPIO_NUM_MAX < 64) ? ((1ULL << GPIO_NUM_MAX) - 1) : ~0ULL;
+    if (!pin_mask) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_capture_lock);
+    s_written = 0;
+    s_base_levels = pin_hal_read_levels();
+    s_base_us = (uint32_t)pin_hal_time_us();
+    s_pins = pin_mask;
+    debounce_capture_mask = pin_mask;
+    portEXIT_CRITICAL(&s_capture_lock);
+    ESP_LOGI(TAG, "Capturing pins 0x%llx, %u records", (unsigned long long)pin_mask,
+             (unsigned)CAPTURE_DEPTH);
+    return ESP_OK;
+}
+
+void debounce_capture_stop(void) {
+    portENTER_CRITICAL(&s_capture_lock);
+    debounce_capture_mask = 0;
+    portEXIT_CRITICAL(&s_capture_lock);
+}
+
+static size_t pin_count(void) {
+    return (size_t)__builtin_popcountll(s_pins);
+}
+
+size_t debounce_capture_export_size(void) {
+    uint32_t edges = s_written < CAPTURE_DEPTH ? s_written : CAPTURE_DEPTH;
+    return CAPTURE_HEADER_LEN + pin_count() * CAPTURE_PIN_LEN + edges * CAPTURE_EDGE_MAX;
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    p = put_u16(p, (uint16_t)v);
+    return put_u16(p, (uint16_t)(v >> 16));
+}
+
+static uint8_t *put_varint(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+// One table entry per captured pin that is registered right now.
+static uint8_t *put_pins(uint8_t *p, uint8_t *count) {
+    *count = 0;
+    for (uint64_t pins = s_pins; pins; pins &= pins - 1) {
+        const debounce_entry_t *entry = &debounce_pins[__builtin_ctzll(pins)];
+        if (!entry->in_use) {
+            continue;
+        }
+        const debounce_config_t *c = &entry->config;
+        *p++ = (uint8_t)c->pin;
+        *p++ = (uint8_t)c->engine;
+        *p++ = (uint8_t)c->policy;
+        *p++ = (uint8_t)c->intr_type;
+        *p++ = (uint8_t)((c->pull_up ? 1 : 0) | (c->state_change_only ? 2 : 0) |
+                         (c->adaptive ? 4 : 0));
+        *p++ = (uint8_t)c->dispatch;
+        p = put_u16(p, 0);
+        p = put_u32(p, c->debounce_time_us);
+        p = put_u32(p, c->press_time_us);
+        p = put_u32(p, c->release_time_us);
+        (*count)++;
+    }
+    return p;
+}
+
+esp_err_t debounce_capture_export(uint8_t *buf, size_t len, size_t *out_len) {
+    if (!buf || !out_len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (debounce_capture_mask) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (len < debounce_capture_export_size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t first = s_written > CAPTURE_DEPTH ? s_written - CAPTURE_DEPTH : 0;
+    uint32_t edges = s_written - first;
+
+    uint8_t *p = buf;
+    memcpy(p, "DBCP", 4);
+    p += 4;
+    *p++ = CAPTURE_VERSION;
+    uint8_t *count = p++;
+    p = put_u16(p, 0);
+    p = put_u32(p, edges);
+    p = put_u32(p, first);
+    p = put_u32(p, s_base_us);
+    p = put_u32(p, (uint32_t)s_base_levels);
+    p = put_u32(p, (uint32_t)(s_base_levels >> 32));
+    p = put_pins(p, count);
+
+    uint32_t prev_us = s_base_us;
+    for (uint32_t i = first; i < s_written; i++) {
+        const capture_rec_t *rec = &s_ring[i & (CAPTURE_DEPTH - 1)];
+        *p++ = (uint8_t)(rec->pin | (rec->level << 7));
+        p = put_varint(p, rec->t_us - prev_us);
+        prev_us = rec->t_us;
+    }
+    *out_len = (size_t)(p - buf);
+    ESP_LOGI(TAG, "Exported %u edges (%u lost), %u bytes",
+             (unsigned)edges, (unsigned)first, (unsigned)*out_len);
+    return ESP_OK;
+}
+
+#else // !CONFIG_DEBOUNCE_CAPTURE
+
+volatile uint64_t debounce_capture_mask = 0;
+
+esp_err_t debounce_capture_start(uint64_t pin_mask) {
+    (void)pin_mask;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void debounce_capture_stop(void) {
+}
+
+size_t debounce_capture_export_size(void) {
+    return 0;
+}
+
+esp_err_t debounce_capture_export(uint8_t *buf, size_t len, size_t *out_len) {
+    (void)buf;
+    (void)len;
+    (void)out_len;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_DEBOUNCE_CAPTURE
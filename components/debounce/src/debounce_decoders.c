@@ -0,0 +1,120 @@
+#include <string.h>
+#include "debounce_decoder.h"
+
+// Shortest burst the Wiegand decoder takes for a frame (keypads send 4 bits per key).
+#define WIEGAND_MIN_BITS 4
+
+#define NEC_LEADER_US  9000
+#define NEC_SPACE_US   4500
+#define NEC_REPEAT_US  2250
+#define NEC_MARK_US    560
+#define NEC_ONE_US     1690
+#define NEC_BITS       32
+
+static uint32_t gap_us(const debounce_edge_t *edges, size_t i) {
+    return edges[i + 1].t_us - edges[i].t_us;
+}
+
+// Within 25% of the nominal duration.
+static bool near_us(uint32_t actual, uint32_t nominal) {
+    return actual * 4 >= nominal * 3 && actual * 4 <= nominal * 5;
+}
+
+static bool bit_set(const debounce_frame_t *frame, unsigned i) {
+    return (frame->data[i / 8] >> (7 - i % 8)) & 1;
+}
+
+/**
+ * Every falling edge is one bit: 0 on line 0 (D0), 1 on line 1 (D1). The
+ * standard 26- and 34-bit formats open with even parity over the first half
+ * of the payload and close with odd parity over the second half.
+ */
+static bool wiegand_decode(const debounce_edge_t *edges, size_t count, debounce_frame_t *out) {
+    unsigned bits = 0;
+    memset(out->data, 0, sizeof(out->data));
+    for (size_t i = 0; i < count; i++) {
+        if (edges[i].level) {
+            continue;
+        }
+        if (bits == 8 * sizeof(out->data)) {
+            return false;
+        }
+        if (edges[i].line) {
+            out->data[bits / 8] |= (uint8_t)(0x80 >> (bits % 8));
+        }
+        bits++;
+    }
+    if (bits < WIEGAND_MIN_BITS) {
+        return false;
+    }
+    out->bits = (uint16_t)bits;
+    out->valid = true;
+    if (bits == 26 || bits == 34) {
+        unsigned half = (bits - 2) / 2;
+        unsigned lead = 0;
+        unsigned trail = 0;
+        for (unsigned i = 0; i <= half; i++) {
+            lead += bit_set(out, i);
+        }
+        for (unsigned i = half + 1; i < bits; i++) {
+            trail += bit_set(out, i);
+        }
+        out->valid = (lead % 2 == 0) && (trail % 2 == 1);
+    }
+    return true;
+}
+
+/**
+ * Pulse distance coding, low while the carrier is on: a 9ms leader and a
+ * 4.5ms space, then 32 bits of a 560us mark and a 560us (0) or 1690us (1)
+ * space, and a closing mark. A held key repeats as leader, 2.25ms space, mark.
+ */
+static bool nec_decode(const debounce_edge_t *edges, size_t count, debounce_frame_t *out) {
+    if (count < 4 || edges[0].level || !near_us(gap_us(edges, 0), NEC_LEADER_US)) {
+        return false;
+    }
+    memset(out->data, 0, sizeof(out->data));
+    uint32_t space = gap_us(edges, 1);
+    if (near_us(space, NEC_REPEAT_US)) {
+        out->bits = 0;
+        out->valid = near_us(gap_us(edges, 2), NEC_MARK_US);
+        return true;
+    }
+    if (!near_us(space, NEC_SPACE_US) || count < 3 + 2 * NEC_BITS + 1) {
+        return false;
+    }
+    out->valid = true;
+    for (unsigned i = 0; i < NEC_BITS; i++) {
+        size_t mark = 2 + 2 * i;
+        uint32_t bit_space = gap_us(edges, mark + 1);
+        if (!near_us(gap_us(edges, mark), NEC_MARK_US)) {
+            out->valid = false;
+        }
+        if (near_us(bit_space, NEC_ONE_US)) {
+            out->data[i / 8] |= (uint8_t)(1u << (i % 8));
+        } else if (!near_us(bit_space, NEC_MARK_US)) {
+            out->valid = false;
+        }
+    }
+    out->bits = NEC_BITS;
+    out->valid = out->valid && (out->data[2] ^ out->data[3]) == 0xff;
+    return true;
+}
+
+const debounce_decoder_t debounce_decoder_wiegand = {
+    .name = "wiegand",
+    .lines = 2,
+    .min_pulse_ns = 2000,
+    .idle_us = 25000,
+    .frame_gap_us = 100000,  // Longer than a run of one bit value in a 34-bit frame
+    .decode = wiegand_decode,
+};
+
+const debounce_decoder_t debounce_decoder_nec = {
+    .name = "nec",
+    .lines = 1,
+    .min_pulse_ns = 3000,
+    .idle_us = 12000,
+    .frame_gap_us = 0,
+    .decode = nec_decode,
+};
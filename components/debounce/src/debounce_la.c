@@ -0,0 +1,462 @@
+#include <string.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "debounce_la.h"
+
+#if CONFIG_DEBOUNCE_LA
+
+static const char *TAG = "DebounceLA";
+
+#define LA_VERSION      1
+#define LA_HEADER_LEN   40
+#define LA_RECORDS      CONFIG_DEBOUNCE_LA_RECORDS
+#define LA_BUFFERS      CONFIG_DEBOUNCE_LA_BUFFERS
+#define LA_BUFFER_BYTES (CONFIG_DEBOUNCE_LA_BUFFER_BYTES & ~3)
+
+#define LA_FLAG_TRIGGERED 0x01
+#define LA_FLAG_TRUNCATED 0x02
+#define LA_FLAG_OVERRUN   0x04
+
+// The buffer-done ISR queues filled DMA buffers; the timer task encodes them
+// into a ring of run-length records. Before the trigger the oldest records
+// are dropped once they are no longer needed for pre_samples of history.
+typedef struct {
+    debounce_la_config_t config;
+    gpio_num_t           pins[DEBOUNCE_LA_MAX_PINS];
+    pin_hal_par_t        par;          // NULL while not sampling
+    pin_hal_timer_t      timer;        // Kept across captures
+    debounce_la_state_t  state;
+    uint32_t             sample_hz;
+    uint8_t              width;        // Bytes per sample
+    uint8_t              len_bits;     // Run length bits of a record
+    int64_t              start_us;     // Clock at sample 0
+    // Written by the buffer-done ISR
+    const uint8_t       *queue[LA_BUFFERS];
+    uint32_t             queue_head;
+    uint32_t             queue_tail;   // Advanced once the buffer is encoded
+    bool                 overrun;
+    bool                 stop;
+    // Encoder
+    uint32_t            *records;      // Allocated on the first arm
+    uint32_t             first;        // Oldest record
+    uint32_t             count;
+    uint64_t             first_sample; // Where the oldest record begins
+    uint64_t             end_sample;   // Where the newest record ends
+    uint32_t             run_value;
+    uint64_t             run_start;
+    bool                 have_run;
+    uint64_t             samples;      // Samples encoded, including the open run
+    uint64_t             trigger_at;
+    uint64_t             end_at;       // Capture ends here once triggered
+    bool                 triggered;
+    bool                 truncated;
+} la_t;
+
+static la_t s_la;
+static portMUX_TYPE s_la_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool running(void) {
+    return s_la.state == DEBOUNCE_LA_ARMED || s_la.state == DEBOUNCE_LA_TRIGGERED;
+}
+
+/**
+ * Buffer-done ISR: queue the buffer for the encoder. The DMA refills a buffer
+ * once the ring comes round to it, so no more than LA_BUFFERS - 1 may wait,
+ * counting the one being encoded; past that the capture is overrun and ends.
+ */
+static IRAM_ATTR bool on_buffer(pin_hal_par_t par, const void *samples, size_t bytes, void *arg) {
+    (void)par;
+    (void)bytes;
+    (void)arg;
+    portENTER_CRITICAL_ISR(&s_la_lock);
+    if (s_la.queue_head - s_la.queue_tail >= LA_BUFFERS - 1) {
+        s_la.overrun = true;
+    } else if (!s_la.overrun) {
+        s_la.queue[s_la.queue_head++ % LA_BUFFERS] = (const uint8_t *)samples;
+    }
+    portEXIT_CRITICAL_ISR(&s_la_lock);
+    (void)pin_hal_timer_start_once(s_la.timer, 0);
+    return false;
+}
+
+static inline uint32_t sample_at(const uint8_t *buf, size_t i) {
+    return s_la.width == 1 ? buf[i] : (uint32_t)buf[2 * i] | (uint32_t)buf[2 * i + 1] << 8;
+}
+
+// First sample from i on that differs from value, or n. An idle bus is
+// skipped a 32-bit word at a time.
+static size_t run_end(const uint8_t *buf, size_t i, size_t n, uint32_t value) {
+    size_t per_word = 4 / s_la.width;
+    uint32_t word = s_la.width == 1 ? value * 0x01010101u : value * 0x00010001u;
+    while (i + per_word <= n) {
+        uint32_t w;
+        memcpy(&w, buf + i * s_la.width, sizeof(w));
+        if (w != word) {
+            break;
+        }
+        i += per_word;
+    }
+    while (i < n && sample_at(buf, i) == value) {
+        i++;
+    }
+    return i;
+}
+
+static uint32_t record_len(uint32_t record) {
+    return record & ((1u << s_la.len_bits) - 1);
+}
+
+static void drop_oldest(void) {
+    s_la.first_sample += record_len(s_la.records[s_la.first]);
+    s_la.first = (s_la.first + 1) % LA_RECORDS;
+    s_la.count--;
+}
+
+// Append a run, split into records of at most the longest length a record
+// holds. Returns false once the ring is full after the trigger.
+static bool push_run(uint32_t value, uint64_t len) {
+    uint32_t max_len = (1u << s_la.len_bits) - 1;
+    while (len) {
+        if (s_la.count == LA_RECORDS) {
+            if (s_la.triggered) {
+                s_la.truncated = true;
+                return false;
+            }
+            drop_oldest();
+        }
+        uint32_t n = len > max_len ? max_len : (uint32_t)len;
+        s_la.records[(s_la.first + s_la.count) % LA_RECORDS] = (value << s_la.len_bits) | n;
+        s_la.count++;
+        s_la.end_sample += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Close the open run at sample end and, before the trigger, drop the history
+// that is older than pre_samples before end.
+static bool close_run(uint64_t end) {
+    if (!s_la.have_run) {
+        return true;
+    }
+    s_la.have_run = false;
+    if (!push_run(s_la.run_value, end - s_la.run_start)) {
+        return false;
+    }
+    while (!s_la.triggered && s_la.count &&
+           end - s_la.first_sample - record_len(s_la.records[s_la.first]) >=
+               s_la.config.pre_samples) {
+        drop_oldest();
+    }
+    return true;
+}
+
+static bool trigger_matches(uint32_t value) {
+    return (value & s_la.config.trigger_mask) == s_la.config.trigger_value;
+}
+
+// A run starting with value at run_start, after a run of prev (if any).
+static void check_trigger(uint32_t value, bool have_prev, uint32_t prev) {
+    const debounce_la_config_t *c = &s_la.config;
+    if (s_la.triggered || !trigger_matches(value)) {
+        return;
+    }
+    if (c->trigger_edge && c->trigger_mask && (!have_prev || trigger_matches(prev))) {
+        return;
+    }
+    s_la.triggered = true;
+    s_la.trigger_at = s_la.run_start;
+    s_la.end_at = s_la.trigger_at + c->post_samples;
+    // The oldest record reaches into the pre-trigger window; cut it to size.
+    uint64_t history = s_la.trigger_at - s_la.first_sample;
+    if (s_la.count && history > c->pre_samples) {
+        uint32_t cut = (uint32_t)(history - c->pre_samples);
+        s_la.records[s_la.first] -= cut;
+        s_la.first_sample += cut;
+    }
+    portENTER_CRITICAL(&s_la_lock);
+    s_la.state = DEBOUNCE_LA_TRIGGERED;
+    portEXIT_CRITICAL(&s_la_lock);
+    ESP_LOGI(TAG, "Triggered at sample %llu", (unsigned long long)s_la.trigger_at);
+}
+
+static void start_run(uint32_t value) {
+    s_la.run_value = value;
+    s_la.run_start = s_la.samples;
+    s_la.have_run = true;
+    s_la.samples++;
+}
+
+// Encode n samples; returns false once the capture is complete.
+static bool encode(const uint8_t *buf, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        size_t limit = n;
+        if (s_la.triggered && s_la.end_at - s_la.samples < n - i) {
+            limit = i + (size_t)(s_la.end_at - s_la.samples);
+        }
+        if (!s_la.have_run) {
+            start_run(sample_at(buf, i++));
+            check_trigger(s_la.run_value, false, 0);
+            continue;
+        }
+        size_t j = run_end(buf, i, limit, s_la.run_value);
+        s_la.samples += j - i;
+        i = j;
+        if (i == limit) {
+            if (limit < n) {
+                return false;
+            }
+            break;
+        }
+        uint32_t prev = s_la.run_value;
+        if (!close_run(s_la.samples)) {
+            return false;
+        }
+        start_run(sample_at(buf, i++));
+        check_trigger(s_la.run_value, true, prev);
+    }
+    return !(s_la.triggered && s_la.samples >= s_la.end_at);
+}
+
+static void finish(void) {
+    (void)close_run(s_la.samples);
+    (void)pin_hal_par_delete(s_la.par);
+    portENTER_CRITICAL(&s_la_lock);
+    s_la.par = NULL;
+    s_la.state = DEBOUNCE_LA_DONE;
+    bool overrun = s_la.overrun;
+    portEXIT_CRITICAL(&s_la_lock);
+    if (overrun) {
+        ESP_LOGW(TAG, "Encoder fell behind at sample %llu; capture ended early",
+                 (unsigned long long)s_la.samples);
+    }
+    ESP_LOGI(TAG, "Capture done: %llu samples in %u records%s%s",
+             (unsigned long long)(s_la.end_sample - s_la.first_sample), (unsigned)s_la.count,
+             s_la.triggered ? "" : ", not triggered", s_la.truncated ? ", truncated" : "");
+    if (s_la.config.on_done) {
+        s_la.config.on_done(s_la.config.arg);
+    }
+}
+
+/**
+ * Encoder (timer task), started from the buffer-done ISR: encode the queued
+ * buffers in order, then end the capture once its post-trigger samples are
+ * in, on an overrun or on request.
+ */
+static void la_callback(void *arg) {
+    (void)arg;
+    if (!running()) {
+        return;
+    }
+    size_t per_buffer = LA_BUFFER_BYTES / s_la.width;
+    bool more = true;
+    while (more) {
+        portENTER_CRITICAL(&s_la_lock);
+        bool have = (s_la.queue_tail != s_la.queue_head);
+        const uint8_t *buf = have ? s_la.queue[s_la.queue_tail % LA_BUFFERS] : NULL;
+        portEXIT_CRITICAL(&s_la_lock);
+        if (!have) {
+            break;
+        }
+        more = encode(buf, per_buffer);
+        portENTER_CRITICAL(&s_la_lock);
+        s_la.queue_tail++;
+        portEXIT_CRITICAL(&s_la_lock);
+    }
+    portENTER_CRITICAL(&s_la_lock);
+    bool end = !more || s_la.overrun || s_la.stop;
+    portEXIT_CRITICAL(&s_la_lock);
+    if (end) {
+        finish();
+    }
+}
+
+esp_err_t debounce_la_arm(const debounce_la_config_t *config) {
+    if (!config || !config->pins || config->pin_count == 0 ||
+        config->pin_count > DEBOUNCE_LA_MAX_PINS || config->post_samples == 0 ||
+        (config->trigger_value & ~config->trigger_mask) ||
+        (config->trigger_mask >> config->pin_count)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (running()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!s_la.timer) {
+        esp_err_t err = pin_hal_timer_create(la_callback, NULL, "debounce_la", false, &s_la.timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (!s_la.records) {
+        // Only the timer task touches the records, so they may live in PSRAM.
+        s_la.records = heap_caps_malloc(LA_RECORDS * sizeof(uint32_t), MALLOC_CAP_8BIT);
+        if (!s_la.records) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    la_t *la = &s_la;
+    la->config = *config;
+    memcpy(la->pins, config->pins, config->pin_count * sizeof(config->pins[0]));
+    la->config.pins = la->pins;
+    la->width = config->pin_count > 8 ? 2 : 1;
+    la->len_bits = (uint8_t)(32 - 8 * la->width);
+    la->queue_head = la->queue_tail = 0;
+    la->overrun = la->stop = false;
+    la->first = la->count = 0;
+    la->first_sample = la->end_sample = 0;
+    la->have_run = false;
+    la->samples = 0;
+    la->triggered = la->truncated = false;
+
+    const pin_hal_par_config_t par = {
+        .pins = config->pins,
+        .pin_count = config->pin_count,
+        .clock_pin = config->clock_pin,
+        .sample_hz = config->sample_hz,
+        .buffer_bytes = LA_BUFFER_BYTES,
+        .buffers = LA_BUFFERS,
+    };
+    esp_err_t err = pin_hal_par_create(&par, on_buffer, NULL, &la->par, &la->sample_hz);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Parallel sampler setup failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    la->state = DEBOUNCE_LA_ARMED;
+    la->start_us = pin_hal_time_us();
+    err = pin_hal_par_start(la->par);
+    if (err != ESP_OK) {
+        (void)pin_hal_par_delete(la->par);
+        la->par = NULL;
+        la->state = DEBOUNCE_LA_IDLE;
+        return err;
+    }
+    ESP_LOGI(TAG, "Armed: %u pins at %u Hz, trigger 0x%x/0x%x%s, %u+%u samples",
+             (unsigned)config->pin_count, (unsigned)la->sample_hz,
+             (unsigned)config->trigger_value, (unsigned)config->trigger_mask,
+             config->trigger_edge ? " on entry" : "", (unsigned)config->pre_samples,
+             (unsigned)config->post_samples);
+    return ESP_OK;
+}
+
+void debounce_la_stop(void) {
+    portENTER_CRITICAL(&s_la_lock);
+    bool run = running();
+    s_la.stop = run;
+    portEXIT_CRITICAL(&s_la_lock);
+    if (run) {
+        (void)pin_hal_timer_start_once(s_la.timer, 0);
+    }
+}
+
+void debounce_la_get_status(debounce_la_status_t *out) {
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_la_lock);
+    *out = (debounce_la_status_t){
+        .state = s_la.state,
+        .sample_hz = s_la.sample_hz,
+        .samples = s_la.samples,
+        .records = s_la.count,
+        .triggered = s_la.triggered,
+        .truncated = s_la.truncated,
+        .overrun = s_la.overrun,
+    };
+    portEXIT_CRITICAL(&s_la_lock);
+}
+
+size_t debounce_la_export_size(void) {
+    if (s_la.state != DEBOUNCE_LA_DONE) {
+        return 0;
+    }
+    return LA_HEADER_LEN + s_la.config.pin_count + (size_t)s_la.count * sizeof(uint32_t);
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        *p++ = (uint8_t)(v >> (8 * i));
+    }
+    return p;
+}
+
+static uint8_t *put_u64(uint8_t *p, uint64_t v) {
+    p = put_u32(p, (uint32_t)v);
+    return put_u32(p, (uint32_t)(v >> 32));
+}
+
+esp_err_t debounce_la_export(debounce_la_write_t write, void *ctx) {
+    if (!write) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_la.state != DEBOUNCE_LA_DONE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint64_t total = s_la.end_sample - s_la.first_sample;
+    uint8_t head[LA_HEADER_LEN + DEBOUNCE_LA_MAX_PINS];
+    uint8_t *p = head;
+    memcpy(p, "DBLA", 4);
+    p += 4;
+    *p++ = LA_VERSION;
+    *p++ = (uint8_t)s_la.config.pin_count;
+    *p++ = s_la.width;
+    *p++ = (uint8_t)((s_la.triggered ? LA_FLAG_TRIGGERED : 0) |
+                     (s_la.truncated ? LA_FLAG_TRUNCATED : 0) |
+                     (s_la.overrun ? LA_FLAG_OVERRUN : 0));
+    p = put_u32(p, s_la.sample_hz);
+    p = put_u32(p, s_la.count);
+    p = put_u64(p, total);
+    p = put_u64(p, s_la.triggered ? s_la.trigger_at - s_la.first_sample : total);
+    p = put_u64(p, (uint64_t)(s_la.start_us +
+                              (int64_t)(s_la.first_sample * 1000000u / s_la.sample_hz)));
+    for (size_t i = 0; i < s_la.config.pin_count; i++) {
+        *p++ = (uint8_t)s_la.pins[i];
+    }
+    esp_err_t err = write(head, (size_t)(p - head), ctx);
+
+    // Records are stored little-endian already; the ring wraps at most once.
+    uint32_t n = s_la.count;
+    uint32_t first_part = LA_RECORDS - s_la.first < n ? LA_RECORDS - s_la.first : n;
+    if (err == ESP_OK && first_part) {
+        err = write(&s_la.records[s_la.first], first_part * sizeof(uint32_t), ctx);
+    }
+    if (err == ESP_OK && n > first_part) {
+        err = write(s_la.records, (n - first_part) * sizeof(uint32_t), ctx);
+    }
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Exported %u records, %u bytes", (unsigned)n,
+                 (unsigned)debounce_la_export_size());
+    }
+    return err;
+}
+
+#else // !CONFIG_DEBOUNCE_LA
+
+esp_err_t debounce_la_arm(const debounce_la_config_t *config) {
+    (void)config;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void debounce_la_stop(void) {
+}
+
+void debounce_la_get_status(debounce_la_status_t *out) {
+    if (out) {
+        *out = (debounce_la_status_t){ .state = DEBOUNCE_LA_IDLE };
+    }
+}
+
+size_t debounce_la_export_size(void) {
+    return 0;
+}
+
+esp_err_t debounce_la_export(debounce_la_write_t write, void *ctx) {
+    (void)write;
+    (void)ctx;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_DEBOUNCE_LA
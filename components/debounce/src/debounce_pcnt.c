@@ -0,0 +1,317 @@
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "private/debounce_internal.h"
+
+#if CONFIG_DEBOUNCE_PCNT
+
+static const char *TAG = "DebouncePcnt";
+
+#define PCNT_LIMIT  32767  // Widest hardware range; one wrap interrupt per 32767 counts
+
+// One pulse counter unit and its report timer, for a counter or an encoder.
+typedef struct {
+    debounce_entry_t   *entry;         // NULL while the slot is free
+    pin_hal_pcnt_t      pcnt;
+    pin_hal_timer_t     timer;
+    bool                encoder;
+    volatile int64_t    wrapped;       // Sum of counter wraps, added by the PCNT ISR
+    int64_t             total;         // Latest total read
+    int64_t             window_start_us;
+    int64_t             window_total;  // total at window_start_us
+    uint32_t            window_us;     // Reporting period
+    uint32_t            threshold;     // Encoder: report early after this many counts
+    debounce_count_t    count;         // Last finished window (counter)
+    debounce_position_t position;      // Last report (encoder)
+    bool                have_report;
+} pcnt_slot_t;
+
+static pcnt_slot_t s_slots[PIN_HAL_PCNT_UNITS];
+static portMUX_TYPE s_pcnt_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * Watch point at either limit (PCNT ISR): the counter has just cleared
+ * itself, carry the wrap into the 64-bit extension. This is the only
+ * interrupt the pins ever raise.
+ */
+static IRAM_ATTR bool on_limit(pin_hal_pcnt_unit_t unit, const pin_hal_pcnt_event_t *edata,
+                               void *arg) {
+    (void)unit;
+    pcnt_slot_t *slot = (pcnt_slot_t *)arg;
+    portENTER_CRITICAL_ISR(&s_pcnt_lock);
+    slot->wrapped += edata->watch_point_value;
+    portEXIT_CRITICAL_ISR(&s_pcnt_lock);
+    return false;
+}
+
+static int64_t load_wrapped(pcnt_slot_t *slot) {
+    portENTER_CRITICAL(&s_pcnt_lock);
+    int64_t wrapped = slot->wrapped;
+    portEXIT_CRITICAL(&s_pcnt_lock);
+    return wrapped;
+}
+
+/**
+ * 64-bit total: the extension and the live count, re-read until no wrap was
+ * handled in between. A wrap whose interrupt is still pending reads as the
+ * count jumping by the limit towards zero. A counter never goes backwards;
+ * an encoder read every CONFIG_DEBOUNCE_ENCODER_POLL_MS moves by less than
+ * half the limit between reads. Either way the jump is undone here.
+ */
+static int64_t read_total(pcnt_slot_t *slot) {
+    int64_t before;
+    int64_t after = load_wrapped(slot);
+    int count = 0;
+    do {
+        before = after;
+        (void)pin_hal_pcnt_get(&slot->pcnt, &count);
+        after = load_wrapped(slot);
+    } while (before != after);
+
+    int64_t total = after + count;
+    int64_t moved = total - slot->total;
+    if (!slot->encoder && moved < 0) {
+        total += PCNT_LIMIT;
+    } else if (slot->encoder && moved > PCNT_LIMIT / 2) {
+        total -= PCNT_LIMIT;
+    } else if (slot->encoder && moved < -PCNT_LIMIT / 2) {
+        total += PCNT_LIMIT;
+    }
+    slot->total = total;
+    return total;
+}
+
+/**
+ * Report timer (timer task). A counter closes its window on every tick; an
+ * encoder is polled and reports once the window is over or the position has
+ * moved by the threshold. Either keeps the figures for the getters and posts
+ * one event.
+ */
+static void report_callback(void *arg) {
+    pcnt_slot_t *slot = (pcnt_slot_t *)arg;
+    debounce_entry_t *entry = slot->entry;
+    if (!entry) {
+        return;
+    }
+    int64_t now_us = pin_hal_time_us();
+    int64_t total = read_total(slot);
+    int64_t moved = total - slot->window_total;
+    uint32_t elapsed_us = (uint32_t)(now_us - slot->window_start_us);
+    gpio_event_kind_t kind;
+
+    if (slot->encoder) {
+        bool far = slot->threshold && (moved >= slot->threshold || -moved >= slot->threshold);
+        if (elapsed_us < slot->window_us && !far) {
+            return;
+        }
+        int64_t velocity = elapsed_us ? moved * 1000000 / elapsed_us : 0;
+        debounce_position_t pos = {
+            .position = total,
+            .delta = (int32_t)moved,
+            .velocity = (int32_t)(velocity > INT32_MAX ? INT32_MAX :
+                                  velocity < INT32_MIN ? INT32_MIN : velocity),
+            .since_us = slot->window_start_us,
+            .interval_us = elapsed_us,
+        };
+        portENTER_CRITICAL(&s_pcnt_lock);
+        slot->position = pos;
+        slot->have_report = true;
+        portEXIT_CRITICAL(&s_pcnt_lock);
+        kind = GPIO_EVENT_POSITION;
+    } else {
+        debounce_count_t win = {
+            .total = (uint64_t)total,
+            .delta = (uint32_t)moved,
+            .rate_milli_hz = elapsed_us ? (uint32_t)((uint64_t)moved * 1000000000ULL / elapsed_us)
+                                        : 0,
+            .window_start_us = slot->window_start_us,
+            .window_us = elapsed_us,
+        };
+        portENTER_CRITICAL(&s_pcnt_lock);
+        slot->count = win;
+        slot->have_report = true;
+        portEXIT_CRITICAL(&s_pcnt_lock);
+        kind = GPIO_EVENT_COUNT;
+    }
+
+    entry->first_edge_us = slot->window_start_us;
+    slot->window_start_us = now_us;
+    slot->window_total = total;
+    debounce_emit_event(entry, kind, (int)((pin_hal_read_levels() >> entry->config.pin) & 1));
+}
+
+static pcnt_slot_t *slot_of(gpio_num_t pin) {
+    for (size_t i = 0; i < PIN_HAL_PCNT_UNITS; i++) {
+        if (s_slots[i].entry && s_slots[i].entry->config.pin == pin) {
+            return &s_slots[i];
+        }
+    }
+    return NULL;
+}
+
+bool debounce_pcnt_claims(gpio_num_t pin) {
+    for (size_t i = 0; i < PIN_HAL_PCNT_UNITS; i++) {
+        const debounce_entry_t *entry = s_slots[i].entry;
+        if (entry && s_slots[i].encoder && entry->config.encoder_b_pin == pin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t debounce_pcnt_add(debounce_entry_t *entry) {
+    const debounce_config_t *config = &entry->config;
+    bool encoder = (config->engine == DEBOUNCE_ENGINE_ENCODER);
+    pcnt_slot_t *slot = NULL;
+    for (size_t i = 0; i < PIN_HAL_PCNT_UNITS && !slot; i++) {
+        slot = s_slots[i].entry ? NULL : &s_slots[i];
+    }
+    if (!slot) {
+        ESP_LOGE(TAG, "No free pulse counter unit for GPIO %d", config->pin);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (encoder) {
+        gpio_num_t b = config->encoder_b_pin;
+        if (!GPIO_IS_VALID_GPIO(b) || b == config->pin || debounce_pins[b].in_use ||
+            debounce_pcnt_claims(b)) {
+            ESP_LOGE(TAG, "Encoder on GPIO %d: B input GPIO %d invalid or in use",
+                     config->pin, b);
+            return ESP_ERR_INVALID_ARG;
+        }
+        esp_err_t err = pin_hal_config_input(b, config->pull_up, GPIO_INTR_DISABLE);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (!slot->timer) {
+        esp_err_t err = pin_hal_timer_create(report_callback, slot, "debounce_pcnt", false,
+                                             &slot->timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    uint32_t window_ms = config->count_window_ms ? config->count_window_ms
+                                                 : CONFIG_DEBOUNCE_PCNT_WINDOW_MS;
+    const pin_hal_pcnt_config_t pcnt_config = {
+        .pin = config->pin,
+        .quadrature_pin = encoder ? config->encoder_b_pin : GPIO_NUM_NC,
+        .count_rise = config->intr_type != GPIO_INTR_NEGEDGE,
+        .count_fall = config->intr_type != GPIO_INTR_POSEDGE,
+        .limit = PCNT_LIMIT,
+        .glitch_ns = config->glitch_ns ? config->glitch_ns : CONFIG_DEBOUNCE_PCNT_GLITCH_NS,
+    };
+    slot->encoder = encoder;
+    slot->wrapped = 0;
+    slot->total = 0;
+    slot->window_total = 0;
+    slot->window_us = window_ms * 1000;
+    slot->threshold = encoder ? config->encoder_threshold : 0;
+    slot->have_report = false;
+    esp_err_t err = pin_hal_pcnt_create(&pcnt_config, on_limit, slot, &slot->pcnt);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Pulse counter setup failed for GPIO %d: %s", config->pin,
+                 esp_err_to_name(err));
+        return err;
+    }
+
+    // Encoders are polled so that no read ever misses half a wrap.
+    uint32_t tick_ms = window_ms;
+    if (encoder && tick_ms > CONFIG_DEBOUNCE_ENCODER_POLL_MS) {
+        tick_ms = CONFIG_DEBOUNCE_ENCODER_POLL_MS;
+    }
+    slot->window_start_us = pin_hal_time_us();
+    slot->entry = entry;
+    err = pin_hal_timer_start_periodic(slot->timer, (uint64_t)tick_ms * 1000);
+    if (err != ESP_OK) {
+        slot->entry = NULL;
+        (void)pin_hal_pcnt_delete(&slot->pcnt);
+        return err;
+    }
+    if (encoder) {
+        ESP_LOGI(TAG, "GPIO %d/%d quadrature encoder, filter %uns, window %ums, threshold %u",
+                 config->pin, config->encoder_b_pin, (unsigned)pcnt_config.glitch_ns,
+                 (unsigned)window_ms, (unsigned)slot->threshold);
+    } else {
+        ESP_LOGI(TAG, "GPIO %d counting %s edges, filter %uns, window %ums", config->pin,
+                 pcnt_config.count_rise && pcnt_config.count_fall ? "all" :
+                 pcnt_config.count_rise ? "rising" : "falling",
+                 (unsigned)pcnt_config.glitch_ns, (unsigned)window_ms);
+    }
+    return ESP_OK;
+}
+
+void debounce_pcnt_remove(gpio_num_t pin) {
+    pcnt_slot_t *slot = slot_of(pin);
+    if (!slot) {
+        return;
+    }
+    (void)pin_hal_timer_stop(slot->timer);
+    (void)pin_hal_timer_delete(slot->timer);
+    slot->timer = NULL;
+    (void)pin_hal_pcnt_delete(&slot->pcnt);
+    portENTER_CRITICAL(&s_pcnt_lock);
+    slot->entry = NULL;
+    slot->have_report = false;
+    portEXIT_CRITICAL(&s_pcnt_lock);
+}
+
+esp_err_t debounce_get_count(gpio_num_t pin, debounce_count_t *out) {
+    if (!out || !GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    portENTER_CRITICAL(&s_pcnt_lock);
+    pcnt_slot_t *slot = slot_of(pin);
+    if (slot && !slot->encoder) {
+        err = slot->have_report ? ESP_OK : ESP_ERR_INVALID_STATE;
+        *out = slot->count;
+    }
+    portEXIT_CRITICAL(&s_pcnt_lock);
+    return err;
+}
+
+esp_err_t debounce_get_position(gpio_num_t pin, debounce_position_t *out) {
+    if (!out || !GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    portENTER_CRITICAL(&s_pcnt_lock);
+    pcnt_slot_t *slot = slot_of(pin);
+    if (slot && slot->encoder) {
+        err = slot->have_report ? ESP_OK : ESP_ERR_INVALID_STATE;
+        *out = slot->position;
+    }
+    portEXIT_CRITICAL(&s_pcnt_lock);
+    return err;
+}
+
+#else // !CONFIG_DEBOUNCE_PCNT
+
+esp_err_t debounce_pcnt_add(debounce_entry_t *entry) {
+    (void)entry;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void debounce_pcnt_remove(gpio_num_t pin) {
+    (void)pin;
+}
+
+bool debounce_pcnt_claims(gpio_num_t pin) {
+    (void)pin;
+    return false;
+}
+
+esp_err_t debounce_get_count(gpio_num_t pin, debounce_count_t *out) {
+    (void)pin;
+    (void)out;
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t debounce_get_position(gpio_num_t pin, debounce_position_t *out) {
+    (void)pin;
+    (void)out;
+    return ESP_ERR_NOT_FOUND;
+}
+
+#endif // CONFIG_DEBOUNCE_PCNT
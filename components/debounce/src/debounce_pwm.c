@@ -0,0 +1,317 @@
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "private/debounce_internal.h"
+
+#if CONFIG_DEBOUNCE_PWM
+
+static const char *TAG = "DebouncePwm";
+
+#define PWM_SLOTS  (PIN_HAL_CAP_GROUPS * PIN_HAL_CAP_CHANNELS)
+
+// Running figures of the window in progress, in capture timer ticks.
+typedef struct {
+    uint32_t edges;
+    uint32_t cycles;
+    uint32_t period_min;
+    uint32_t period_max;
+    uint64_t period_sum;
+    uint32_t high_min;
+    uint32_t high_max;
+    uint64_t high_sum;
+    uint16_t duty_min_bp;
+    uint16_t duty_max_bp;
+} pwm_acc_t;
+
+// One capture channel and its report timer. Slot i uses the capture timer of
+// group i / PIN_HAL_CAP_CHANNELS.
+typedef struct {
+    debounce_entry_t     *entry;         // NULL while the slot is free
+    pin_hal_cap_channel_t chan;
+    pin_hal_timer_t       timer;
+    uint32_t              resolution_hz;
+    uint32_t              max_period;    // Ticks
+    uint32_t              rise;          // Capture value of the latest rising edge
+    uint32_t              high;          // Its high time, once the falling edge came
+    bool                  have_rise;
+    bool                  have_high;
+    pwm_acc_t             acc;           // Written by the capture ISR
+    uint32_t              tick_edges;    // acc.edges at the previous tick
+    uint32_t              quiet_us;      // Time since an edge was last seen, in ticks
+    uint32_t              tick_us;
+    uint32_t              window_us;
+    int64_t               window_start_us;
+    debounce_pwm_t        report;        // Last finished window
+    bool                  have_report;
+} pwm_slot_t;
+
+static pwm_slot_t s_slots[PWM_SLOTS];
+static pin_hal_cap_timer_t s_cap_timers[PIN_HAL_CAP_GROUPS];
+static uint32_t s_resolution_hz[PIN_HAL_CAP_GROUPS];
+static portMUX_TYPE s_pwm_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * Duty cycle in basis points with 32-bit arithmetic only, so the ISR calls no
+ * libgcc division: both times are scaled down until high * 10000 fits.
+ */
+static IRAM_ATTR uint16_t duty_bp(uint32_t high, uint32_t period) {
+    int shift = 32 - __builtin_clz(high | 1) - 18;
+    if (shift > 0) {
+        high >>= shift;
+        period >>= shift;
+    }
+    return high >= period ? 10000 : (uint16_t)(high * 10000u / period);
+}
+
+static IRAM_ATTR void cycle_add(pwm_acc_t *acc, uint32_t period, uint32_t high) {
+    uint16_t duty = duty_bp(high, period);
+    if (acc->cycles++ == 0) {
+        acc->period_min = acc->period_max = period;
+        acc->high_min = acc->high_max = high;
+        acc->duty_min_bp = acc->duty_max_bp = duty;
+    } else {
+        acc->period_min = period < acc->period_min ? period : acc->period_min;
+        acc->period_max = period > acc->period_max ? period : acc->period_max;
+        acc->high_min = high < acc->high_min ? high : acc->high_min;
+        acc->high_max = high > acc->high_max ? high : acc->high_max;
+        acc->duty_min_bp = duty < acc->duty_min_bp ? duty : acc->duty_min_bp;
+        acc->duty_max_bp = duty > acc->duty_max_bp ? duty : acc->duty_max_bp;
+    }
+    acc->period_sum += period;
+    acc->high_sum += high;
+}
+
+/**
+ * Capture ISR, once per edge: the timestamps were latched by the hardware, so
+ * only the cycle bookkeeping runs here. A falling edge closes the high time of
+ * the cycle started by the last rising edge, and the next rising edge closes
+ * the cycle. Two edges of the same kind in a row mean one was missed; the
+ * cycle is dropped rather than measured wrong.
+ */
+static IRAM_ATTR bool on_capture(pin_hal_cap_channel_t chan, const pin_hal_cap_event_t *edata,
+                                 void *arg) {
+    (void)chan;
+    pwm_slot_t *slot = (pwm_slot_t *)arg;
+    uint32_t t = edata->cap_value;
+    portENTER_CRITICAL_ISR(&s_pwm_lock);
+    slot->acc.edges++;
+    if (edata->cap_edge != PIN_HAL_CAP_EDGE_POS) {
+        if (slot->have_rise && !slot->have_high) {
+            slot->high = t - slot->rise;
+            slot->have_high = true;
+        } else {
+            slot->have_rise = slot->have_high = false;
+        }
+    } else {
+        uint32_t period = t - slot->rise;
+        if (slot->have_high && period && period <= slot->max_period) {
+            cycle_add(&slot->acc, period, slot->high);
+        }
+        slot->rise = t;
+        slot->have_rise = true;
+        slot->have_high = false;
+    }
+    portEXIT_CRITICAL_ISR(&s_pwm_lock);
+    return false;
+}
+
+static uint32_t ticks_to_ns(uint64_t ticks, uint32_t resolution_hz) {
+    return (uint32_t)((ticks * 1000000000ULL + resolution_hz / 2) / resolution_hz);
+}
+
+/**
+ * Report timer (timer task), every window or CONFIG_DEBOUNCE_PWM_MAX_PERIOD_MS
+ * if that is shorter. A signal that stopped leaves its last rising edge
+ * behind; once it is older than any period measured it is forgotten, long
+ * before the 32-bit capture timer could wrap onto it. At the end of a window
+ * the figures are converted, kept for debounce_get_pwm() and one event posted.
+ */
+static void report_callback(void *arg) {
+    pwm_slot_t *slot = (pwm_slot_t *)arg;
+    debounce_entry_t *entry = slot->entry;
+    if (!entry) {
+        return;
+    }
+    int64_t now_us = pin_hal_time_us();
+    uint32_t elapsed_us = (uint32_t)(now_us - slot->window_start_us);
+    bool close = (elapsed_us >= slot->window_us);
+    pwm_acc_t acc;
+
+    portENTER_CRITICAL(&s_pwm_lock);
+    slot->quiet_us = (slot->acc.edges == slot->tick_edges) ? slot->quiet_us + slot->tick_us : 0;
+    if (slot->quiet_us >= CONFIG_DEBOUNCE_PWM_MAX_PERIOD_MS * 1000) {
+        slot->have_rise = false;
+        slot->have_high = false;
+    }
+    acc = slot->acc;
+    if (close) {
+        slot->acc = (pwm_acc_t){ 0 };
+    }
+    slot->tick_edges = slot->acc.edges;
+    portEXIT_CRITICAL(&s_pwm_lock);
+    if (!close) {
+        return;
+    }
+
+    uint32_t hz = slot->resolution_hz;
+    int level = (int)((pin_hal_read_levels() >> entry->config.pin) & 1);
+    debounce_pwm_t win = {
+        .cycles = acc.cycles,
+        .duty_mean_bp = level ? 10000 : 0,
+        .level = (uint8_t)level,
+        .window_start_us = slot->window_start_us,
+        .window_us = elapsed_us,
+    };
+    if (acc.cycles) {
+        win.period_min_ns = ticks_to_ns(acc.period_min, hz);
+        win.period_mean_ns = ticks_to_ns(acc.period_sum / acc.cycles, hz);
+        win.period_max_ns = ticks_to_ns(acc.period_max, hz);
+        win.high_min_ns = ticks_to_ns(acc.high_min, hz);
+        win.high_mean_ns = ticks_to_ns(acc.high_sum / acc.cycles, hz);
+        win.high_max_ns = ticks_to_ns(acc.high_max, hz);
+        win.duty_min_bp = acc.duty_min_bp;
+        win.duty_mean_bp = (uint16_t)(acc.high_sum * 10000 / acc.period_sum);
+        win.duty_max_bp = acc.duty_max_bp;
+    }
+    portENTER_CRITICAL(&s_pwm_lock);
+    slot->report = win;
+    slot->have_report = true;
+    portEXIT_CRITICAL(&s_pwm_lock);
+
+    entry->first_edge_us = slot->window_start_us;
+    slot->window_start_us = now_us;
+    debounce_emit_event(entry, GPIO_EVENT_PWM, level);
+}
+
+static pwm_slot_t *slot_of(gpio_num_t pin) {
+    for (size_t i = 0; i < PWM_SLOTS; i++) {
+        if (s_slots[i].entry && s_slots[i].entry->config.pin == pin) {
+            return &s_slots[i];
+        }
+    }
+    return NULL;
+}
+
+// First free channel in a group whose capture timer runs (started on first use).
+static pwm_slot_t *claim_slot(void) {
+    for (size_t i = 0; i < PWM_SLOTS; i++) {
+        int group = (int)(i / PIN_HAL_CAP_CHANNELS);
+        if (s_slots[i].entry) {
+            continue;
+        }
+        if (!s_cap_timers[group]) {
+            esp_err_t err = pin_hal_cap_timer_create(group, &s_cap_timers[group],
+                                                     &s_resolution_hz[group]);
+            if (err != ESP_OK) {
+                ESP_LOGW(TAG, "Capture timer of MCPWM group %d unavailable: %s", group,
+                         esp_err_to_name(err));
+                i = (size_t)(group + 1) * PIN_HAL_CAP_CHANNELS - 1;
+                continue;
+            }
+        }
+        s_slots[i].resolution_hz = s_resolution_hz[group];
+        s_slots[i].chan = NULL;
+        return &s_slots[i];
+    }
+    return NULL;
+}
+
+esp_err_t debounce_pwm_add(debounce_entry_t *entry) {
+    const debounce_config_t *config = &entry->config;
+    pwm_slot_t *slot = claim_slot();
+    if (!slot) {
+        ESP_LOGE(TAG, "No free capture channel for GPIO %d", config->pin);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!slot->timer) {
+        esp_err_t err = pin_hal_timer_create(report_callback, slot, "debounce_pwm", false,
+                                             &slot->timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    uint32_t window_ms = config->count_window_ms ? config->count_window_ms
+                                                 : CONFIG_DEBOUNCE_PWM_WINDOW_MS;
+    uint32_t tick_ms = window_ms < CONFIG_DEBOUNCE_PWM_MAX_PERIOD_MS
+                       ? window_ms : CONFIG_DEBOUNCE_PWM_MAX_PERIOD_MS;
+    slot->max_period = (uint32_t)((uint64_t)slot->resolution_hz *
+                                  CONFIG_DEBOUNCE_PWM_MAX_PERIOD_MS / 1000);
+    slot->have_rise = false;
+    slot->have_high = false;
+    slot->acc = (pwm_acc_t){ 0 };
+    slot->tick_edges = 0;
+    slot->quiet_us = 0;
+    slot->tick_us = tick_ms * 1000;
+    slot->window_us = window_ms * 1000;
+    slot->have_report = false;
+    esp_err_t err = pin_hal_cap_channel_create(s_cap_timers[(slot - s_slots) / PIN_HAL_CAP_CHANNELS],
+                                               config->pin, config->pull_up, on_capture, slot,
+                                               &slot->chan);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Capture channel setup failed for GPIO %d: %s", config->pin,
+                 esp_err_to_name(err));
+        return err;
+    }
+
+    slot->window_start_us = pin_hal_time_us();
+    slot->entry = entry;
+    err = pin_hal_timer_start_periodic(slot->timer, (uint64_t)tick_ms * 1000);
+    if (err != ESP_OK) {
+        slot->entry = NULL;
+        (void)pin_hal_cap_channel_delete(slot->chan);
+        return err;
+    }
+    ESP_LOGI(TAG, "GPIO %d PWM capture at %u Hz, window %ums", config->pin,
+             (unsigned)slot->resolution_hz, (unsigned)window_ms);
+    return ESP_OK;
+}
+
+void debounce_pwm_remove(gpio_num_t pin) {
+    pwm_slot_t *slot = slot_of(pin);
+    if (!slot) {
+        return;
+    }
+    (void)pin_hal_timer_stop(slot->timer);
+    (void)pin_hal_timer_delete(slot->timer);
+    slot->timer = NULL;
+    (void)pin_hal_cap_channel_delete(slot->chan);
+    portENTER_CRITICAL(&s_pwm_lock);
+    slot->entry = NULL;
+    slot->have_report = false;
+    portEXIT_CRITICAL(&s_pwm_lock);
+}
+
+esp_err_t debounce_get_pwm(gpio_num_t pin, debounce_pwm_t *out) {
+    if (!out || !GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    portENTER_CRITICAL(&s_pwm_lock);
+    pwm_slot_t *slot = slot_of(pin);
+    if (slot) {
+        err = slot->have_report ? ESP_OK : ESP_ERR_INVALID_STATE;
+        *out = slot->report;
+    }
+    portEXIT_CRITICAL(&s_pwm_lock);
+    return err;
+}
+
+#else // !CONFIG_DEBOUNCE_PWM
+
+esp_err_t debounce_pwm_add(debounce_entry_t *entry) {
+    (void)entry;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void debounce_pwm_remove(gpio_num_t pin) {
+    (void)pin;
+}
+
+esp_err_t debounce_get_pwm(gpio_num_t pin, debounce_pwm_t *out) {
+    (void)pin;
+    (void)out;
+    return ESP_ERR_NOT_FOUND;
+}
+
+#endif // CONFIG_DEBOUNCE_PWM
@@ -0,0 +1,227 @@
+#include "sdkconfig.h"
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "private/debounce_internal.h"
+
+#if CONFIG_DEBOUNCE_CAPTURE
+
+static const char *TAG = "DebounceReplay";
+
+#define CAPTURE_HEADER_LEN  28
+#define CAPTURE_PIN_LEN     20
+
+typedef struct {
+    uint64_t at_us;  // Offset from the replay start
+    uint8_t  pin;    // Replay pin
+    uint8_t  level;
+} replay_edge_t;
+
+static replay_edge_t *s_edges;
+static uint32_t s_edge_count;
+static uint32_t s_next;
+static uint64_t s_pins;        // Replay pins registered by us
+static int64_t s_start_us;
+static volatile bool s_active;
+static pin_hal_timer_t s_timer;
+static debounce_replay_done_cb_t s_done;
+static void *s_done_arg;
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool get_varint(const uint8_t **p, const uint8_t *end, uint32_t *v) {
+    *v = 0;
+    for (int shift = 0; shift < 35 && *p < end; shift += 7) {
+        uint8_t b = *(*p)++;
+        *v |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static gpio_num_t map_pin(const debounce_replay_config_t *config, int pin) {
+    return config->pin_map ? config->pin_map[pin] : (gpio_num_t)pin;
+}
+
+// Drive every edge that is due, then sleep until the next one.
+static void replay_step(void *arg) {
+    (void)arg;
+    if (!s_active) {
+        return;
+    }
+    uint64_t elapsed = (uint64_t)(pin_hal_time_us() - s_start_us);
+    while (s_next < s_edge_count && s_edges[s_next].at_us <= elapsed) {
+        pin_hal_drive((gpio_num_t)s_edges[s_next].pin, s_edges[s_next].level);
+        s_next++;
+    }
+    if (s_next < s_edge_count) {
+        (void)pin_hal_timer_start_once(s_timer, s_edges[s_next].at_us - elapsed);
+        return;
+    }
+    s_active = false;
+    ESP_LOGI(TAG, "Replayed %u edges", (unsigned)s_edge_count);
+    if (s_done) {
+        s_done(s_done_arg);
+    }
+}
+
+static void release_pins(void) {
+    for (uint64_t pins = s_pins; pins; pins &= pins - 1) {
+        gpio_num_t pin = (gpio_num_t)__builtin_ctzll(pins);
+        (void)debounce_unregister_pin(pin);
+        (void)pin_hal_drive_disable(pin);
+    }
+    s_pins = 0;
+}
+
+// Decode the edge list, dropping unmapped pins; times become offsets from the start.
+static esp_err_t decode_edges(const debounce_replay_config_t *config, const uint8_t *p,
+                              const uint8_t *end, uint32_t count) {
+    s_edges = calloc(count ? count : 1, sizeof(*s_edges));
+    if (!s_edges) {
+        return ESP_ERR_NO_MEM;
+    }
+    uint64_t at_us = 0;
+    s_edge_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t dt_us;
+        if (p >= end) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        uint8_t b = *p++;
+        if (!get_varint(&p, end, &dt_us) || (b & 0x7f) >= GPIO_NUM_MAX) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        at_us += dt_us;
+        gpio_num_t pin = map_pin(config, b & 0x7f);
+        if (GPIO_IS_VALID_GPIO(pin) && (s_pins & (1ULL << pin))) {
+            s_edges[s_edge_count++] = (replay_edge_t){
+                .at_us = at_us, .pin = (uint8_t)pin, .level = (uint8_t)(b >> 7),
+            };
+        }
+    }
+    return ESP_OK;
+}
+
+// Drive each captured pin to its starting level and register it as captured.
+static esp_err_t setup_pins(const debounce_replay_config_t *config, const uint8_t *table,
+                            size_t pins, uint64_t levels) {
+    for (size_t i = 0; i < pins; i++) {
+        const uint8_t *e = table + i * CAPTURE_PIN_LEN;
+        if (e[0] >= GPIO_NUM_MAX) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        gpio_num_t pin = map_pin(config, e[0]);
+        if (!GPIO_IS_VALID_GPIO(pin)) {
+            continue;
+        }
+        if (debounce_pins[pin].in_use || (s_pins & (1ULL << pin))) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        debounce_config_t cfg = {
+            .pin = pin,
+            .engine = (debounce_engine_t)e[1],
+            .policy = (debounce_policy_t)e[2],
+            .intr_type = (gpio_int_type_t)e[3],
+            .pull_up = (e[4] & 1) != 0,
+            .state_change_only = (e[4] & 2) != 0,
+            .dispatch = (debounce_dispatch_t)e[5],
+            .debounce_time_us = get_u32(e + 8),
+            .press_time_us = get_u32(e + 12),
+            .release_time_us = get_u32(e + 16),
+        };
+        esp_err_t err = pin_hal_drive_enable(pin, (int)((levels >> e[0]) & 1));
+        if (err == ESP_OK) {
+            err = debounce_register_pin(&cfg);
+        }
+        if (err != ESP_OK) {
+            (void)pin_hal_drive_disable(pin);
+            return err;
+        }
+        s_pins |= 1ULL << pin;
+    }
+    return ESP_OK;
+}
+
+esp_err_t debounce_replay_start(const debounce_replay_config_t *config) {
+    if (!config || !config->data || config->len < CAPTURE_HEADER_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t *p = config->data;
+    const uint8_t *end = p + config->len;
+    if (memcmp(p, "DBCP", 4) != 0 || p[4] != 1) {
+        ESP_LOGE(TAG, "Not a version 1 capture");
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t pins = p[5];
+    uint32_t count = get_u32(p + 8);
+    uint64_t levels = get_u32(p + 20) | ((uint64_t)get_u32(p + 24) << 32);
+    if (config->len < CAPTURE_HEADER_LEN + pins * CAPTURE_PIN_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_active || s_pins) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!s_timer) {
+        esp_err_t err = pin_hal_timer_create(replay_step, NULL, "debounce_replay", false, &s_timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    esp_err_t err = setup_pins(config, p + CAPTURE_HEADER_LEN, pins, levels);
+    if (err == ESP_OK) {
+        err = decode_edges(config, p + CAPTURE_HEADER_LEN + pins * CAPTURE_PIN_LEN, end, count);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Replay setup failed: %s", esp_err_to_name(err));
+        debounce_replay_stop();
+        return err;
+    }
+
+    s_next = 0;
+    s_done = config->done;
+    s_done_arg = config->done_arg;
+    s_start_us = pin_hal_time_us();
+    s_active = true;
+    ESP_LOGI(TAG, "Replaying %u edges on %d pins", (unsigned)s_edge_count,
+             __builtin_popcountll(s_pins));
+    replay_step(NULL);
+    return ESP_OK;
+}
+
+void debounce_replay_stop(void) {
+    s_active = false;
+    if (s_timer) {
+        (void)pin_hal_timer_stop(s_timer);
+    }
+    release_pins();
+    free(s_edges);
+    s_edges = NULL;
+    s_edge_count = 0;
+}
+
+bool debounce_replay_active(void) {
+    return s_active;
+}
+
+#else // !CONFIG_DEBOUNCE_CAPTURE
+
+esp_err_t debounce_replay_start(const debounce_replay_config_t *config) {
+    (void)config;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void debounce_replay_stop(void) {
+}
+
+bool debounce_replay_active(void) {
+    return false;
+}
+
+#endif // CONFIG_DEBOUNCE_CAPTURE
@@ -0,0 +1,126 @@
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "private/debounce_internal.h"
+#include "app_shared.h"
+
+static const char *TAG = "DebounceSampler";
+
+// One bit per GPIO. Bits 0..31 come from GPIO_IN_REG, 32.. from GPIO_IN1_REG.
+static uint64_t s_sampled_mask = 0;  // Pins owned by the sampling engine
+static uint64_t s_rise_mask    = 0;  // Report 0 -> 1 transitions
+static uint64_t s_fall_mask    = 0;  // Report 1 -> 0 transitions
+
+// Vertical counter: bit i of (s_cnt1:s_cnt0) is a 2-bit counter for GPIO i.
+static uint64_t s_state = 0;         // Debounced level of every sampled pin
+static uint64_t s_cnt0  = 0;
+static uint64_t s_cnt1  = 0;
+
+static pin_hal_timer_t s_tick_timer = NULL;
+static portMUX_TYPE s_sampler_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * Advance every counter by one sample and return the mask of pins whose
+ * debounced level flipped. A pin flips after its raw level has differed from
+ * the debounced level on four consecutive ticks; any agreeing sample resets
+ * its counter. Cost is a handful of 64-bit ops regardless of how many pins
+ * are bouncing.
+ */
+static inline uint64_t vertical_counter_step(uint64_t sample) {
+    uint64_t delta = (sample ^ s_state) & s_sampled_mask;
+    s_cnt0 = ~s_cnt0 & delta;
+    s_cnt1 = (s_cnt1 ^ s_cnt0) & delta;
+    uint64_t toggle = delta & ~(s_cnt0 | s_cnt1);
+    s_state ^= toggle;
+    return toggle;
+}
+
+/**
+ * Periodic tick (timer task). Samples both input registers once, runs
+ * the vertical counters and hands the whole changed mask on.
+ */
+static void sampler_tick_callback(void *arg) {
+    int64_t now_us = pin_hal_time_us();
+    uint64_t sample = pin_hal_read_levels();
+
+    portENTER_CRITICAL(&s_sampler_lock);
+    uint64_t changed = vertical_counter_step(sample);
+    uint64_t state = s_state;
+    uint64_t report = (changed & state & s_rise_mask) | (changed & ~state & s_fall_mask);
+    portEXIT_CRITICAL(&s_sampler_lock);
+
+    gpio_stats_stage_inc(GPIO_STAGE_STAT_SAMPLER_TICKS);
+    for (uint64_t flipped = changed; flipped; flipped &= flipped - 1) {
+        int pin = __builtin_ctzll(flipped);
+        gpio_stats_pin_inc(pin, GPIO_PIN_STAT_BURSTS);
+        if (!((report >> pin) & 1)) {
+            gpio_stats_pin_inc(pin, GPIO_PIN_STAT_SUPPRESSED);
+        }
+    }
+    if (report) {
+        // The first of the four agreeing samples is the best edge estimate we have.
+        debounce_sampler_dispatch(report, state, now_us - 3 * CONFIG_DEBOUNCE_SAMPLE_PERIOD_US);
+    }
+}
+
+void debounce_sampler_dispatch(uint64_t changed, uint64_t state, int64_t edge_us) {
+    while (changed) {
+        int pin = __builtin_ctzll(changed);
+        changed &= changed - 1;
+        debounce_pins[pin].first_edge_us = edge_us;
+        debounce_emit_event(&debounce_pins[pin], GPIO_EVENT_LEVEL, (int)((state >> pin) & 1));
+    }
+}
+
+esp_err_t debounce_sampler_add(const debounce_config_t *config) {
+    if (!s_tick_timer) {
+        esp_err_t err = pin_hal_timer_create(sampler_tick_callback, NULL, "debounce_sample",
+                                             false, &s_tick_timer);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Sample timer create failed: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    uint64_t bit = 1ULL << config->pin;
+    bool rise = config->intr_type != GPIO_INTR_NEGEDGE;
+    bool fall = config->intr_type != GPIO_INTR_POSEDGE;
+
+    portENTER_CRITICAL(&s_sampler_lock);
+    bool was_idle = (s_sampled_mask == 0);
+    // Seed with the current level so registration does not report an edge.
+    s_state = (s_state & ~bit) | (pin_hal_read_levels() & bit);
+    s_cnt0 &= ~bit;
+    s_cnt1 &= ~bit;
+    s_rise_mask = rise ? (s_rise_mask | bit) : (s_rise_mask & ~bit);
+    s_fall_mask = fall ? (s_fall_mask | bit) : (s_fall_mask & ~bit);
+    s_sampled_mask |= bit;
+    portEXIT_CRITICAL(&s_sampler_lock);
+
+    if (was_idle) {
+        esp_err_t err = pin_hal_timer_start_periodic(s_tick_timer, CONFIG_DEBOUNCE_SAMPLE_PERIOD_US);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "Failed to start sample tick: %s", esp_err_to_name(err));
+            debounce_sampler_remove(config->pin);
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+void debounce_sampler_remove(gpio_num_t pin) {
+    uint64_t bit = 1ULL << pin;
+
+    portENTER_CRITICAL(&s_sampler_lock);
+    s_sampled_mask &= ~bit;
+    s_rise_mask &= ~bit;
+    s_fall_mask &= ~bit;
+    s_cnt0 &= ~bit;
+    s_cnt1 &= ~bit;
+    bool now_idle = (s_sampled_mask == 0);
+    portEXIT_CRITICAL(&s_sampler_lock);
+
+    if (now_idle && s_tick_timer) {
+        (void)pin_hal_timer_stop(s_tick_timer);
+    }
+}
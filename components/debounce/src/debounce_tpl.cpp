@@ -0,0 +1,116 @@
+#include "sdkconfig.h"
+#include "private/debounce_tpl.h"
+
+#if CONFIG_DEBOUNCE_TPL
+
+#include "esp_log.h"
+#include "debounce.hpp"
+
+namespace {
+
+const char *TAG = "DebounceTpl";
+
+template <class Policy>
+using Instance = debounce::Debouncer<Policy, debounce::PinHalClock, CONFIG_DEBOUNCE_TPL_PINS,
+                                     debounce::PortMuxLock>;
+
+Instance<debounce::Trailing>   s_trailing;
+Instance<debounce::Leading>    s_leading;
+Instance<debounce::Asymmetric> s_asymmetric;
+
+// Instance a pin was added to, so edges need no search.
+debounce_policy_t s_policy_of[GPIO_NUM_MAX];
+
+// Expiry tick: runs while any instance has a deadline pending. s_edged tells
+// the tick that an edge may have armed a pin after its poll looked.
+pin_hal_timer_t s_tick;
+portMUX_TYPE    s_tick_lock = portMUX_INITIALIZER_UNLOCKED;
+bool            s_ticking;
+bool            s_edged;
+
+void tick(void *arg) {
+    (void)arg;
+    auto report = [](const debounce::Report &r) {
+        debounce_tpl_report(r.pin, r.level, r.edge_us, nullptr);
+    };
+    int64_t next = s_trailing.poll(report);
+    int64_t t = s_leading.poll(report);
+    next = t < next ? t : next;
+    t = s_asymmetric.poll(report);
+    next = t < next ? t : next;
+
+    portENTER_CRITICAL(&s_tick_lock);
+    if (next == Instance<debounce::Trailing>::never && !s_edged) {
+        s_ticking = false;
+        (void)pin_hal_timer_stop(s_tick);
+    }
+    s_edged = false;
+    portEXIT_CRITICAL(&s_tick_lock);
+}
+
+} // namespace
+
+extern "C" esp_err_t debounce_tpl_add(const debounce_config_t *config) {
+    if (!s_tick) {
+        esp_err_t err = pin_hal_timer_create(tick, nullptr, "debounce_tpl", false, &s_tick);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Timer create failed: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+    int level = static_cast<int>((pin_hal_read_levels() >> config->pin) & 1);
+    uint32_t window = config->debounce_time_us;
+    bool ok;
+    switch (config->policy) {
+    case DEBOUNCE_POLICY_LEADING:
+        ok = s_leading.add(config->pin, window, level);
+        break;
+    case DEBOUNCE_POLICY_ASYMMETRIC:
+        ok = s_asymmetric.add(config->pin, config->press_time_us ? config->press_time_us : window,
+                              level, config->release_time_us ? config->release_time_us : window,
+                              config->pull_up);
+        break;
+    default:
+        ok = s_trailing.add(config->pin, window, level);
+        break;
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "GPIO %d: no free slot (CONFIG_DEBOUNCE_TPL_PINS)", config->pin);
+        return ESP_ERR_NO_MEM;
+    }
+    s_policy_of[config->pin] = config->policy;
+    return ESP_OK;
+}
+
+extern "C" void debounce_tpl_remove(gpio_num_t pin) {
+    switch (s_policy_of[pin]) {
+    case DEBOUNCE_POLICY_LEADING:    s_leading.remove(pin); break;
+    case DEBOUNCE_POLICY_ASYMMETRIC: s_asymmetric.remove(pin); break;
+    default:                         s_trailing.remove(pin); break;
+    }
+}
+
+extern "C" IRAM_ATTR void debounce_tpl_edge(gpio_num_t pin, int level,
+                                            BaseType_t *hp_task_woken) {
+    debounce::Report r;
+    bool now;
+    switch (s_policy_of[pin]) {
+    case DEBOUNCE_POLICY_LEADING:    now = s_leading.edge(pin, level, r); break;
+    case DEBOUNCE_POLICY_ASYMMETRIC: now = s_asymmetric.edge(pin, level, r); break;
+    default:                         now = s_trailing.edge(pin, level, r); break;
+    }
+
+    portENTER_CRITICAL_SAFE(&s_tick_lock);
+    s_edged = true;
+    if (!s_ticking) {
+        s_ticking = true;
+        (void)pin_hal_timer_start_periodic(s_tick, CONFIG_DEBOUNCE_WHEEL_TICK_US);
+    }
+    portEXIT_CRITICAL_SAFE(&s_tick_lock);
+
+    if (now) {
+        debounce_tpl_report(r.pin, r.level, r.edge_us, hp_task_woken);
+    }
+}
+
+#endif // CONFIG_DEBOUNCE_TPL
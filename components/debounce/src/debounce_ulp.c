@@ -0,0 +1,138 @@
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "debounce_ulp.h"
+
+#if CONFIG_DEBOUNCE_ULP
+
+static const char *TAG = "DebounceULP";
+
+#define ULP_MAX_POLLS 255  // pin_hal_lp_shared_t counts polls in a byte
+
+static uint64_t s_heartbeat_us;
+
+// Debounce window of a pin, or 0 if the ULP cannot watch it.
+static uint32_t window_us(const debounce_config_t *pin) {
+    if (!pin_hal_lp_pin_valid(pin->pin)) {
+        return 0;
+    }
+    switch (pin->engine) {
+    case DEBOUNCE_ENGINE_TIMER:
+        return pin->debounce_time_us ? pin->debounce_time_us : 1;
+    case DEBOUNCE_ENGINE_SAMPLED:
+        return 4 * CONFIG_DEBOUNCE_SAMPLE_PERIOD_US;
+    default:
+        return 0;
+    }
+}
+
+esp_err_t debounce_ulp_start(const debounce_config_t *pins, size_t count,
+                             const debounce_ulp_config_t *config, bool *resumed) {
+    static const debounce_ulp_config_t defaults = { 0 };
+    if (!pins && count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!config) {
+        config = &defaults;
+    }
+    pin_hal_lp_config_t lp = {
+        .poll_us = config->poll_us ? config->poll_us : CONFIG_DEBOUNCE_ULP_POLL_US,
+        .watermark = config->watermark ? config->watermark : CONFIG_DEBOUNCE_ULP_WATERMARK,
+        .max_latency_ms = config->max_latency_ms ? config->max_latency_ms
+                                                 : CONFIG_DEBOUNCE_ULP_MAX_LATENCY_S * 1000u,
+    };
+    uint64_t skipped = 0;
+    for (size_t i = 0; i < count; i++) {
+        const debounce_config_t *pin = &pins[i];
+        uint32_t window = window_us(pin);
+        if (!window) {
+            skipped |= 1ULL << pin->pin;
+            continue;
+        }
+        uint32_t bit = 1u << pin->pin;
+        uint32_t polls = (window + lp.poll_us - 1) / lp.poll_us;
+        lp.pin_mask |= bit;
+        lp.pull_up_mask |= pin->pull_up ? bit : 0;
+        lp.priority_mask |= (config->priority_mask >> pin->pin) & 1 ? bit : 0;
+        lp.stable_polls[pin->pin] = polls > ULP_MAX_POLLS ? ULP_MAX_POLLS : polls;
+    }
+    if (!lp.pin_mask) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    bool resumed_run = false;
+    esp_err_t err = pin_hal_lp_start(&lp, &resumed_run);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ULP start failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    if (!resumed_run) {
+        if (skipped) {
+            ESP_LOGW(TAG, "Not monitored in deep sleep: pins 0x%llx", (unsigned long long)skipped);
+        }
+        ESP_LOGI(TAG, "ULP monitoring pins 0x%" PRIx32 " every %" PRIu32 " us", lp.pin_mask,
+                 lp.poll_us);
+    }
+    s_heartbeat_us = (uint64_t)(config->heartbeat_s ? config->heartbeat_s
+                                                    : CONFIG_DEBOUNCE_ULP_HEARTBEAT_S) * 1000000u;
+    if (resumed) {
+        *resumed = resumed_run;
+    }
+    return ESP_OK;
+}
+
+uint32_t debounce_ulp_wake_cause(void) {
+    return pin_hal_lp_wake_cause();
+}
+
+size_t debounce_ulp_peek(debounce_ulp_event_t *out, size_t max, uint32_t *lost) {
+    if (!out) {
+        max = 0;
+    }
+    return pin_hal_lp_peek(out, max, lost);
+}
+
+void debounce_ulp_consume(size_t n) {
+    pin_hal_lp_consume(n);
+}
+
+esp_err_t debounce_ulp_sleep(void) {
+    ESP_LOGD(TAG, "Deep sleep, heartbeat in %llu s", (unsigned long long)(s_heartbeat_us / 1000000));
+    return pin_hal_lp_sleep(s_heartbeat_us);
+}
+
+#else // !CONFIG_DEBOUNCE_ULP
+
+esp_err_t debounce_ulp_start(const debounce_config_t *pins, size_t count,
+                             const debounce_ulp_config_t *config, bool *resumed) {
+    (void)pins;
+    (void)count;
+    (void)config;
+    if (resumed) {
+        *resumed = false;
+    }
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+uint32_t debounce_ulp_wake_cause(void) {
+    return 0;
+}
+
+size_t debounce_ulp_peek(debounce_ulp_event_t *out, size_t max, uint32_t *lost) {
+    (void)out;
+    (void)max;
+    if (lost) {
+        *lost = 0;
+    }
+    return 0;
+}
+
+void debounce_ulp_consume(size_t n) {
+    (void)n;
+}
+
+esp_err_t debounce_ulp_sleep(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_DEBOUNCE_ULP
@@ -0,0 +1,199 @@
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "private/debounce_internal.h"
+
+static const char *TAG = "DebounceWheel";
+
+#define L0_MASK  (DEBOUNCE_WHEEL_L0_SLOTS - 1)
+#define L1_MASK  (DEBOUNCE_WHEEL_L1_SLOTS - 1)
+#define L1_SPAN  (DEBOUNCE_WHEEL_L0_SLOTS * DEBOUNCE_WHEEL_L1_SLOTS)
+
+#define NODE_TO_ENTRY(n) \
+    ((debounce_entry_t *)((char *)(n) - offsetof(debounce_entry_t, wheel_node)))
+
+// Everything below can run in the esp_timer ISR for ISR-dispatched wheels,
+// so the tick path lives in IRAM.
+
+static inline void list_init(debounce_wheel_node_t *head) {
+    head->next = head;
+    head->prev = head;
+}
+
+static inline IRAM_ATTR void list_unlink(debounce_wheel_node_t *node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = NULL;
+    node->prev = NULL;
+}
+
+static inline IRAM_ATTR void list_push(debounce_wheel_node_t *head, debounce_wheel_node_t *node) {
+    node->next = head;
+    node->prev = head->prev;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+// Place an unlinked node in the slot matching its deadline. Caller holds the lock.
+// delta == 0 only happens while cascading, right before the current slot is drained.
+// Deadlines past the horizon park in its last level-1 bucket, keep their real
+// expiry and are placed again when that bucket cascades.
+static IRAM_ATTR void wheel_insert(debounce_wheel_t *wheel, debounce_wheel_node_t *node) {
+    uint32_t delta = node->expires - wheel->now;
+    if (delta > UINT32_MAX / 2) {
+        node->expires = wheel->now + 1; // Overdue: fire on the next tick
+        delta = 1;
+    } else if (delta >= L1_SPAN) {
+        uint32_t horizon = wheel->now + L1_SPAN - 1;
+        list_push(&wheel->l1[(horizon >> DEBOUNCE_WHEEL_L0_BITS) & L1_MASK], node);
+        return;
+    }
+
+    if (delta < DEBOUNCE_WHEEL_L0_SLOTS) {
+        list_push(&wheel->l0[node->expires & L0_MASK], node);
+    } else {
+        list_push(&wheel->l1[(node->expires >> DEBOUNCE_WHEEL_L0_BITS) & L1_MASK], node);
+    }
+}
+
+static inline IRAM_ATTR uint32_t wheel_ticks_elapsed(const debounce_wheel_t *wheel) {
+    return (uint32_t)((pin_hal_time_us() - wheel->base_us) / CONFIG_DEBOUNCE_WHEEL_TICK_US);
+}
+
+/**
+ * Periodic tick (esp_timer task, or its ISR for ISR dispatch). Catches the
+ * cursor up to wall time, so a late tick never loses deadlines. Each tick's
+ * due entries are detached under the lock and handed over as one batch
+ * outside it; the GPIO ISR may re-arm them meanwhile without touching the
+ * batch.
+ */
+static IRAM_ATTR void wheel_tick_callback(void *arg) {
+    debounce_wheel_t *wheel = (debounce_wheel_t *)arg;
+    debounce_entry_t *batch[GPIO_NUM_MAX];
+
+    uint32_t target = wheel_ticks_elapsed(wheel);
+    for (;;) {
+        size_t count = 0;
+
+        portENTER_CRITICAL_SAFE(&wheel->lock);
+        if (!wheel->running || (int32_t)(target - wheel->now) <= 0) {
+            if (wheel->running && wheel->pending == 0) {
+                // Idle: park the tick until the next arm.
+                wheel->running = false;
+                (void)pin_hal_timer_stop(wheel->timer);
+            }
+            portEXIT_CRITICAL_SAFE(&wheel->lock);
+            return;
+        }
+
+        uint32_t now = ++wheel->now;
+        gpio_stats_stage_inc(GPIO_STAGE_STAT_WHEEL_TICKS);
+        if ((now & L0_MASK) == 0) {
+            // Level 0 wrapped: spread the next level-1 bucket over level 0.
+            debounce_wheel_node_t *bucket = &wheel->l1[(now >> DEBOUNCE_WHEEL_L0_BITS) & L1_MASK];
+            while (bucket->next != bucket) {
+                debounce_wheel_node_t *node = bucket->next;
+                list_unlink(node);
+                wheel_insert(wheel, node);
+            }
+        }
+
+        debounce_wheel_node_t *slot = &wheel->l0[now & L0_MASK];
+        while (slot->next != slot) {
+            debounce_wheel_node_t *node = slot->next;
+            list_unlink(node);
+            batch[count++] = NODE_TO_ENTRY(node);
+        }
+        wheel->pending -= count;
+        portEXIT_CRITICAL_SAFE(&wheel->lock);
+
+        if (count) {
+            wheel->expired(batch, count);
+        }
+    }
+}
+
+esp_err_t debounce_wheel_init(debounce_wheel_t *wheel, const char *name,
+                              bool isr_dispatch,
+                              debounce_wheel_expired_cb_t expired) {
+    for (size_t i = 0; i < DEBOUNCE_WHEEL_L0_SLOTS; i++) {
+        list_init(&wheel->l0[i]);
+    }
+    for (size_t i = 0; i < DEBOUNCE_WHEEL_L1_SLOTS; i++) {
+        list_init(&wheel->l1[i]);
+    }
+    wheel->now = 0;
+    wheel->base_us = 0;
+    wheel->pending = 0;
+    wheel->running = false;
+    wheel->expired = expired;
+    portMUX_INITIALIZE(&wheel->lock);
+
+    esp_err_t err = pin_hal_timer_create(wheel_tick_callback, wheel, name, isr_dispatch,
+                                         &wheel->timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Timer create failed for %s: %s", name, esp_err_to_name(err));
+    }
+    return err;
+}
+
+// Move or insert one deadline. Caller holds the lock.
+static IRAM_ATTR bool wheel_arm_locked(debounce_wheel_t *wheel, debounce_entry_t *entry,
+                                      int64_t now_us, uint32_t delay_us) {
+    debounce_wheel_node_t *node = &entry->wheel_node;
+
+    if (!wheel->running) {
+        // Wheel is empty while parked, so it can restart from tick 0.
+        wheel->base_us = now_us;
+        wheel->now = 0;
+        wheel->running = true;
+        (void)pin_hal_timer_start_periodic(wheel->timer, CONFIG_DEBOUNCE_WHEEL_TICK_US);
+    }
+    bool fresh = (node->prev == NULL);
+    if (fresh) {
+        wheel->pending++;
+    } else {
+        list_unlink(node);
+    }
+    // Round the deadline up from wall time, not the cursor, so the window is
+    // never short and a lagging tick does not stretch it.
+    int64_t deadline_us = now_us - wheel->base_us + delay_us;
+    uint32_t expires = (uint32_t)((deadline_us + CONFIG_DEBOUNCE_WHEEL_TICK_US - 1) /
+                                  CONFIG_DEBOUNCE_WHEEL_TICK_US);
+    node->expires = (expires == wheel->now) ? expires + 1 : expires;
+    wheel_insert(wheel, node);
+    return fresh;
+}
+
+IRAM_ATTR bool debounce_wheel_arm(debounce_wheel_t *wheel, debounce_entry_t *entry, uint32_t delay_us) {
+    portENTER_CRITICAL_SAFE(&wheel->lock);
+    bool fresh = wheel_arm_locked(wheel, entry, pin_hal_time_us(), delay_us);
+    portEXIT_CRITICAL_SAFE(&wheel->lock);
+    return fresh;
+}
+
+IRAM_ATTR uint64_t debounce_wheel_arm_batch(debounce_wheel_t *wheel, debounce_entry_t **entries,
+                                            const uint32_t *delays_us, size_t count) {
+    uint64_t fresh = 0;
+
+    portENTER_CRITICAL_SAFE(&wheel->lock);
+    int64_t now_us = pin_hal_time_us();
+    for (size_t i = 0; i < count; i++) {
+        if (wheel_arm_locked(wheel, entries[i], now_us, delays_us[i])) {
+            fresh |= 1ULL << i;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&wheel->lock);
+    return fresh;
+}
+
+IRAM_ATTR void debounce_wheel_cancel(debounce_wheel_t *wheel, debounce_entry_t *entry) {
+    debounce_wheel_node_t *node = &entry->wheel_node;
+
+    portENTER_CRITICAL_SAFE(&wheel->lock);
+    if (node->prev) {
+        list_unlink(node);
+        wheel->pending--;
+    }
+    portEXIT_CRITICAL_SAFE(&wheel->lock);
+}
@@ -0,0 +1,653 @@
+#pragma once
+
+/**
+ * Thin hardware layer under the debounce engine and the event pipeline:
+ * GPIO input/interrupt control, the microsecond clock, periodic timers, pulse
+ * counter units, edge capture channels, RMT receive channels, the parallel
+ * sampler and the low-power monitor on the ULP coprocessor.
+ *
+ * On hardware every call is a forced-inline pass-through to the GPIO, PCNT,
+ * MCPWM and RMT drivers, esp_timer and the GPIO registers, so it adds no cost
+ * and stays IRAM-safe. The parallel sampler has no driver to pass through to
+ * and is implemented on the camera interface in pin_hal_par.c; the low-power
+ * monitor loads its ULP program in pin_hal_lp.c.
+ * On the linux target the calls go to a simulated backend (pin_hal_sim.c)
+ * with a virtual clock, driven by the waveform injector in pin_sim.h.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "pin_hal_types.h"
+#include "pin_hal_lp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*pin_hal_isr_t)(void *arg);
+typedef void (*pin_hal_timer_cb_t)(void *arg);
+
+// Pulse counter unit (pin_hal_pcnt_create()): counts the selected edges of pin
+// after its glitch filter, wraps to zero at +/-limit and calls the limit
+// callback from its interrupt on every wrap. With quadrature_pin set, pin and
+// quadrature_pin are the A and B outputs of an encoder, decoded x4 (every edge
+// of either is one count, up when A leads B); count_rise/count_fall are ignored.
+typedef struct {
+    gpio_num_t pin;
+    gpio_num_t quadrature_pin; // GPIO_NUM_NC for a plain counter
+    bool       count_rise;
+    bool       count_fall;
+    int        limit;      // 1..32767
+    uint32_t   glitch_ns;  // Narrower pulses are ignored; 0 turns the filter off
+} pin_hal_pcnt_config_t;
+
+// Edge capture (pin_hal_cap_channel_create()): a channel latches its group's
+// free-running capture timer on both edges of pin in hardware and calls the
+// capture callback from its interrupt with the latched value and the edge.
+// The timer counts at the resolution returned by pin_hal_cap_timer_create()
+// and wraps at 32 bits.
+
+// RMT receive channel (pin_hal_rmt_rx_create()): once armed with
+// pin_hal_rmt_rx_receive(), records the levels of pin and their durations as
+// symbols into the given buffer without CPU work, ignoring pulses shorter than
+// min_ns, and calls the done callback from its interrupt once the pin has had
+// no edge for max_ns. The last symbol half has a zero duration. Durations are
+// 15-bit counts at resolution_hz.
+typedef struct {
+    gpio_num_t pin;
+    uint32_t   resolution_hz;
+    size_t     mem_symbols;  // Channel memory; at least PIN_HAL_RMT_MEM_SYMBOLS without DMA
+    bool       dma;          // Receive through DMA (not every channel can)
+} pin_hal_rmt_rx_config_t;
+
+// Parallel sampler (pin_hal_par_create()): once started, samples all its pins
+// together at a fixed rate into a ring of buffers without CPU work. Bit i of a
+// sample is pins[i]; a sample is one byte for up to 8 pins and two (little-
+// endian) for more. The done callback runs in the DMA interrupt with every
+// filled buffer, in order; a buffer is overwritten once the ring comes round to
+// it again. The pins are tapped through the GPIO matrix, so their input setup
+// and interrupts stay as they are.
+typedef struct pin_hal_par *pin_hal_par_t;
+typedef bool (*pin_hal_par_cb_t)(pin_hal_par_t par, const void *samples, size_t bytes, void *arg);
+typedef struct {
+    const gpio_num_t *pins;
+    size_t            pin_count;    // 1..PIN_HAL_PAR_MAX_PINS
+    gpio_num_t        clock_pin;    // Unused GPIO the sample clock is looped back through
+    uint32_t          sample_hz;    // Rounded to a divider of the source clock
+    size_t            buffer_bytes; // Multiple of 4, at most PIN_HAL_PAR_MAX_BUFFER
+    size_t            buffers;      // At least 2
+} pin_hal_par_config_t;
+
+// Low-power monitor (pin_hal_lp_start()): the ULP coprocessor polls the RTC
+// GPIOs of pin_mask every poll_us, also while the main CPU is in deep sleep,
+// debounces them and queues their changes in RTC memory (pin_hal_lp.h). It
+// wakes the CPU once watermark new events are queued, a pin of priority_mask
+// has changed or the oldest new event is max_latency_ms old. An event is new
+// until pin_hal_lp_peek() has returned it, and queued until consumed.
+typedef struct {
+    uint32_t pin_mask;        // Bit n = GPIO n; each must pass pin_hal_lp_pin_valid()
+    uint32_t pull_up_mask;
+    uint32_t priority_mask;
+    uint8_t  stable_polls[PIN_HAL_LP_MAX_GPIO]; // By GPIO: polls a new level must hold
+    uint32_t poll_us;         // At least PIN_HAL_LP_MIN_POLL_US
+    uint32_t watermark;       // 1..PIN_HAL_LP_EVENTS
+    uint32_t max_latency_ms;  // 0 = no latency wake
+} pin_hal_lp_config_t;
+
+typedef struct {
+    gpio_num_t pin;
+    int        level;
+    int64_t    age_us;  // How long before the pin_hal_lp_peek() call the pin changed
+} pin_hal_lp_event_t;
+
+#if !CONFIG_IDF_TARGET_LINUX
+
+#include "esp_timer.h"
+#include "esp_intr_alloc.h"
+#include "soc/soc.h"
+#include "soc/gpio_reg.h"
+#include "soc/soc_caps.h"
+#include "driver/pulse_cnt.h"
+#include "driver/mcpwm_cap.h"
+#include "driver/rmt_rx.h"
+#if !CONFIG_FREERTOS_UNICORE
+#include "freertos/FreeRTOS.h"
+#include "esp_ipc.h"
+#endif
+
+#define PIN_HAL_INTR_LEVEL1 ESP_INTR_FLAG_LEVEL1
+#define PIN_HAL_INTR_LEVEL2 ESP_INTR_FLAG_LEVEL2
+#define PIN_HAL_INTR_LEVEL3 ESP_INTR_FLAG_LEVEL3
+#define PIN_HAL_INTR_IRAM   ESP_INTR_FLAG_IRAM
+
+#define PIN_HAL_PCNT_UNITS  (SOC_PCNT_GROUPS * SOC_PCNT_UNITS_PER_GROUP)
+#define PIN_HAL_CAP_GROUPS   SOC_MCPWM_GROUPS
+#define PIN_HAL_CAP_CHANNELS SOC_MCPWM_CAPTURE_CHANNELS_PER_TIMER  // Per group
+#define PIN_HAL_CAP_EDGE_POS MCPWM_CAP_EDGE_POS
+#define PIN_HAL_CAP_EDGE_NEG MCPWM_CAP_EDGE_NEG
+#define PIN_HAL_RMT_RX_CHANNELS  SOC_RMT_RX_CANDIDATES_PER_GROUP
+#define PIN_HAL_RMT_MEM_SYMBOLS  SOC_RMT_MEM_WORDS_PER_CHANNEL
+#define PIN_HAL_PAR_MAX_PINS     16    // Camera data inputs
+#define PIN_HAL_PAR_MAX_BUFFER   4092  // One DMA descriptor
+#define PIN_HAL_PAR_MIN_HZ       625000   // 160 MHz / 256
+#define PIN_HAL_PAR_MAX_HZ       20000000
+
+typedef esp_timer_handle_t pin_hal_timer_t;
+typedef gpio_isr_handle_t  pin_hal_intr_handle_t;
+
+// The limit callback is the driver's watch point callback; it runs in the PCNT ISR.
+typedef pcnt_unit_handle_t      pin_hal_pcnt_unit_t;
+typedef pcnt_watch_event_data_t pin_hal_pcnt_event_t;
+typedef pcnt_watch_cb_t         pin_hal_pcnt_cb_t;
+
+typedef struct {
+    pcnt_unit_handle_t    unit;
+    pcnt_channel_handle_t chan[2];
+} pin_hal_pcnt_t;
+
+// The capture callback is the driver's; it runs in the MCPWM ISR.
+typedef mcpwm_cap_timer_handle_t   pin_hal_cap_timer_t;
+typedef mcpwm_cap_channel_handle_t pin_hal_cap_channel_t;
+typedef mcpwm_capture_event_data_t pin_hal_cap_event_t;
+typedef mcpwm_capture_event_cb_t   pin_hal_cap_cb_t;
+
+// The done callback is the driver's; it runs in the RMT ISR.
+typedef rmt_channel_handle_t     pin_hal_rmt_rx_t;
+typedef rmt_symbol_word_t        pin_hal_rmt_symbol_t;
+typedef rmt_rx_done_event_data_t pin_hal_rmt_rx_event_t;
+typedef rmt_rx_done_callback_t   pin_hal_rmt_rx_cb_t;
+
+FORCE_INLINE_ATTR int64_t pin_hal_time_us(void) {
+    return esp_timer_get_time();
+}
+
+// Raw level of every GPIO, bit n = GPIO n.
+FORCE_INLINE_ATTR uint64_t pin_hal_read_levels(void) {
+    return ((uint64_t)REG_READ(GPIO_IN1_REG) << 32) | REG_READ(GPIO_IN_REG);
+}
+
+// Read and clear the interrupt status of every GPIO (global handler only).
+// Cleared before the caller works, so a new edge raises the interrupt again.
+FORCE_INLINE_ATTR uint64_t pin_hal_take_intr_status(void) {
+    uint32_t status0 = REG_READ(GPIO_STATUS_REG);
+    uint32_t status1 = REG_READ(GPIO_STATUS1_REG);
+    REG_WRITE(GPIO_STATUS_W1TC_REG, status0);
+    REG_WRITE(GPIO_STATUS1_W1TC_REG, status1);
+    return ((uint64_t)status1 << 32) | status0;
+}
+
+FORCE_INLINE_ATTR esp_err_t pin_hal_intr_enable(gpio_num_t pin) {
+    return gpio_intr_enable(pin);
+}
+
+FORCE_INLINE_ATTR esp_err_t pin_hal_intr_disable(gpio_num_t pin) {
+    return gpio_intr_disable(pin);
+}
+
+// A pin already driven by pin_hal_drive_enable() stays driven (replay loopback).
+static inline esp_err_t pin_hal_config_input(gpio_num_t pin, bool pull_up,
+                                             gpio_int_type_t intr_type) {
+    uint32_t enable = REG_READ(pin < 32 ? GPIO_ENABLE_REG : GPIO_ENABLE1_REG);
+    bool driven = (enable >> (pin & 31)) & 1;
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << pin),
+        .mode = driven ? GPIO_MODE_INPUT_OUTPUT : GPIO_MODE_INPUT,
+        .pull_up_en = pull_up ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = intr_type,
+    };
+    return gpio_config(&io_conf);
+}
+
+// Configure many inputs with one gpio_config(); pins in pull_up_mask also get
+// the pull-up. Interrupts stay off: set them per pin with pin_hal_set_intr_type()
+// and pin_hal_intr_enable().
+static inline esp_err_t pin_hal_config_inputs(uint64_t mask, uint64_t pull_up_mask) {
+    gpio_config_t io_conf = {
+        .pin_bit_mask = mask,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    esp_err_t err = gpio_config(&io_conf);
+    for (uint64_t pins = mask & pull_up_mask; err == ESP_OK && pins; pins &= pins - 1) {
+        err = gpio_pullup_en((gpio_num_t)__builtin_ctzll(pins));
+    }
+    return err;
+}
+
+static inline esp_err_t pin_hal_set_pull_up(gpio_num_t pin, bool pull_up) {
+    return gpio_set_pull_mode(pin, pull_up ? GPIO_PULLUP_ONLY : GPIO_FLOATING);
+}
+
+static inline esp_err_t pin_hal_set_intr_type(gpio_num_t pin, gpio_int_type_t intr_type) {
+    return gpio_set_intr_type(pin, intr_type);
+}
+
+static inline esp_err_t pin_hal_isr_service_install(int intr_flags) {
+    return gpio_install_isr_service(intr_flags);
+}
+
+static inline esp_err_t pin_hal_isr_handler_add(gpio_num_t pin, pin_hal_isr_t isr, void *arg) {
+    return gpio_isr_handler_add(pin, isr, arg);
+}
+
+static inline esp_err_t pin_hal_isr_handler_remove(gpio_num_t pin) {
+    return gpio_isr_handler_remove(pin);
+}
+
+static inline esp_err_t pin_hal_isr_register(pin_hal_isr_t isr, void *arg, int intr_flags,
+                                             pin_hal_intr_handle_t *handle) {
+    return gpio_isr_register(isr, arg, intr_flags, handle);
+}
+
+// Run fn on the given core (interrupts are allocated on the calling core).
+static inline esp_err_t pin_hal_run_on_core(int core, void (*fn)(void *), void *arg) {
+#if !CONFIG_FREERTOS_UNICORE
+    if (core >= 0 && core != xPortGetCoreID()) {
+        return esp_ipc_call_blocking(core, fn, arg);
+    }
+#endif
+    fn(arg);
+    return ESP_OK;
+}
+
+static inline esp_err_t pin_hal_timer_create(pin_hal_timer_cb_t cb, void *arg, const char *name,
+                                             bool isr_dispatch, pin_hal_timer_t *out) {
+    const esp_timer_create_args_t timer_args = {
+        .callback = cb,
+        .arg = arg,
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+        .dispatch_method = isr_dispatch ? ESP_TIMER_ISR : ESP_TIMER_TASK,
+#else
+        .dispatch_method = ESP_TIMER_TASK,
+#endif
+        .name = name,
+    };
+    return esp_timer_create(&timer_args, out);
+}
+
+FORCE_INLINE_ATTR esp_err_t pin_hal_timer_start_periodic(pin_hal_timer_t timer, uint64_t period_us) {
+    return esp_timer_start_periodic(timer, period_us);
+}
+
+FORCE_INLINE_ATTR esp_err_t pin_hal_timer_start_once(pin_hal_timer_t timer, uint64_t timeout_us) {
+    return esp_timer_start_once(timer, timeout_us);
+}
+
+FORCE_INLINE_ATTR esp_err_t pin_hal_timer_stop(pin_hal_timer_t timer) {
+    return esp_timer_stop(timer);
+}
+
+// The timer must be stopped.
+static inline esp_err_t pin_hal_timer_delete(pin_hal_timer_t timer) {
+    return esp_timer_delete(timer);
+}
+
+// From an ISR-dispatched timer callback: request a context switch on exit.
+FORCE_INLINE_ATTR void pin_hal_timer_isr_yield(void) {
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    esp_timer_isr_dispatch_need_yield();
+#endif
+}
+
+// Loopback drive for replay: the pin keeps its input and interrupt and also
+// drives level, so the engine sees real edges. Use a pin with nothing attached.
+static inline esp_err_t pin_hal_drive_enable(gpio_num_t pin, int level) {
+    esp_err_t err = gpio_set_level(pin, level);
+    return err == ESP_OK ? gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT) : err;
+}
+
+static inline esp_err_t pin_hal_drive_disable(gpio_num_t pin) {
+    return gpio_set_direction(pin, GPIO_MODE_INPUT);
+}
+
+// Produce an edge towards level. If the pin is already there (the other half
+// of the edge was never seen), pulse it so the interrupt still fires.
+FORCE_INLINE_ATTR void pin_hal_drive(gpio_num_t pin, int level) {
+    if ((int)((pin_hal_read_levels() >> pin) & 1) == (level != 0)) {
+        gpio_set_level(pin, !level);
+    }
+    gpio_set_level(pin, level);
+}
+
+static inline esp_err_t pin_hal_pcnt_delete(pin_hal_pcnt_t *pcnt) {
+    if (pcnt->unit) {
+        (void)pcnt_unit_stop(pcnt->unit);
+        (void)pcnt_unit_disable(pcnt->unit);
+    }
+    esp_err_t err = ESP_OK;
+    for (int i = 0; i < 2; i++) {
+        if (err == ESP_OK && pcnt->chan[i]) {
+            err = pcnt_del_channel(pcnt->chan[i]);
+        }
+        pcnt->chan[i] = NULL;
+    }
+    if (err == ESP_OK && pcnt->unit) {
+        err = pcnt_del_unit(pcnt->unit);
+    }
+    pcnt->unit = NULL;
+    return err;
+}
+
+// One channel per input. For quadrature each channel watches its own pin's
+// edges and uses the other pin's level to pick the direction.
+static inline esp_err_t pin_hal_pcnt_add_channel(pin_hal_pcnt_t *pcnt, int index,
+                                                 gpio_num_t edge_pin, gpio_num_t level_pin,
+                                                 pcnt_channel_edge_action_t rise,
+                                                 pcnt_channel_edge_action_t fall) {
+    const pcnt_chan_config_t chan_config = {
+        .edge_gpio_num = edge_pin,
+        .level_gpio_num = level_pin,
+    };
+    esp_err_t err = pcnt_new_channel(pcnt->unit, &chan_config, &pcnt->chan[index]);
+    if (err == ESP_OK) {
+        err = pcnt_channel_set_edge_action(pcnt->chan[index], rise, fall);
+    }
+    if (err == ESP_OK && level_pin != GPIO_NUM_NC) {
+        err = pcnt_channel_set_level_action(pcnt->chan[index], PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+                                            PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+    }
+    return err;
+}
+
+// The pins keep their GPIO input setup (pull-up); the unit taps them through the GPIO matrix.
+static inline esp_err_t pin_hal_pcnt_create(const pin_hal_pcnt_config_t *config,
+                                            pin_hal_pcnt_cb_t on_limit, void *arg,
+                                            pin_hal_pcnt_t *out) {
+    const pcnt_unit_config_t unit_config = {
+        .low_limit = -config->limit,
+        .high_limit = config->limit,
+    };
+    const pcnt_glitch_filter_config_t filter = { .max_glitch_ns = config->glitch_ns };
+    const pcnt_event_callbacks_t cbs = { .on_reach = on_limit };
+    bool quadrature = (config->quadrature_pin != GPIO_NUM_NC);
+
+    out->unit = NULL;
+    out->chan[0] = out->chan[1] = NULL;
+    esp_err_t err = pcnt_new_unit(&unit_config, &out->unit);
+    if (err == ESP_OK && config->glitch_ns) {
+        err = pcnt_unit_set_glitch_filter(out->unit, &filter);
+    }
+    if (err == ESP_OK && quadrature) {
+        err = pin_hal_pcnt_add_channel(out, 0, config->pin, config->quadrature_pin,
+                                       PCNT_CHANNEL_EDGE_ACTION_DECREASE,
+                                       PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+        if (err == ESP_OK) {
+            err = pin_hal_pcnt_add_channel(out, 1, config->quadrature_pin, config->pin,
+                                           PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+                                           PCNT_CHANNEL_EDGE_ACTION_DECREASE);
+        }
+        if (err == ESP_OK) {
+            err = pcnt_unit_add_watch_point(out->unit, -config->limit);
+        }
+    } else if (err == ESP_OK) {
+        err = pin_hal_pcnt_add_channel(out, 0, config->pin, GPIO_NUM_NC,
+            config->count_rise ? PCNT_CHANNEL_EDGE_ACTION_INCREASE : PCNT_CHANNEL_EDGE_ACTION_HOLD,
+            config->count_fall ? PCNT_CHANNEL_EDGE_ACTION_INCREASE : PCNT_CHANNEL_EDGE_ACTION_HOLD);
+    }
+    if (err == ESP_OK) {
+        err = pcnt_unit_add_watch_point(out->unit, config->limit);
+    }
+    if (err == ESP_OK) {
+        err = pcnt_unit_register_event_callbacks(out->unit, &cbs, arg);
+    }
+    if (err == ESP_OK) {
+        err = pcnt_unit_enable(out->unit);
+    }
+    if (err == ESP_OK) {
+        err = pcnt_unit_clear_count(out->unit);
+    }
+    if (err == ESP_OK) {
+        err = pcnt_unit_start(out->unit);
+    }
+    if (err != ESP_OK) {
+        (void)pin_hal_pcnt_delete(out);
+    }
+    return err;
+}
+
+// Current count, in (-limit, limit).
+FORCE_INLINE_ATTR esp_err_t pin_hal_pcnt_get(pin_hal_pcnt_t *pcnt, int *count) {
+    return pcnt_unit_get_count(pcnt->unit, count);
+}
+
+// Start the capture timer of an MCPWM group on its default (APB) clock.
+static inline esp_err_t pin_hal_cap_timer_create(int group, pin_hal_cap_timer_t *out,
+                                                 uint32_t *resolution_hz) {
+    const mcpwm_capture_timer_config_t config = {
+        .group_id = group,
+        .clk_src = MCPWM_CAPTURE_CLK_SRC_DEFAULT,
+    };
+    *out = NULL;
+    esp_err_t err = mcpwm_new_capture_timer(&config, out);
+    if (err == ESP_OK) {
+        err = mcpwm_capture_timer_enable(*out);
+    }
+    if (err == ESP_OK) {
+        err = mcpwm_capture_timer_start(*out);
+    }
+    if (err == ESP_OK) {
+        err = mcpwm_capture_timer_get_resolution(*out, resolution_hz);
+    }
+    if (err != ESP_OK && *out) {
+        (void)mcpwm_capture_timer_disable(*out);
+        (void)mcpwm_del_capture_timer(*out);
+        *out = NULL;
+    }
+    return err;
+}
+
+// Capture both edges of pin, unscaled; the channel sets up the pin's input and pull-up.
+static inline esp_err_t pin_hal_cap_channel_create(pin_hal_cap_timer_t timer, gpio_num_t pin,
+                                                   bool pull_up, pin_hal_cap_cb_t on_capture,
+                                                   void *arg, pin_hal_cap_channel_t *out) {
+    mcpwm_capture_channel_config_t config = {
+        .gpio_num = pin,
+        .prescale = 1,
+    };
+    config.flags.pos_edge = true;
+    config.flags.neg_edge = true;
+    config.flags.pull_up = pull_up;
+    const mcpwm_capture_event_callbacks_t cbs = { .on_cap = on_capture };
+
+    *out = NULL;
+    esp_err_t err = mcpwm_new_capture_channel(timer, &config, out);
+    if (err == ESP_OK) {
+        err = mcpwm_capture_channel_register_event_callbacks(*out, &cbs, arg);
+    }
+    if (err == ESP_OK) {
+        err = mcpwm_capture_channel_enable(*out);
+    }
+    if (err != ESP_OK && *out) {
+        (void)mcpwm_del_capture_channel(*out);
+        *out = NULL;
+    }
+    return err;
+}
+
+static inline esp_err_t pin_hal_cap_channel_delete(pin_hal_cap_channel_t chan) {
+    (void)mcpwm_capture_channel_disable(chan);
+    return mcpwm_del_capture_channel(chan);
+}
+
+// The channel taps pin through the GPIO matrix; its input setup (pull-up) stays.
+static inline esp_err_t pin_hal_rmt_rx_create(const pin_hal_rmt_rx_config_t *config,
+                                              pin_hal_rmt_rx_cb_t on_done, void *arg,
+                                              pin_hal_rmt_rx_t *out) {
+    rmt_rx_channel_config_t chan_config = {
+        .gpio_num = config->pin,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = config->resolution_hz,
+        .mem_block_symbols = config->mem_symbols,
+    };
+    chan_config.flags.with_dma = config->dma;
+    const rmt_rx_event_callbacks_t cbs = { .on_recv_done = on_done };
+
+    *out = NULL;
+    esp_err_t err = rmt_new_rx_channel(&chan_config, out);
+    if (err == ESP_OK) {
+        err = rmt_rx_register_event_callbacks(*out, &cbs, arg);
+    }
+    if (err == ESP_OK) {
+        err = rmt_enable(*out);
+    }
+    if (err != ESP_OK && *out) {
+        (void)rmt_del_channel(*out);
+        *out = NULL;
+    }
+    return err;
+}
+
+// Arm one reception; callable from the done callback to re-arm at once.
+FORCE_INLINE_ATTR esp_err_t pin_hal_rmt_rx_receive(pin_hal_rmt_rx_t chan, pin_hal_rmt_symbol_t *buf,
+                                                   size_t symbols, uint32_t min_ns,
+                                                   uint32_t max_ns) {
+    rmt_receive_config_t config = {
+        .signal_range_min_ns = min_ns,
+        .signal_range_max_ns = max_ns,
+    };
+    return rmt_receive(chan, buf, symbols * sizeof(*buf), &config);
+}
+
+static inline esp_err_t pin_hal_rmt_rx_delete(pin_hal_rmt_rx_t chan) {
+    (void)rmt_disable(chan);
+    return rmt_del_channel(chan);
+}
+
+#else // CONFIG_IDF_TARGET_LINUX: simulated backend, see pin_sim.h
+
+#define PIN_HAL_INTR_LEVEL1 0
+#define PIN_HAL_INTR_LEVEL2 0
+#define PIN_HAL_INTR_LEVEL3 0
+#define PIN_HAL_INTR_IRAM   0
+
+#define PIN_HAL_PCNT_UNITS  4
+#define PIN_HAL_CAP_GROUPS   2
+#define PIN_HAL_CAP_CHANNELS 3
+#define PIN_HAL_CAP_EDGE_POS 0
+#define PIN_HAL_CAP_EDGE_NEG 1
+#define PIN_HAL_RMT_RX_CHANNELS  4
+#define PIN_HAL_RMT_MEM_SYMBOLS  48
+#define PIN_HAL_PAR_MAX_PINS     16
+#define PIN_HAL_PAR_MAX_BUFFER   4092
+#define PIN_HAL_PAR_MIN_HZ       625000
+#define PIN_HAL_PAR_MAX_HZ       20000000
+
+typedef struct pin_hal_sim_timer *pin_hal_timer_t;
+typedef void *pin_hal_intr_handle_t;
+
+// Mirrors the PCNT driver's watch point callback.
+typedef struct pin_hal_sim_pcnt *pin_hal_pcnt_unit_t;
+typedef struct {
+    int watch_point_value;
+} pin_hal_pcnt_event_t;
+typedef bool (*pin_hal_pcnt_cb_t)(pin_hal_pcnt_unit_t unit, const pin_hal_pcnt_event_t *edata,
+                                  void *user_ctx);
+
+typedef struct {
+    pin_hal_pcnt_unit_t unit;
+} pin_hal_pcnt_t;
+
+// Mirrors the MCPWM driver's capture callback.
+typedef struct pin_hal_sim_cap_timer   *pin_hal_cap_timer_t;
+typedef struct pin_hal_sim_cap_channel *pin_hal_cap_channel_t;
+typedef struct {
+    uint32_t cap_value;
+    int      cap_edge;
+} pin_hal_cap_event_t;
+typedef bool (*pin_hal_cap_cb_t)(pin_hal_cap_channel_t chan, const pin_hal_cap_event_t *edata,
+                                 void *user_ctx);
+
+// Mirrors the RMT driver's symbol and receive-done callback.
+typedef struct pin_hal_sim_rmt_rx *pin_hal_rmt_rx_t;
+typedef union {
+    struct {
+        uint16_t duration0 : 15;
+        uint16_t level0 : 1;
+        uint16_t duration1 : 15;
+        uint16_t level1 : 1;
+    };
+    uint32_t val;
+} pin_hal_rmt_symbol_t;
+typedef struct {
+    pin_hal_rmt_symbol_t *received_symbols;
+    size_t                num_symbols;
+} pin_hal_rmt_rx_event_t;
+typedef bool (*pin_hal_rmt_rx_cb_t)(pin_hal_rmt_rx_t chan, const pin_hal_rmt_rx_event_t *edata,
+                                    void *user_ctx);
+
+int64_t   pin_hal_time_us(void);
+uint64_t  pin_hal_read_levels(void);
+uint64_t  pin_hal_take_intr_status(void);
+esp_err_t pin_hal_intr_enable(gpio_num_t pin);
+esp_err_t pin_hal_intr_disable(gpio_num_t pin);
+esp_err_t pin_hal_config_input(gpio_num_t pin, bool pull_up, gpio_int_type_t intr_type);
+esp_err_t pin_hal_config_inputs(uint64_t mask, uint64_t pull_up_mask);
+esp_err_t pin_hal_set_pull_up(gpio_num_t pin, bool pull_up);
+esp_err_t pin_hal_set_intr_type(gpio_num_t pin, gpio_int_type_t intr_type);
+esp_err_t pin_hal_isr_service_install(int intr_flags);
+esp_err_t pin_hal_isr_handler_add(gpio_num_t pin, pin_hal_isr_t isr, void *arg);
+esp_err_t pin_hal_isr_handler_remove(gpio_num_t pin);
+esp_err_t pin_hal_isr_register(pin_hal_isr_t isr, void *arg, int intr_flags,
+                               pin_hal_intr_handle_t *handle);
+esp_err_t pin_hal_run_on_core(int core, void (*fn)(void *), void *arg);
+esp_err_t pin_hal_timer_create(pin_hal_timer_cb_t cb, void *arg, const char *name,
+                               bool isr_dispatch, pin_hal_timer_t *out);
+esp_err_t pin_hal_timer_start_periodic(pin_hal_timer_t timer, uint64_t period_us);
+esp_err_t pin_hal_timer_start_once(pin_hal_timer_t timer, uint64_t timeout_us);
+esp_err_t pin_hal_timer_stop(pin_hal_timer_t timer);
+esp_err_t pin_hal_timer_delete(pin_hal_timer_t timer);
+void      pin_hal_timer_isr_yield(void);
+esp_err_t pin_hal_drive_enable(gpio_num_t pin, int level);
+esp_err_t pin_hal_drive_disable(gpio_num_t pin);
+void      pin_hal_drive(gpio_num_t pin, int level);
+esp_err_t pin_hal_pcnt_create(const pin_hal_pcnt_config_t *config, pin_hal_pcnt_cb_t on_limit,
+                              void *arg, pin_hal_pcnt_t *out);
+esp_err_t pin_hal_pcnt_delete(pin_hal_pcnt_t *pcnt);
+esp_err_t pin_hal_pcnt_get(pin_hal_pcnt_t *pcnt, int *count);
+esp_err_t pin_hal_cap_timer_create(int group, pin_hal_cap_timer_t *out, uint32_t *resolution_hz);
+esp_err_t pin_hal_cap_channel_create(pin_hal_cap_timer_t timer, gpio_num_t pin, bool pull_up,
+                                     pin_hal_cap_cb_t on_capture, void *arg,
+                                     pin_hal_cap_channel_t *out);
+esp_err_t pin_hal_cap_channel_delete(pin_hal_cap_channel_t chan);
+esp_err_t pin_hal_rmt_rx_create(const pin_hal_rmt_rx_config_t *config, pin_hal_rmt_rx_cb_t on_done,
+                                void *arg, pin_hal_rmt_rx_t *out);
+esp_err_t pin_hal_rmt_rx_receive(pin_hal_rmt_rx_t chan, pin_hal_rmt_symbol_t *buf, size_t symbols,
+                                 uint32_t min_ns, uint32_t max_ns);
+esp_err_t pin_hal_rmt_rx_delete(pin_hal_rmt_rx_t chan);
+
+#endif
+
+// Parallel sampler, on both backends. sample_hz receives the actual rate.
+// Starting begins a new run at the start of the first buffer; stop and delete
+// must not be called from the done callback.
+esp_err_t pin_hal_par_create(const pin_hal_par_config_t *config, pin_hal_par_cb_t on_done,
+                             void *arg, pin_hal_par_t *out, uint32_t *sample_hz);
+esp_err_t pin_hal_par_start(pin_hal_par_t par);
+esp_err_t pin_hal_par_stop(pin_hal_par_t par);
+esp_err_t pin_hal_par_delete(pin_hal_par_t par);
+
+// Low-power monitor, on both backends. Starting it while it already runs from
+// before a deep sleep keeps its levels and queue and only updates the wake
+// conditions; resumed tells which happened. A different pin_mask restarts it.
+// The wake cause is a PIN_HAL_LP_WAKE_* mask, 0 after a cold boot or reset.
+// Peeking returns the oldest queued events and the events lost since the last
+// consume; consuming n of them (and acknowledging the lost count) frees them.
+// Sleeping enters deep sleep, also waking after timeout_us unless 0, and does
+// not return on hardware; in the simulator it runs the virtual clock until the
+// CPU would have woken, keeping the other timers running.
+bool      pin_hal_lp_pin_valid(gpio_num_t pin);
+esp_err_t pin_hal_lp_start(const pin_hal_lp_config_t *config, bool *resumed);
+uint32_t  pin_hal_lp_wake_cause(void);
+size_t    pin_hal_lp_peek(pin_hal_lp_event_t *out, size_t max, uint32_t *lost);
+void      pin_hal_lp_consume(size_t n);
+esp_err_t pin_hal_lp_sleep(uint64_t timeout_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,182 @@
+#pragma once
+
+/**
+ * Low-power monitor shared between the main CPU and the ULP coprocessor.
+ *
+ * The ULP program (ulp/lp_monitor.c) runs every poll period, also while the
+ * main CPU is in deep sleep, and calls pin_hal_lp_poll() with the levels of
+ * the RTC GPIOs and the RTC slow clock. The block below sits in RTC slow
+ * memory, so it and the queued events survive deep sleep. Every field has a
+ * single writer: the main CPU sets the configuration and moves tail, mark and
+ * wake_ack; the ULP owns the rest. The simulator runs the same poll on its
+ * virtual clock.
+ *
+ * This header is also compiled by the ULP toolchain: fixed-width types and
+ * inline code only, and no compound assignments to the volatile block, which
+ * C++20 deprecates.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIN_HAL_LP_MAX_GPIO    22    // RTC GPIOs; on the ESP32-S3 RTC GPIO n is GPIO n
+#define PIN_HAL_LP_EVENTS      256   // Power of two
+#define PIN_HAL_LP_MIN_POLL_US 1000  // The ULP program must be done well within a period
+#define PIN_HAL_LP_MAGIC       0x504c4d31u
+
+// Why the ULP woke the main CPU (wake_bits); PIN_HAL_LP_WAKE_TIMER comes from
+// the sleep timer instead.
+#define PIN_HAL_LP_WAKE_WATERMARK 0x1u  // watermark new events queued
+#define PIN_HAL_LP_WAKE_PRIORITY  0x2u  // A priority pin changed
+#define PIN_HAL_LP_WAKE_LATENCY   0x4u  // The oldest new event is latency_ticks old
+#define PIN_HAL_LP_WAKE_TIMER     0x8u
+
+// One debounced change. The time is the RTC slow clock at the first poll that
+// saw the new level.
+typedef struct {
+    uint32_t ticks;     // Bits 0..31
+    uint16_t ticks_hi;  // Bits 32..47
+    uint8_t  pin;
+    uint8_t  level;
+} pin_hal_lp_record_t;
+
+typedef struct {
+    uint32_t            magic;
+    // Main CPU
+    uint32_t            pin_mask;        // Bit n = GPIO n
+    uint32_t            priority_mask;
+    uint32_t            watermark;
+    uint64_t            latency_ticks;   // 0 = no latency wake
+    uint8_t             stable_polls[PIN_HAL_LP_MAX_GPIO];
+    uint32_t            tail;            // Next event the CPU consumes
+    uint32_t            mark;            // Events before it were seen by the CPU and no
+                                         // longer count toward a wake
+    uint32_t            wake_ack;
+    uint32_t            lost_ack;        // lost as last reported
+    // ULP
+    uint32_t            seeded;          // levels holds the pins
+    uint32_t            levels;          // Debounced
+    uint8_t             count[PIN_HAL_LP_MAX_GPIO];
+    uint64_t            since[PIN_HAL_LP_MAX_GPIO];
+    uint32_t            head;            // Free-running, like tail and mark
+    uint32_t            priority_head;   // head after the last priority event
+    uint32_t            lost;            // Events dropped on a full queue
+    uint32_t            wake_req;        // Ahead of wake_ack while a wake is outstanding
+    uint32_t            wake_bits;       // Reason for the latest request
+    pin_hal_lp_record_t events[PIN_HAL_LP_EVENTS];
+} pin_hal_lp_shared_t;
+
+static inline uint64_t pin_hal_lp_record_ticks(const volatile pin_hal_lp_record_t *r) {
+    return (uint64_t)r->ticks_hi << 32 | r->ticks;
+}
+
+// ULP: queue a change, or count it as lost on a full queue.
+static inline void pin_hal_lp_push(volatile pin_hal_lp_shared_t *lp, uint32_t pin,
+                                   uint32_t level, uint64_t ticks) {
+    uint32_t head = lp->head;
+    if (head - lp->tail >= PIN_HAL_LP_EVENTS) {
+        lp->lost = lp->lost + 1;
+        return;
+    }
+    volatile pin_hal_lp_record_t *r = &lp->events[head % PIN_HAL_LP_EVENTS];
+    r->ticks = (uint32_t)ticks;
+    r->ticks_hi = (uint16_t)(ticks >> 32);
+    r->pin = (uint8_t)pin;
+    r->level = (uint8_t)level;
+    if (lp->priority_mask & (1u << pin)) {
+        lp->priority_head = head + 1;
+    }
+    lp->head = head + 1;
+}
+
+// ULP: the wake reasons that hold now, counting only events past mark.
+static inline uint32_t pin_hal_lp_wake_reasons(const volatile pin_hal_lp_shared_t *lp,
+                                               uint64_t now) {
+    uint32_t head = lp->head;
+    uint32_t mark = lp->mark;
+    uint32_t bits = 0;
+    if (head == mark) {
+        return 0;
+    }
+    if (head - mark >= lp->watermark) {
+        bits |= PIN_HAL_LP_WAKE_WATERMARK;
+    }
+    if ((int32_t)(lp->priority_head - mark) > 0) {
+        bits |= PIN_HAL_LP_WAKE_PRIORITY;
+    }
+    if (lp->latency_ticks &&
+        now - pin_hal_lp_record_ticks(&lp->events[mark % PIN_HAL_LP_EVENTS]) >= lp->latency_ticks) {
+        bits |= PIN_HAL_LP_WAKE_LATENCY;
+    }
+    return bits;
+}
+
+/**
+ * ULP: one poll. A pin takes a new level once it has read it on stable_polls
+ * polls in a row. Returns true when the main CPU should be woken; a request
+ * stays outstanding, and no other is made, until the CPU acknowledges it.
+ */
+static inline bool pin_hal_lp_poll(volatile pin_hal_lp_shared_t *lp, uint32_t inputs,
+                                   uint64_t now) {
+    uint32_t mask = lp->pin_mask;
+    if (!lp->seeded) {
+        lp->levels = inputs & mask;
+        lp->seeded = 1;
+        return false;
+    }
+    uint32_t diff = (inputs ^ lp->levels) & mask;
+    for (uint32_t pin = 0; pin < PIN_HAL_LP_MAX_GPIO; pin++) {
+        uint32_t bit = 1u << pin;
+        if (!(mask & bit)) {
+            continue;
+        }
+        if (!(diff & bit)) {
+            lp->count[pin] = 0;
+            continue;
+        }
+        if (lp->count[pin] == 0) {
+            lp->since[pin] = now;
+        }
+        lp->count[pin] = lp->count[pin] + 1;
+        if (lp->count[pin] < lp->stable_polls[pin]) {
+            continue;
+        }
+        lp->count[pin] = 0;
+        lp->levels = lp->levels ^ bit;
+        pin_hal_lp_push(lp, pin, (inputs & bit) != 0, lp->since[pin]);
+    }
+
+    if (lp->wake_req != lp->wake_ack) {
+        return false;
+    }
+    uint32_t bits = pin_hal_lp_wake_reasons(lp, now);
+    if (!bits) {
+        return false;
+    }
+    lp->wake_bits = bits;
+    lp->wake_req = lp->wake_req + 1;
+    return true;
+}
+
+// Main CPU: the events before seen have been handed out and no longer count
+// toward a wake.
+static inline void pin_hal_lp_seen(volatile pin_hal_lp_shared_t *lp, uint32_t seen) {
+    if ((int32_t)(seen - lp->mark) > 0) {
+        lp->mark = seen;
+    }
+}
+
+// Main CPU: free the n oldest events.
+static inline void pin_hal_lp_free(volatile pin_hal_lp_shared_t *lp, uint32_t n) {
+    uint32_t queued = lp->head - lp->tail;
+    lp->tail = lp->tail + (n < queued ? n : queued);
+    pin_hal_lp_seen(lp, lp->tail);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+/**
+ * Waveform injector for the simulated pin_hal backend (linux target only).
+ *
+ * Time is virtual and only moves inside pin_sim_run_until(): scheduled pin
+ * transitions and periodic timers fire in timestamp order, each callback runs
+ * to completion on the calling task, and GPIO "interrupts" are delivered
+ * synchronously when an enabled pin changes. With a fixed seed every run is
+ * bit-for-bit repeatable, independent of host load.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "pin_hal_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Shape of one scripted transition.
+typedef struct {
+    uint16_t bounces;    ///< Glitch pairs before the level settles (0 = clean edge)
+    uint32_t bounce_us;  ///< Span after the first edge over which the glitches fall
+    uint32_t jitter_us;  ///< Random +/- offset applied to the start of the transition
+} pin_sim_bounce_t;
+
+/// @brief Reseed the jitter/bounce generator (default seed is 1).
+void    pin_sim_seed(uint32_t seed);
+
+/// @brief Current virtual time in microseconds (same clock as pin_hal_time_us()).
+int64_t pin_sim_now(void);
+
+/// @brief Schedule a raw level change at an absolute time (clamped to now).
+/// @return The time it was scheduled at, or -1 if the edge queue is full.
+int64_t pin_sim_schedule(gpio_num_t pin, int64_t at_us, int level);
+
+/**
+ * @brief Schedule a transition to level starting around at_us, with optional
+ *        bounce and jitter. The glitches land at random points in
+ *        (first edge, first edge + bounce_us] and the last edge is level.
+ * @return Time of the settling (last) edge, or -1 if the edge queue is full.
+ */
+int64_t pin_sim_transition(gpio_num_t pin, int64_t at_us, int level, const pin_sim_bounce_t *shape);
+
+/**
+ * @brief Schedule a burst of edges toggling every half_period_us from
+ *        start_us, each edge offset by up to +/- jitter_us.
+ * @return Time of the last edge, or -1 if the edge queue is full.
+ */
+int64_t pin_sim_burst(gpio_num_t pin, int64_t start_us, uint32_t half_period_us,
+                      uint32_t edges, uint32_t jitter_us);
+
+/// @brief Level the pin will have once everything scheduled for it has fired.
+int     pin_sim_final_level(gpio_num_t pin);
+
+/// @brief Advance virtual time to t_us, firing every edge and timer due up to it.
+void    pin_sim_run_until(int64_t t_us);
+
+/// @brief Scheduled edges not yet fired.
+size_t  pin_sim_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,229 @@
+/**
+ * Low-power monitor on the ESP32-S3 ULP-RISC-V coprocessor. The program
+ * (ulp/lp_monitor.c) and the block it shares with the main CPU live in RTC
+ * slow memory, which keeps power in deep sleep, so the ULP carries on polling
+ * while the CPU sleeps and across its wake-ups. Only a cold boot or a changed
+ * pin set loads the program afresh.
+ */
+
+#include "sdkconfig.h"
+#include "pin_hal.h"
+
+#if CONFIG_ULP_COPROC_TYPE_RISCV
+
+#include "driver/rtc_io.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_private/esp_clk.h"
+#include "soc/rtc.h"
+#include "ulp_riscv.h"
+#include "ulp_pin_lp.h"
+
+static const char *TAG = "PinHalLp";
+
+extern const uint8_t ulp_pin_lp_bin_start[] asm("_binary_ulp_pin_lp_bin_start");
+extern const uint8_t ulp_pin_lp_bin_end[] asm("_binary_ulp_pin_lp_bin_end");
+
+#define LP ((volatile pin_hal_lp_shared_t *)&ulp_lp_shared)
+
+static uint32_t s_lost;  // lost at the last peek; consuming acknowledges it
+
+bool pin_hal_lp_pin_valid(gpio_num_t pin) {
+    return pin >= 0 && pin < PIN_HAL_LP_MAX_GPIO && rtc_gpio_is_valid_gpio(pin);
+}
+
+static esp_err_t lp_check(const pin_hal_lp_config_t *config) {
+    if (!config || !config->pin_mask || config->poll_us < PIN_HAL_LP_MIN_POLL_US ||
+        config->watermark == 0 || config->watermark > PIN_HAL_LP_EVENTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint32_t pins = config->pin_mask; pins; pins &= pins - 1) {
+        if (!pin_hal_lp_pin_valid((gpio_num_t)__builtin_ctz(pins))) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    return ESP_OK;
+}
+
+static void lp_set_wake(volatile pin_hal_lp_shared_t *lp, const pin_hal_lp_config_t *config) {
+    uint64_t us = (uint64_t)config->max_latency_ms * 1000;
+    lp->priority_mask = config->priority_mask & config->pin_mask;
+    lp->watermark = config->watermark;
+    lp->latency_ticks = us ? rtc_time_us_to_slowclk(us, esp_clk_slowclk_cal_get()) : 0;
+}
+
+static esp_err_t lp_pins_init(const pin_hal_lp_config_t *config) {
+    for (uint32_t pins = config->pin_mask; pins; pins &= pins - 1) {
+        gpio_num_t pin = (gpio_num_t)__builtin_ctz(pins);
+        esp_err_t err = rtc_gpio_init(pin);
+        if (err == ESP_OK) {
+            err = rtc_gpio_set_direction(pin, RTC_GPIO_MODE_INPUT_ONLY);
+        }
+        if (err == ESP_OK) {
+            err = (config->pull_up_mask & (1u << pin)) ? rtc_gpio_pullup_en(pin)
+                                                        : rtc_gpio_pullup_dis(pin);
+        }
+        if (err == ESP_OK) {
+            err = rtc_gpio_pulldown_dis(pin);
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_lp_start(const pin_hal_lp_config_t *config, bool *resumed) {
+    esp_err_t err = lp_check(config);
+    if (err != ESP_OK) {
+        return err;
+    }
+    volatile pin_hal_lp_shared_t *lp = LP;
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    bool running = (cause == ESP_SLEEP_WAKEUP_ULP || cause == ESP_SLEEP_WAKEUP_TIMER) &&
+                   lp->magic == PIN_HAL_LP_MAGIC && lp->pin_mask == config->pin_mask;
+    if (resumed) {
+        *resumed = running;
+    }
+    if (running) {
+        lp_set_wake(lp, config);
+        s_lost = lp->lost_ack;
+        return ESP_OK;
+    }
+
+    // Loading clears the reserved RTC memory, and with it the shared block.
+    ulp_riscv_timer_stop();
+    ulp_riscv_halt();
+    err = ulp_riscv_load_binary(ulp_pin_lp_bin_start, ulp_pin_lp_bin_end - ulp_pin_lp_bin_start);
+    if (err == ESP_OK) {
+        err = lp_pins_init(config);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ULP setup failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    lp->pin_mask = config->pin_mask;
+    for (int i = 0; i < PIN_HAL_LP_MAX_GPIO; i++) {
+        lp->stable_polls[i] = config->stable_polls[i];
+    }
+    lp_set_wake(lp, config);
+    lp->magic = PIN_HAL_LP_MAGIC;
+    s_lost = 0;  // lost_ack was cleared with the rest
+
+    err = ulp_set_wakeup_period(0, config->poll_us);
+    if (err == ESP_OK) {
+        err = ulp_riscv_run();
+    }
+    return err;
+}
+
+uint32_t pin_hal_lp_wake_cause(void) {
+    switch (esp_sleep_get_wakeup_cause()) {
+    case ESP_SLEEP_WAKEUP_ULP:
+        return LP->magic == PIN_HAL_LP_MAGIC ? LP->wake_bits : 0;
+    case ESP_SLEEP_WAKEUP_TIMER:
+        return PIN_HAL_LP_WAKE_TIMER;
+    default:
+        return 0;
+    }
+}
+
+size_t pin_hal_lp_peek(pin_hal_lp_event_t *out, size_t max, uint32_t *lost) {
+    volatile pin_hal_lp_shared_t *lp = LP;
+    if (lost) {
+        *lost = 0;
+    }
+    if (lp->magic != PIN_HAL_LP_MAGIC) {
+        return 0;
+    }
+    uint32_t tail = lp->tail;
+    uint32_t head = lp->head;
+    uint64_t now = rtc_time_get();
+    uint32_t cal = esp_clk_slowclk_cal_get();
+    size_t n = 0;
+    for (; n < max && tail + n != head; n++) {
+        const volatile pin_hal_lp_record_t *r = &lp->events[(tail + n) % PIN_HAL_LP_EVENTS];
+        out[n] = (pin_hal_lp_event_t){
+            .pin = (gpio_num_t)r->pin,
+            .level = r->level,
+            .age_us = (int64_t)rtc_time_slowclk_to_us(now - pin_hal_lp_record_ticks(r), cal),
+        };
+    }
+    pin_hal_lp_seen(lp, tail + n);
+    s_lost = lp->lost;
+    if (lost) {
+        *lost = s_lost - lp->lost_ack;
+    }
+    return n;
+}
+
+void pin_hal_lp_consume(size_t n) {
+    volatile pin_hal_lp_shared_t *lp = LP;
+    if (lp->magic != PIN_HAL_LP_MAGIC) {
+        return;
+    }
+    pin_hal_lp_free(lp, (uint32_t)n);
+    lp->lost_ack = s_lost;
+}
+
+esp_err_t pin_hal_lp_sleep(uint64_t timeout_us) {
+    volatile pin_hal_lp_shared_t *lp = LP;
+    if (lp->magic != PIN_HAL_LP_MAGIC) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = esp_sleep_enable_ulp_wakeup();
+    if (err == ESP_OK && timeout_us) {
+        err = esp_sleep_enable_timer_wakeup(timeout_us);
+    }
+    if (err == ESP_OK) {
+        // Keeps the RTC GPIO pull-ups powered.
+        err = esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    // From here the ULP may ask for the next wake-up; if it already would, the
+    // CPU wakes again at once.
+    lp->wake_ack = lp->wake_req;
+    esp_deep_sleep_start();
+    return ESP_OK;
+}
+
+#else // !CONFIG_ULP_COPROC_TYPE_RISCV
+
+bool pin_hal_lp_pin_valid(gpio_num_t pin) {
+    (void)pin;
+    return false;
+}
+
+esp_err_t pin_hal_lp_start(const pin_hal_lp_config_t *config, bool *resumed) {
+    (void)config;
+    if (resumed) {
+        *resumed = false;
+    }
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+uint32_t pin_hal_lp_wake_cause(void) {
+    return 0;
+}
+
+size_t pin_hal_lp_peek(pin_hal_lp_event_t *out, size_t max, uint32_t *lost) {
+    (void)out;
+    (void)max;
+    if (lost) {
+        *lost = 0;
+    }
+    return 0;
+}
+
+void pin_hal_lp_consume(size_t n) {
+    (void)n;
+}
+
+esp_err_t pin_hal_lp_sleep(uint64_t timeout_us) {
+    (void)timeout_us;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_ULP_COPROC_TYPE_RISCV
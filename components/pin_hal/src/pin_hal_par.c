@@ -0,0 +1,259 @@
+/**
+ * Parallel sampler on the ESP32-S3 camera interface (LCD_CAM). The camera
+ * clock is routed out on clock_pin and straight back in as the pixel clock,
+ * with VSYNC, HSYNC and DE tied high, so the interface latches its data inputs
+ * on every clock and GDMA streams them into a circular list of descriptors.
+ * The camera raises a successful EOF every buffer_bytes, which moves GDMA to
+ * the next descriptor and calls the done callback.
+ *
+ * There is a single camera interface, so there is a single sampler.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_rom_gpio.h"
+#include "esp_private/gdma.h"
+#include "esp_private/periph_ctrl.h"
+#include "hal/dma_types.h"
+#include "soc/gpio_sig_map.h"
+#include "soc/gpio_pins.h"
+#include "soc/lcd_cam_struct.h"
+#include "pin_hal.h"
+
+#if SOC_LCDCAM_SUPPORTED
+
+static const char *TAG = "PinHalPar";
+
+#define PAR_SOURCE_HZ 160000000  // PLL_F160M
+#define PAR_CLK_SEL   3
+
+struct pin_hal_par {
+    pin_hal_par_config_t   config;
+    gpio_num_t             pins[PIN_HAL_PAR_MAX_PINS];
+    pin_hal_par_cb_t       on_done;
+    void                  *arg;
+    gdma_channel_handle_t  dma;
+    dma_descriptor_t      *desc;
+    uint8_t               *ring;
+    uint32_t               div;
+    size_t                 next;     // Buffer the next EOF completes
+    bool                   in_use;
+    bool                   running;
+};
+
+static struct pin_hal_par s_par;
+
+static IRAM_ATTR bool on_eof(gdma_channel_handle_t chan, gdma_event_data_t *event, void *arg) {
+    (void)chan;
+    (void)event;
+    struct pin_hal_par *par = (struct pin_hal_par *)arg;
+    size_t index = par->next;
+    par->next = (index + 1 == par->config.buffers) ? 0 : index + 1;
+    return par->on_done(par, par->ring + index * par->config.buffer_bytes,
+                        par->config.buffer_bytes, par->arg);
+}
+
+static void cam_setup(const struct pin_hal_par *par) {
+    LCD_CAM.cam_ctrl.val = 0;
+    LCD_CAM.cam_ctrl.cam_clk_sel = PAR_CLK_SEL;
+    LCD_CAM.cam_ctrl.cam_clkm_div_num = par->div;
+    LCD_CAM.cam_ctrl.cam_clkm_div_a = 0;
+    LCD_CAM.cam_ctrl.cam_clkm_div_b = 0;
+    LCD_CAM.cam_ctrl.cam_vs_eof_en = 0;  // EOF every cam_rec_data_bytelen + 1 bytes
+    LCD_CAM.cam_ctrl1.val = 0;
+    LCD_CAM.cam_ctrl1.cam_rec_data_bytelen = par->config.buffer_bytes - 1;
+    LCD_CAM.cam_ctrl1.cam_2byte_en = par->config.pin_count > 8;
+    LCD_CAM.cam_rgb_yuv.val = 0;
+    LCD_CAM.cam_ctrl.cam_update = 1;
+}
+
+static size_t sample_bits(const struct pin_hal_par *par) {
+    return par->config.pin_count > 8 ? 16 : 8;
+}
+
+static void pins_route(const struct pin_hal_par *par) {
+    for (size_t i = 0; i < sample_bits(par); i++) {
+        if (i < par->config.pin_count) {
+            gpio_input_enable(par->pins[i]);
+            esp_rom_gpio_connect_in_signal(par->pins[i], CAM_DATA_IN0_IDX + i, false);
+        } else {
+            esp_rom_gpio_connect_in_signal(GPIO_MATRIX_CONST_ZERO_INPUT, CAM_DATA_IN0_IDX + i,
+                                           false);
+        }
+    }
+    gpio_num_t clk = par->config.clock_pin;
+    gpio_reset_pin(clk);
+    gpio_set_direction(clk, GPIO_MODE_INPUT_OUTPUT);
+    esp_rom_gpio_connect_out_signal(clk, CAM_CLK_IDX, false, false);
+    esp_rom_gpio_connect_in_signal(clk, CAM_PCLK_IDX, false);
+    esp_rom_gpio_connect_in_signal(GPIO_MATRIX_CONST_ONE_INPUT, CAM_V_SYNC_IDX, false);
+    esp_rom_gpio_connect_in_signal(GPIO_MATRIX_CONST_ONE_INPUT, CAM_H_SYNC_IDX, false);
+    esp_rom_gpio_connect_in_signal(GPIO_MATRIX_CONST_ONE_INPUT, CAM_H_ENABLE_IDX, false);
+}
+
+static void pins_release(const struct pin_hal_par *par) {
+    for (size_t i = 0; i < sample_bits(par); i++) {
+        esp_rom_gpio_connect_in_signal(GPIO_MATRIX_CONST_ZERO_INPUT, CAM_DATA_IN0_IDX + i, false);
+    }
+    esp_rom_gpio_connect_in_signal(GPIO_MATRIX_CONST_ZERO_INPUT, CAM_PCLK_IDX, false);
+    gpio_reset_pin(par->config.clock_pin);
+}
+
+static void par_free(struct pin_hal_par *par) {
+    if (par->dma) {
+        (void)gdma_disconnect(par->dma);
+        (void)gdma_del_channel(par->dma);
+    }
+    heap_caps_free(par->desc);
+    heap_caps_free(par->ring);
+    *par = (struct pin_hal_par){ 0 };
+}
+
+esp_err_t pin_hal_par_create(const pin_hal_par_config_t *config, pin_hal_par_cb_t on_done,
+                             void *arg, pin_hal_par_t *out, uint32_t *sample_hz) {
+    if (!config || !config->pins || config->pin_count == 0 ||
+        config->pin_count > PIN_HAL_PAR_MAX_PINS || !GPIO_IS_VALID_OUTPUT_GPIO(config->clock_pin) ||
+        config->sample_hz < PIN_HAL_PAR_MIN_HZ || config->sample_hz > PIN_HAL_PAR_MAX_HZ ||
+        config->buffer_bytes == 0 || config->buffer_bytes % 4 ||
+        config->buffer_bytes > PIN_HAL_PAR_MAX_BUFFER || config->buffers < 2 || !on_done || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < config->pin_count; i++) {
+        if (!GPIO_IS_VALID_GPIO(config->pins[i]) || config->pins[i] == config->clock_pin) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (s_par.in_use) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    struct pin_hal_par *par = &s_par;
+    *par = (struct pin_hal_par){
+        .config = *config, .on_done = on_done, .arg = arg, .in_use = true,
+    };
+    memcpy(par->pins, config->pins, config->pin_count * sizeof(config->pins[0]));
+    par->config.pins = par->pins;
+    par->div = (PAR_SOURCE_HZ + config->sample_hz / 2) / config->sample_hz;
+    par->div = par->div < 2 ? 2 : (par->div > 256 ? 256 : par->div);
+
+    par->desc = heap_caps_calloc(config->buffers, sizeof(dma_descriptor_t),
+                                 MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    par->ring = heap_caps_calloc(config->buffers, config->buffer_bytes,
+                                 MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!par->desc || !par->ring) {
+        par_free(par);
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < config->buffers; i++) {
+        dma_descriptor_t *d = &par->desc[i];
+        d->dw0.size = config->buffer_bytes;
+        d->dw0.owner = DMA_DESCRIPTOR_BUFFER_OWNER_DMA;
+        d->buffer = par->ring + i * config->buffer_bytes;
+        d->next = &par->desc[(i + 1) % config->buffers];
+    }
+
+    gdma_channel_alloc_config_t alloc = { .direction = GDMA_CHANNEL_DIRECTION_RX };
+    esp_err_t err = gdma_new_ahb_channel(&alloc, &par->dma);
+    if (err == ESP_OK) {
+        err = gdma_connect(par->dma, GDMA_MAKE_TRIGGER(GDMA_TRIG_PERIPH_CAM, 0));
+    }
+    if (err == ESP_OK) {
+        // The ring is circular and never handed back to the CPU.
+        gdma_strategy_config_t strategy = { .owner_check = false, .auto_update_desc = false };
+        err = gdma_apply_strategy(par->dma, &strategy);
+    }
+    if (err == ESP_OK) {
+        gdma_rx_event_callbacks_t cbs = { .on_recv_eof = on_eof };
+        err = gdma_register_rx_event_callbacks(par->dma, &cbs, par);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GDMA setup failed: %s", esp_err_to_name(err));
+        par_free(par);
+        return err;
+    }
+
+    periph_module_enable(PERIPH_LCD_CAM_MODULE);
+    periph_module_reset(PERIPH_LCD_CAM_MODULE);
+    pins_route(par);
+    *out = par;
+    if (sample_hz) {
+        *sample_hz = PAR_SOURCE_HZ / par->div;
+    }
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_par_start(pin_hal_par_t par) {
+    if (!par || !par->in_use || par->running) {
+        return par && par->in_use ? ESP_ERR_INVALID_STATE : ESP_ERR_INVALID_ARG;
+    }
+    par->next = 0;
+    cam_setup(par);
+    LCD_CAM.cam_ctrl1.cam_reset = 1;
+    LCD_CAM.cam_ctrl1.cam_reset = 0;
+    LCD_CAM.cam_ctrl1.cam_afifo_reset = 1;
+    LCD_CAM.cam_ctrl1.cam_afifo_reset = 0;
+    (void)gdma_reset(par->dma);
+    esp_err_t err = gdma_start(par->dma, (intptr_t)&par->desc[0]);
+    if (err != ESP_OK) {
+        return err;
+    }
+    par->running = true;
+    LCD_CAM.cam_ctrl1.cam_start = 1;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_par_stop(pin_hal_par_t par) {
+    if (!par || !par->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (par->running) {
+        LCD_CAM.cam_ctrl1.cam_start = 0;
+        (void)gdma_stop(par->dma);
+        par->running = false;
+    }
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_par_delete(pin_hal_par_t par) {
+    esp_err_t err = pin_hal_par_stop(par);
+    if (err != ESP_OK) {
+        return err;
+    }
+    pins_release(par);
+    periph_module_disable(PERIPH_LCD_CAM_MODULE);
+    par_free(par);
+    return ESP_OK;
+}
+
+#else // !SOC_LCDCAM_SUPPORTED
+
+esp_err_t pin_hal_par_create(const pin_hal_par_config_t *config, pin_hal_par_cb_t on_done,
+                             void *arg, pin_hal_par_t *out, uint32_t *sample_hz) {
+    (void)config;
+    (void)on_done;
+    (void)arg;
+    (void)sample_hz;
+    if (out) {
+        *out = NULL;
+    }
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t pin_hal_par_start(pin_hal_par_t par) {
+    (void)par;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t pin_hal_par_stop(pin_hal_par_t par) {
+    (void)par;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t pin_hal_par_delete(pin_hal_par_t par) {
+    (void)par;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // SOC_LCDCAM_SUPPORTED
@@ -0,0 +1,1154 @@
+/**
+ * Simulated pin_hal backend for the linux target: a discrete-event simulator
+ * with a virtual microsecond clock, a time-ordered queue of scripted pin
+ * transitions, a small pool of periodic timers, pulse counter units, edge
+ * capture channels, RMT receive channels, a parallel sampler and the ULP
+ * low-power monitor. Interrupts, counter wraps, captures, receive-done,
+ * buffer-done, ULP polls and timer callbacks run synchronously on the task
+ * calling pin_sim_run_until(), so the debounce engine and event pipeline see
+ * exactly the same sequence on every run.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "pin_hal.h"
+#include "pin_sim.h"
+
+static const char *TAG = "PinSim";
+
+#define PIN_SIM_MAX_EDGES    (1u << 16)
+#define PIN_SIM_MAX_TIMERS   16
+#define PIN_SIM_MAX_BOUNCES  32
+#define PIN_SIM_MAX_GLITCH_NS 12787  // 1023 APB cycles, the ESP32-S3 filter limit
+#define PIN_SIM_CAP_HZ       80000000 // Capture timers run on the APB clock
+#define PIN_SIM_RMT_MAX_FILTER_NS 3187 // 255 cycles of the 80 MHz RMT clock
+#define PIN_SIM_RMT_MAX_TICKS 32767   // 15-bit symbol durations
+#define PIN_SIM_PAR_SOURCE_HZ 160000000 // Camera clock source, divided down to the sample rate
+
+typedef struct {
+    int64_t  at_us;
+    uint32_t seq;    // Scheduling order; breaks ties between equal timestamps
+    uint8_t  pin;
+    uint8_t  level;
+} sim_edge_t;
+
+typedef struct {
+    gpio_int_type_t intr_type;
+    bool            intr_enabled;
+    pin_hal_isr_t   isr;
+    void           *isr_arg;
+    int64_t         tail_us;     // Latest scheduled edge
+    uint8_t         tail_level;
+    bool            driven;      // Level set by the script, pull-up no longer applies
+} sim_pin_t;
+
+struct pin_hal_sim_timer {
+    pin_hal_timer_cb_t cb;
+    void              *arg;
+    const char        *name;
+    uint64_t           period_us;
+    int64_t            next_us;
+    bool               active;
+    bool               once;
+};
+
+// Pulse counter unit; input 0 is pin, input 1 the quadrature pin. The glitch
+// filter is evaluated lazily: a raw level that has held for glitch_ns by the
+// next edge or read becomes the filtered level and is counted then, so wraps
+// can be reported slightly late.
+struct pin_hal_sim_pcnt {
+    pin_hal_pcnt_config_t config;
+    pin_hal_pcnt_cb_t     on_limit;
+    void                 *arg;
+    bool                  in_use;
+    int                   count;
+    uint8_t               level[2];   // After the filter
+    uint8_t               raw[2];     // Latest level at the pin
+    int64_t               raw_ns[2];  // When it appeared
+};
+
+// Capture timer of a group; counts PIN_SIM_CAP_HZ from time zero, like one
+// started at boot, so captures only carry microsecond steps.
+struct pin_hal_sim_cap_timer {
+    bool in_use;
+};
+
+struct pin_hal_sim_cap_channel {
+    gpio_num_t       pin;
+    pin_hal_cap_cb_t on_capture;
+    void            *arg;
+    bool             in_use;
+};
+
+// RMT receive channel. An armed channel starts recording at the first edge
+// that passes the filter; the filter is evaluated lazily like the PCNT one: an
+// edge followed by the next one within min_ns is dropped with it, otherwise it
+// is committed as the end of the previous level. The channel finishes once the
+// pin has had no edge for max_ns (or the buffer is full).
+struct pin_hal_sim_rmt_rx {
+    pin_hal_rmt_rx_config_t config;
+    pin_hal_rmt_rx_cb_t     on_done;
+    void                   *arg;
+    bool                    in_use;
+    bool                    armed;
+    bool                    started;      // First edge committed
+    bool                    pending;      // Edge waiting for the filter
+    uint8_t                 level;        // Committed level
+    uint8_t                 pending_level;
+    int64_t                 level_ns;     // When the committed level began
+    int64_t                 pending_ns;
+    int64_t                 idle_us;      // Finish at this time, once started
+    pin_hal_rmt_symbol_t   *buf;
+    size_t                  symbols;
+    size_t                  halves;       // Symbol halves written
+    uint32_t                min_ns;
+    uint32_t                max_ns;
+};
+
+// Parallel sampler. Samples are written lazily: before a pin changes, every
+// sample taken before that microsecond is written with the levels as they
+// were, and when the last sample of a buffer is due the buffer is completed
+// and handed to the callback. Sample k is taken at start_us + k / rate,
+// rounded down to the microsecond, and sees the edges at that microsecond.
+struct pin_hal_par {
+    pin_hal_par_config_t config;
+    gpio_num_t           pins[PIN_HAL_PAR_MAX_PINS];
+    pin_hal_par_cb_t     on_done;
+    void                *arg;
+    uint8_t             *ring;
+    uint32_t             hz;
+    size_t               width;        // Bytes per sample
+    size_t               per_buffer;   // Samples per buffer
+    uint64_t             next;         // Next sample to write
+    int64_t              start_us;
+    bool                 in_use;
+    bool                 running;
+};
+
+// Low-power monitor. The ULP program's poll runs every poll_us on the virtual
+// clock, and the RTC slow clock counts microseconds. Deep sleep is a flag that
+// the poll clears when it asks for a wake-up.
+struct pin_hal_sim_lp {
+    pin_hal_lp_shared_t shared;
+    uint32_t            poll_us;
+    int64_t             next_us;
+    uint32_t            cause;     // Of the latest wake-up
+    uint32_t            lost;      // shared.lost at the last peek
+    bool                running;
+    bool                asleep;
+};
+
+static int64_t  s_now_us = 0;
+static uint64_t s_levels = 0;
+static uint64_t s_status = 0;
+static uint32_t s_rng = 1;
+static uint32_t s_seq = 0;
+
+static sim_pin_t s_pins[GPIO_NUM_MAX];
+static sim_edge_t s_edges[PIN_SIM_MAX_EDGES]; // Binary min-heap on (at_us, seq)
+static size_t s_edge_count = 0;
+static struct pin_hal_sim_timer s_timers[PIN_SIM_MAX_TIMERS];
+static size_t s_timer_count = 0;
+
+static struct pin_hal_sim_pcnt s_pcnt[PIN_HAL_PCNT_UNITS];
+static struct pin_hal_sim_cap_timer s_cap_timers[PIN_HAL_CAP_GROUPS];
+static struct pin_hal_sim_cap_channel s_cap_channels[PIN_HAL_CAP_GROUPS][PIN_HAL_CAP_CHANNELS];
+static struct pin_hal_sim_rmt_rx s_rmt_rx[PIN_HAL_RMT_RX_CHANNELS];
+static struct pin_hal_par s_par;  // A single camera interface
+static struct pin_hal_sim_lp s_lp;
+
+static bool s_isr_service = false;
+static pin_hal_isr_t s_global_isr = NULL;
+static void *s_global_isr_arg = NULL;
+
+// ---- Deterministic PRNG (xorshift32) ----
+
+static uint32_t sim_rand(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+// Uniform in [-span, +span].
+static int32_t sim_jitter(uint32_t span) {
+    return span ? (int32_t)(sim_rand() % (2 * span + 1)) - (int32_t)span : 0;
+}
+
+// ---- Edge queue ----
+
+static inline bool edge_before(const sim_edge_t *a, const sim_edge_t *b) {
+    return a->at_us < b->at_us || (a->at_us == b->at_us && (int32_t)(a->seq - b->seq) < 0);
+}
+
+static bool edge_push(const sim_edge_t *edge) {
+    if (s_edge_count == PIN_SIM_MAX_EDGES) {
+        return false;
+    }
+    size_t i = s_edge_count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!edge_before(edge, &s_edges[parent])) {
+            break;
+        }
+        s_edges[i] = s_edges[parent];
+        i = parent;
+    }
+    s_edges[i] = *edge;
+    return true;
+}
+
+static sim_edge_t edge_pop(void) {
+    sim_edge_t top = s_edges[0];
+    sim_edge_t last = s_edges[--s_edge_count];
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= s_edge_count) {
+            break;
+        }
+        if (child + 1 < s_edge_count && edge_before(&s_edges[child + 1], &s_edges[child])) {
+            child++;
+        }
+        if (!edge_before(&s_edges[child], &last)) {
+            break;
+        }
+        s_edges[i] = s_edges[child];
+        i = child;
+    }
+    s_edges[i] = last;
+    return top;
+}
+
+// ---- Pin model ----
+
+static bool intr_matches(gpio_int_type_t type, int level, bool changed) {
+    switch (type) {
+    case GPIO_INTR_POSEDGE:    return changed && level;
+    case GPIO_INTR_NEGEDGE:    return changed && !level;
+    case GPIO_INTR_ANYEDGE:    return changed;
+    case GPIO_INTR_LOW_LEVEL:  return !level;
+    case GPIO_INTR_HIGH_LEVEL: return level;
+    default:                   return false;
+    }
+}
+
+static void pcnt_count_edge(struct pin_hal_sim_pcnt *u, int input, int level) {
+    int step;
+    u->level[input] = (uint8_t)level;
+    if (u->config.quadrature_pin == GPIO_NUM_NC) {
+        step = (level ? u->config.count_rise : u->config.count_fall) ? 1 : 0;
+    } else {
+        // Same edge/level actions as pin_hal_pcnt_create() sets up on hardware.
+        bool differ = (level != u->level[!input]);
+        step = ((input == 0) == differ) ? 1 : -1;
+    }
+    if (!step) {
+        return;
+    }
+    // Like the hardware, the counter clears on reaching a limit and raises the watch event.
+    u->count += step;
+    if (u->count >= u->config.limit || u->count <= -u->config.limit) {
+        pin_hal_pcnt_event_t evt = { .watch_point_value = u->count };
+        u->count = 0;
+        if (u->on_limit) {
+            u->on_limit(u, &evt, u->arg);
+        }
+    }
+}
+
+// Let every input that has held long enough through the filter, oldest first.
+static void pcnt_settle(struct pin_hal_sim_pcnt *u, int64_t now_ns) {
+    int first = (u->raw_ns[1] < u->raw_ns[0]) ? 1 : 0;
+    for (int i = 0; i < 2; i++) {
+        int input = first ^ i;
+        if (u->raw[input] != u->level[input] &&
+            now_ns - u->raw_ns[input] >= (int64_t)u->config.glitch_ns) {
+            pcnt_count_edge(u, input, u->raw[input]);
+        }
+    }
+}
+
+static void pcnt_input(int pin, int level) {
+    int64_t now_ns = s_now_us * 1000;
+    for (size_t i = 0; i < PIN_HAL_PCNT_UNITS; i++) {
+        struct pin_hal_sim_pcnt *u = &s_pcnt[i];
+        int input = (u->config.pin == pin) ? 0 : (u->config.quadrature_pin == pin) ? 1 : -1;
+        if (!u->in_use || input < 0) {
+            continue;
+        }
+        pcnt_settle(u, now_ns);
+        u->raw[input] = (uint8_t)level;
+        u->raw_ns[input] = now_ns;
+        pcnt_settle(u, now_ns);
+    }
+}
+
+static void cap_input(int pin, int level) {
+    pin_hal_cap_event_t evt = {
+        .cap_value = (uint32_t)((uint64_t)s_now_us * (PIN_SIM_CAP_HZ / 1000000)),
+        .cap_edge = level ? PIN_HAL_CAP_EDGE_POS : PIN_HAL_CAP_EDGE_NEG,
+    };
+    for (size_t g = 0; g < PIN_HAL_CAP_GROUPS; g++) {
+        for (size_t c = 0; c < PIN_HAL_CAP_CHANNELS; c++) {
+            struct pin_hal_sim_cap_channel *ch = &s_cap_channels[g][c];
+            if (ch->in_use && ch->pin == pin && ch->on_capture) {
+                ch->on_capture(ch, &evt, ch->arg);
+            }
+        }
+    }
+}
+
+static void rmt_put(struct pin_hal_sim_rmt_rx *ch, int level, int64_t duration_ns) {
+    uint64_t ticks = (uint64_t)duration_ns * ch->config.resolution_hz / 1000000000u;
+    pin_hal_rmt_symbol_t *sym = &ch->buf[ch->halves / 2];
+    if (ticks > PIN_SIM_RMT_MAX_TICKS) {
+        ticks = PIN_SIM_RMT_MAX_TICKS;
+    }
+    if (ch->halves & 1) {
+        sym->level1 = (uint16_t)level;
+        sym->duration1 = (uint16_t)ticks;
+    } else {
+        sym->level0 = (uint16_t)level;
+        sym->duration0 = (uint16_t)ticks;
+        sym->level1 = 0;
+        sym->duration1 = 0;
+    }
+    ch->halves++;
+}
+
+// Close the reception: end marker, then the done "interrupt", which may re-arm.
+static void rmt_finish(struct pin_hal_sim_rmt_rx *ch) {
+    if (ch->halves < 2 * ch->symbols) {
+        rmt_put(ch, ch->level, 0);
+    }
+    pin_hal_rmt_rx_event_t evt = { .received_symbols = ch->buf, .num_symbols = (ch->halves + 1) / 2 };
+    ch->armed = false;
+    if (ch->on_done) {
+        ch->on_done(ch, &evt, ch->arg);
+    }
+}
+
+static void rmt_commit(struct pin_hal_sim_rmt_rx *ch) {
+    ch->pending = false;
+    if (ch->started) {
+        rmt_put(ch, ch->level, ch->pending_ns - ch->level_ns);
+    }
+    ch->started = true;
+    ch->level = ch->pending_level;
+    ch->level_ns = ch->pending_ns;
+    // Keep a half for the end marker.
+    if (ch->halves + 1 >= 2 * ch->symbols) {
+        rmt_finish(ch);
+    }
+}
+
+static void rmt_input(int pin, int level) {
+    int64_t now_ns = s_now_us * 1000;
+    for (size_t i = 0; i < PIN_HAL_RMT_RX_CHANNELS; i++) {
+        struct pin_hal_sim_rmt_rx *ch = &s_rmt_rx[i];
+        if (!ch->in_use || !ch->armed || ch->config.pin != pin) {
+            continue;
+        }
+        if (ch->pending && now_ns - ch->pending_ns < (int64_t)ch->min_ns) {
+            ch->pending = false;
+            continue;
+        }
+        if (ch->pending) {
+            rmt_commit(ch);
+            if (!ch->armed) {
+                continue;
+            }
+        }
+        ch->pending = true;
+        ch->pending_level = (uint8_t)level;
+        ch->pending_ns = now_ns;
+        ch->idle_us = s_now_us + (int64_t)(ch->max_ns / 1000);
+        if (!ch->started) {
+            // Not recording yet; the idle timeout only runs once it is.
+            ch->idle_us = s_now_us + (int64_t)((ch->min_ns + 999) / 1000);
+        }
+    }
+}
+
+static struct pin_hal_sim_rmt_rx *next_rmt_idle(void) {
+    struct pin_hal_sim_rmt_rx *best = NULL;
+    for (size_t i = 0; i < PIN_HAL_RMT_RX_CHANNELS; i++) {
+        struct pin_hal_sim_rmt_rx *ch = &s_rmt_rx[i];
+        if (ch->in_use && ch->armed && (ch->started || ch->pending) &&
+            (!best || ch->idle_us < best->idle_us)) {
+            best = ch;
+        }
+    }
+    return best;
+}
+
+// Deadline of the channel passed: settle the filter, then finish if idle.
+static void rmt_idle(struct pin_hal_sim_rmt_rx *ch) {
+    if (ch->pending) {
+        rmt_commit(ch);
+        if (!ch->armed) {
+            return;
+        }
+        ch->idle_us = ch->level_ns / 1000 + (int64_t)(ch->max_ns / 1000);
+        if (ch->idle_us > s_now_us) {
+            return;
+        }
+    }
+    rmt_finish(ch);
+}
+
+static int64_t par_sample_us(const struct pin_hal_par *p, uint64_t k) {
+    return p->start_us + (int64_t)(k * 1000000u / p->hz);
+}
+
+static uint32_t par_sample(const struct pin_hal_par *p) {
+    uint32_t v = 0;
+    for (size_t i = 0; i < p->config.pin_count; i++) {
+        v |= (uint32_t)((s_levels >> p->pins[i]) & 1) << i;
+    }
+    return v;
+}
+
+// Write every sample taken before before_us with the current levels.
+static void par_fill(int64_t before_us) {
+    struct pin_hal_par *p = &s_par;
+    uint32_t v = par_sample(p);
+    size_t ring_samples = p->per_buffer * p->config.buffers;
+    while (p->running && par_sample_us(p, p->next) < before_us) {
+        uint8_t *at = p->ring + (p->next % ring_samples) * p->width;
+        at[0] = (uint8_t)v;
+        if (p->width == 2) {
+            at[1] = (uint8_t)(v >> 8);
+        }
+        p->next++;
+        if (p->next % p->per_buffer == 0) {
+            size_t buf = (size_t)((p->next / p->per_buffer - 1) % p->config.buffers);
+            p->on_done(p, p->ring + buf * p->config.buffer_bytes, p->config.buffer_bytes, p->arg);
+        }
+    }
+}
+
+// When the last sample of the buffer being filled is due.
+static int64_t par_buffer_due_us(void) {
+    const struct pin_hal_par *p = &s_par;
+    if (!p->running) {
+        return INT64_MAX;
+    }
+    return par_sample_us(p, (p->next / p->per_buffer + 1) * p->per_buffer - 1);
+}
+
+static void lp_poll(void) {
+    struct pin_hal_sim_lp *lp = &s_lp;
+    lp->next_us += lp->poll_us;
+    uint32_t inputs = (uint32_t)(s_levels & ((1u << PIN_HAL_LP_MAX_GPIO) - 1));
+    if (pin_hal_lp_poll(&lp->shared, inputs, (uint64_t)s_now_us) && lp->asleep) {
+        lp->asleep = false;
+        lp->cause = lp->shared.wake_bits;
+    }
+}
+
+// Apply a level and raise the pin's interrupt the way the GPIO block would.
+// force treats it as an edge even if the level did not change (replayed edge
+// whose other half was never seen); counters and captures see a zero-width
+// pulse.
+static void apply_level(int pin, int level, bool force) {
+    uint64_t bit = 1ULL << pin;
+    bool moved = ((s_levels & bit) != 0) != (level != 0);
+    bool changed = force || moved;
+    if (s_par.running) {
+        par_fill(s_now_us);
+    }
+    s_levels = level ? (s_levels | bit) : (s_levels & ~bit);
+    s_pins[pin].driven = true;
+    if (!moved && force) {
+        pcnt_input(pin, !level);
+        cap_input(pin, !level);
+        rmt_input(pin, !level);
+    }
+    if (changed) {
+        pcnt_input(pin, level != 0);
+        cap_input(pin, level != 0);
+        rmt_input(pin, level != 0);
+    }
+
+    sim_pin_t *p = &s_pins[pin];
+    if (!p->intr_enabled || !intr_matches(p->intr_type, level, changed)) {
+        return;
+    }
+    if (s_global_isr) {
+        s_status |= bit;
+        s_global_isr(s_global_isr_arg);
+    } else if (p->isr) {
+        p->isr(p->isr_arg);
+    }
+}
+
+static struct pin_hal_sim_timer *next_timer(void) {
+    struct pin_hal_sim_timer *best = NULL;
+    for (size_t i = 0; i < s_timer_count; i++) {
+        struct pin_hal_sim_timer *t = &s_timers[i];
+        if (t->active && (!best || t->next_us < best->next_us)) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+// ---- pin_hal backend ----
+
+int64_t pin_hal_time_us(void) {
+    return s_now_us;
+}
+
+uint64_t pin_hal_read_levels(void) {
+    return s_levels;
+}
+
+uint64_t pin_hal_take_intr_status(void) {
+    uint64_t status = s_status;
+    s_status = 0;
+    return status;
+}
+
+esp_err_t pin_hal_intr_enable(gpio_num_t pin) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[pin].intr_enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_intr_disable(gpio_num_t pin) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[pin].intr_enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_config_input(gpio_num_t pin, bool pull_up, gpio_int_type_t intr_type) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    (void)pin_hal_set_pull_up(pin, pull_up);
+    s_pins[pin].intr_type = intr_type;
+    s_pins[pin].intr_enabled = (intr_type != GPIO_INTR_DISABLE);
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_config_inputs(uint64_t mask, uint64_t pull_up_mask) {
+    for (uint64_t pins = mask; pins; pins &= pins - 1) {
+        esp_err_t err = pin_hal_config_input((gpio_num_t)__builtin_ctzll(pins),
+                                             (pull_up_mask & pins & -pins) != 0,
+                                             GPIO_INTR_DISABLE);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_set_pull_up(gpio_num_t pin, bool pull_up) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // An undriven input floats to its pull; once the script drives it, the script wins.
+    if (!s_pins[pin].driven) {
+        uint64_t bit = 1ULL << pin;
+        s_levels = pull_up ? (s_levels | bit) : (s_levels & ~bit);
+        s_pins[pin].tail_level = pull_up;
+    }
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_set_intr_type(gpio_num_t pin, gpio_int_type_t intr_type) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[pin].intr_type = intr_type;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_isr_service_install(int intr_flags) {
+    (void)intr_flags;
+    if (s_isr_service || s_global_isr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_isr_service = true;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_isr_handler_add(gpio_num_t pin, pin_hal_isr_t isr, void *arg) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_pins[pin].isr = isr;
+    s_pins[pin].isr_arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_isr_handler_remove(gpio_num_t pin) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[pin].isr = NULL;
+    s_pins[pin].isr_arg = NULL;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_isr_register(pin_hal_isr_t isr, void *arg, int intr_flags,
+                               pin_hal_intr_handle_t *handle) {
+    (void)intr_flags;
+    if (s_isr_service || s_global_isr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_global_isr = isr;
+    s_global_isr_arg = arg;
+    if (handle) {
+        *handle = (pin_hal_intr_handle_t)&s_global_isr;
+    }
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_run_on_core(int core, void (*fn)(void *), void *arg) {
+    (void)core; // One simulated core
+    fn(arg);
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_timer_create(pin_hal_timer_cb_t cb, void *arg, const char *name,
+                               bool isr_dispatch, pin_hal_timer_t *out) {
+    (void)isr_dispatch; // Both dispatch methods run synchronously here
+    if (!cb || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Reuse a deleted timer before taking a new one.
+    struct pin_hal_sim_timer *t = NULL;
+    for (size_t i = 0; i < s_timer_count && !t; i++) {
+        t = s_timers[i].cb ? NULL : &s_timers[i];
+    }
+    if (!t) {
+        if (s_timer_count == PIN_SIM_MAX_TIMERS) {
+            ESP_LOGE(TAG, "Out of simulated timers for %s", name ? name : "?");
+            return ESP_ERR_NO_MEM;
+        }
+        t = &s_timers[s_timer_count++];
+    }
+    *t = (struct pin_hal_sim_timer){ .cb = cb, .arg = arg, .name = name };
+    *out = t;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_timer_start_periodic(pin_hal_timer_t timer, uint64_t period_us) {
+    if (!timer || period_us == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->period_us = period_us;
+    timer->next_us = s_now_us + (int64_t)period_us;
+    timer->active = true;
+    timer->once = false;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_timer_start_once(pin_hal_timer_t timer, uint64_t timeout_us) {
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->period_us = timeout_us;
+    timer->next_us = s_now_us + (int64_t)timeout_us;
+    timer->active = true;
+    timer->once = true;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_timer_stop(pin_hal_timer_t timer) {
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_timer_delete(pin_hal_timer_t timer) {
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *timer = (struct pin_hal_sim_timer){0};  // cb == NULL: free
+    return ESP_OK;
+}
+
+void pin_hal_timer_isr_yield(void) {
+}
+
+esp_err_t pin_hal_drive_enable(gpio_num_t pin, int level) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    apply_level(pin, level, false);
+    s_pins[pin].tail_level = (uint8_t)(level != 0);
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_drive_disable(gpio_num_t pin) {
+    return GPIO_IS_VALID_GPIO(pin) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void pin_hal_drive(gpio_num_t pin, int level) {
+    if (GPIO_IS_VALID_GPIO(pin)) {
+        apply_level(pin, level, true);
+        s_pins[pin].tail_level = (uint8_t)(level != 0);
+    }
+}
+
+esp_err_t pin_hal_pcnt_create(const pin_hal_pcnt_config_t *config, pin_hal_pcnt_cb_t on_limit,
+                              void *arg, pin_hal_pcnt_t *out) {
+    if (!config || !out || !GPIO_IS_VALID_GPIO(config->pin) || config->limit < 1 ||
+        config->limit > 32767 || config->glitch_ns > PIN_SIM_MAX_GLITCH_NS ||
+        config->quadrature_pin == config->pin ||
+        (config->quadrature_pin != GPIO_NUM_NC && !GPIO_IS_VALID_GPIO(config->quadrature_pin))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < PIN_HAL_PCNT_UNITS; i++) {
+        struct pin_hal_sim_pcnt *u = &s_pcnt[i];
+        if (u->in_use) {
+            continue;
+        }
+        *u = (struct pin_hal_sim_pcnt){
+            .config = *config, .on_limit = on_limit, .arg = arg, .in_use = true,
+        };
+        for (int input = 0; input < 2; input++) {
+            gpio_num_t pin = input ? config->quadrature_pin : config->pin;
+            u->level[input] = u->raw[input] =
+                (pin == GPIO_NUM_NC) ? 0 : (uint8_t)((s_levels >> pin) & 1);
+            u->raw_ns[input] = s_now_us * 1000;
+        }
+        out->unit = u;
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t pin_hal_pcnt_delete(pin_hal_pcnt_t *pcnt) {
+    if (!pcnt || !pcnt->unit) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pcnt->unit->in_use = false;
+    pcnt->unit = NULL;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_pcnt_get(pin_hal_pcnt_t *pcnt, int *count) {
+    if (!pcnt || !pcnt->unit || !count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pcnt_settle(pcnt->unit, s_now_us * 1000);
+    *count = pcnt->unit->count;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_cap_timer_create(int group, pin_hal_cap_timer_t *out, uint32_t *resolution_hz) {
+    if (group < 0 || group >= PIN_HAL_CAP_GROUPS || !out || !resolution_hz) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_cap_timers[group].in_use) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_cap_timers[group].in_use = true;
+    *out = &s_cap_timers[group];
+    *resolution_hz = PIN_SIM_CAP_HZ;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_cap_channel_create(pin_hal_cap_timer_t timer, gpio_num_t pin, bool pull_up,
+                                     pin_hal_cap_cb_t on_capture, void *arg,
+                                     pin_hal_cap_channel_t *out) {
+    if (!timer || !timer->in_use || !GPIO_IS_VALID_GPIO(pin) || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct pin_hal_sim_cap_channel *channels = s_cap_channels[timer - s_cap_timers];
+    for (size_t c = 0; c < PIN_HAL_CAP_CHANNELS; c++) {
+        if (channels[c].in_use) {
+            continue;
+        }
+        (void)pin_hal_set_pull_up(pin, pull_up);
+        channels[c] = (struct pin_hal_sim_cap_channel){
+            .pin = pin, .on_capture = on_capture, .arg = arg, .in_use = true,
+        };
+        *out = &channels[c];
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t pin_hal_cap_channel_delete(pin_hal_cap_channel_t chan) {
+    if (!chan || !chan->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    chan->in_use = false;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_rmt_rx_create(const pin_hal_rmt_rx_config_t *config, pin_hal_rmt_rx_cb_t on_done,
+                                void *arg, pin_hal_rmt_rx_t *out) {
+    if (!config || !GPIO_IS_VALID_GPIO(config->pin) || config->resolution_hz == 0 || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = NULL;
+    // Like the ESP32-S3, only the last receive channel can use DMA.
+    size_t first = config->dma ? PIN_HAL_RMT_RX_CHANNELS - 1 : 0;
+    size_t end = config->dma ? PIN_HAL_RMT_RX_CHANNELS : PIN_HAL_RMT_RX_CHANNELS - 1;
+    for (size_t i = first; i < end; i++) {
+        if (s_rmt_rx[i].in_use) {
+            continue;
+        }
+        s_rmt_rx[i] = (struct pin_hal_sim_rmt_rx){
+            .config = *config, .on_done = on_done, .arg = arg, .in_use = true,
+        };
+        *out = &s_rmt_rx[i];
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t pin_hal_rmt_rx_receive(pin_hal_rmt_rx_t chan, pin_hal_rmt_symbol_t *buf, size_t symbols,
+                                 uint32_t min_ns, uint32_t max_ns) {
+    if (!chan || !chan->in_use || !buf || symbols < 2 || min_ns > PIN_SIM_RMT_MAX_FILTER_NS ||
+        (uint64_t)max_ns * chan->config.resolution_hz / 1000000000u > PIN_SIM_RMT_MAX_TICKS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (chan->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    chan->armed = true;
+    chan->started = false;
+    chan->pending = false;
+    chan->buf = buf;
+    chan->symbols = symbols;
+    chan->halves = 0;
+    chan->min_ns = min_ns;
+    chan->max_ns = max_ns;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_rmt_rx_delete(pin_hal_rmt_rx_t chan) {
+    if (!chan || !chan->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    chan->in_use = false;
+    chan->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_par_create(const pin_hal_par_config_t *config, pin_hal_par_cb_t on_done,
+                             void *arg, pin_hal_par_t *out, uint32_t *sample_hz) {
+    if (!config || !config->pins || config->pin_count == 0 ||
+        config->pin_count > PIN_HAL_PAR_MAX_PINS || !GPIO_IS_VALID_GPIO(config->clock_pin) ||
+        config->sample_hz < PIN_HAL_PAR_MIN_HZ || config->sample_hz > PIN_HAL_PAR_MAX_HZ ||
+        config->buffer_bytes == 0 || config->buffer_bytes % 4 ||
+        config->buffer_bytes > PIN_HAL_PAR_MAX_BUFFER || config->buffers < 2 || !on_done || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < config->pin_count; i++) {
+        if (!GPIO_IS_VALID_GPIO(config->pins[i]) || config->pins[i] == config->clock_pin) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (s_par.in_use) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    uint32_t div = (PIN_SIM_PAR_SOURCE_HZ + config->sample_hz / 2) / config->sample_hz;
+    div = div < 2 ? 2 : (div > 256 ? 256 : div);
+    uint8_t *ring = calloc(config->buffers, config->buffer_bytes);
+    if (!ring) {
+        return ESP_ERR_NO_MEM;
+    }
+    struct pin_hal_par *p = &s_par;
+    *p = (struct pin_hal_par){
+        .config = *config, .on_done = on_done, .arg = arg, .ring = ring,
+        .hz = PIN_SIM_PAR_SOURCE_HZ / div, .width = config->pin_count > 8 ? 2 : 1,
+        .in_use = true,
+    };
+    memcpy(p->pins, config->pins, config->pin_count * sizeof(config->pins[0]));
+    p->config.pins = p->pins;
+    p->per_buffer = config->buffer_bytes / p->width;
+    *out = p;
+    if (sample_hz) {
+        *sample_hz = p->hz;
+    }
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_par_start(pin_hal_par_t par) {
+    if (!par || !par->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (par->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    par->next = 0;
+    par->start_us = s_now_us;
+    par->running = true;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_par_stop(pin_hal_par_t par) {
+    if (!par || !par->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    par->running = false;
+    return ESP_OK;
+}
+
+esp_err_t pin_hal_par_delete(pin_hal_par_t par) {
+    if (!par || !par->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    free(par->ring);
+    *par = (struct pin_hal_par){ 0 };
+    return ESP_OK;
+}
+
+bool pin_hal_lp_pin_valid(gpio_num_t pin) {
+    return GPIO_IS_VALID_GPIO(pin) && pin < PIN_HAL_LP_MAX_GPIO;
+}
+
+static void lp_set_wake(const pin_hal_lp_config_t *config) {
+    pin_hal_lp_shared_t *lp = &s_lp.shared;
+    lp->priority_mask = config->priority_mask & config->pin_mask;
+    lp->watermark = config->watermark;
+    lp->latency_ticks = (uint64_t)config->max_latency_ms * 1000;
+}
+
+esp_err_t pin_hal_lp_start(const pin_hal_lp_config_t *config, bool *resumed) {
+    if (!config || !config->pin_mask || config->poll_us < PIN_HAL_LP_MIN_POLL_US ||
+        config->watermark == 0 || config->watermark > PIN_HAL_LP_EVENTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint32_t pins = config->pin_mask; pins; pins &= pins - 1) {
+        if (!pin_hal_lp_pin_valid((gpio_num_t)__builtin_ctz(pins))) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    bool running = s_lp.running && s_lp.shared.pin_mask == config->pin_mask;
+    if (resumed) {
+        *resumed = running;
+    }
+    if (running) {
+        lp_set_wake(config);
+        s_lp.lost = s_lp.shared.lost_ack;
+        return ESP_OK;
+    }
+
+    s_lp = (struct pin_hal_sim_lp){
+        .poll_us = config->poll_us, .next_us = s_now_us + config->poll_us, .running = true,
+    };
+    s_lp.shared.pin_mask = config->pin_mask;
+    memcpy(s_lp.shared.stable_polls, config->stable_polls, sizeof(s_lp.shared.stable_polls));
+    lp_set_wake(config);
+    s_lp.shared.magic = PIN_HAL_LP_MAGIC;
+    for (uint32_t pins = config->pin_mask; pins; pins &= pins - 1) {
+        (void)pin_hal_set_pull_up((gpio_num_t)__builtin_ctz(pins),
+                                  (config->pull_up_mask & pins & -pins) != 0);
+    }
+    return ESP_OK;
+}
+
+uint32_t pin_hal_lp_wake_cause(void) {
+    return s_lp.cause;
+}
+
+size_t pin_hal_lp_peek(pin_hal_lp_event_t *out, size_t max, uint32_t *lost) {
+    pin_hal_lp_shared_t *lp = &s_lp.shared;
+    if (lost) {
+        *lost = 0;
+    }
+    if (!s_lp.running) {
+        return 0;
+    }
+    size_t n = 0;
+    for (; n < max && lp->tail + n != lp->head; n++) {
+        const pin_hal_lp_record_t *r = &lp->events[(lp->tail + n) % PIN_HAL_LP_EVENTS];
+        out[n] = (pin_hal_lp_event_t){
+            .pin = (gpio_num_t)r->pin,
+            .level = r->level,
+            .age_us = s_now_us - (int64_t)pin_hal_lp_record_ticks(r),
+        };
+    }
+    pin_hal_lp_seen(lp, lp->tail + (uint32_t)n);
+    s_lp.lost = lp->lost;
+    if (lost) {
+        *lost = s_lp.lost - lp->lost_ack;
+    }
+    return n;
+}
+
+void pin_hal_lp_consume(size_t n) {
+    if (s_lp.running) {
+        pin_hal_lp_free(&s_lp.shared, (uint32_t)n);
+        s_lp.shared.lost_ack = s_lp.lost;
+    }
+}
+
+esp_err_t pin_hal_lp_sleep(uint64_t timeout_us) {
+    if (!s_lp.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t until = timeout_us ? s_now_us + (int64_t)timeout_us : INT64_MAX;
+    s_lp.shared.wake_ack = s_lp.shared.wake_req;
+    s_lp.asleep = true;
+    while (s_lp.asleep && s_now_us < until) {
+        pin_sim_run_until(s_lp.next_us < until ? s_lp.next_us : until);
+    }
+    if (s_lp.asleep) {
+        s_lp.asleep = false;
+        s_lp.cause = PIN_HAL_LP_WAKE_TIMER;
+    }
+    return ESP_OK;
+}
+
+// ---- Waveform injector ----
+
+void pin_sim_seed(uint32_t seed) {
+    s_rng = seed ? seed : 1;
+}
+
+int64_t pin_sim_now(void) {
+    return s_now_us;
+}
+
+int64_t pin_sim_schedule(gpio_num_t pin, int64_t at_us, int level) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return -1;
+    }
+    if (at_us < s_now_us) {
+        at_us = s_now_us;
+    }
+    sim_edge_t edge = { .at_us = at_us, .seq = s_seq++, .pin = (uint8_t)pin, .level = level ? 1 : 0 };
+    if (!edge_push(&edge)) {
+        ESP_LOGE(TAG, "Edge queue full (%u)", (unsigned)PIN_SIM_MAX_EDGES);
+        return -1;
+    }
+    sim_pin_t *p = &s_pins[pin];
+    if (at_us >= p->tail_us) {
+        p->tail_us = at_us;
+        p->tail_level = edge.level;
+    }
+    return at_us;
+}
+
+int64_t pin_sim_transition(gpio_num_t pin, int64_t at_us, int level, const pin_sim_bounce_t *shape) {
+    uint32_t glitches = shape ? 2u * shape->bounces : 0;
+    uint32_t bounce_us = shape ? shape->bounce_us : 0;
+    uint32_t offsets[2 * PIN_SIM_MAX_BOUNCES];
+
+    if (glitches > 2 * PIN_SIM_MAX_BOUNCES) {
+        glitches = 2 * PIN_SIM_MAX_BOUNCES;
+    }
+    int64_t first = pin_sim_schedule(pin, at_us + sim_jitter(shape ? shape->jitter_us : 0), level);
+    if (first < 0) {
+        return -1;
+    }
+
+    // Random glitch times, sorted; pairs of opposite/target edges end on level.
+    for (uint32_t i = 0; i < glitches; i++) {
+        uint32_t off = bounce_us ? 1 + sim_rand() % bounce_us : i + 1;
+        uint32_t j = i;
+        while (j > 0 && offsets[j - 1] > off) {
+            offsets[j] = offsets[j - 1];
+            j--;
+        }
+        offsets[j] = off;
+    }
+    int64_t last = first;
+    for (uint32_t i = 0; i < glitches; i++) {
+        last = pin_sim_schedule(pin, first + offsets[i], (i & 1) ? level : !level);
+        if (last < 0) {
+            return -1;
+        }
+    }
+    return last;
+}
+
+int64_t pin_sim_burst(gpio_num_t pin, int64_t start_us, uint32_t half_period_us,
+                      uint32_t edges, uint32_t jitter_us) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return -1;
+    }
+    int level = s_pins[pin].tail_level;
+    int64_t last = start_us;
+    for (uint32_t i = 0; i < edges; i++) {
+        level = !level;
+        last = pin_sim_schedule(pin, start_us + (int64_t)i * half_period_us + sim_jitter(jitter_us),
+                                level);
+        if (last < 0) {
+            return -1;
+        }
+    }
+    return last;
+}
+
+int pin_sim_final_level(gpio_num_t pin) {
+    return GPIO_IS_VALID_GPIO(pin) ? s_pins[pin].tail_level : 0;
+}
+
+void pin_sim_run_until(int64_t t_us) {
+    for (;;) {
+        struct pin_hal_sim_timer *timer = next_timer();
+        struct pin_hal_sim_rmt_rx *rmt = next_rmt_idle();
+        int64_t edge_us = s_edge_count ? s_edges[0].at_us : INT64_MAX;
+        int64_t timer_us = timer ? timer->next_us : INT64_MAX;
+        int64_t rmt_us = rmt ? rmt->idle_us : INT64_MAX;
+        int64_t par_us = par_buffer_due_us();
+        int64_t lp_us = s_lp.running ? s_lp.next_us : INT64_MAX;
+        int64_t next_us = edge_us <= timer_us ? edge_us : timer_us;
+        next_us = rmt_us < next_us ? rmt_us : next_us;
+        next_us = par_us < next_us ? par_us : next_us;
+        next_us = lp_us < next_us ? lp_us : next_us;
+        if (next_us > t_us) {
+            break;
+        }
+        s_now_us = next_us;
+        // Edges win ties: an interrupt pending at a tick is taken before it,
+        // then receive-done and buffer-done interrupts and the ULP poll.
+        if (edge_us == next_us) {
+            sim_edge_t edge = edge_pop();
+            apply_level(edge.pin, edge.level, false);
+        } else if (rmt_us == next_us) {
+            rmt_idle(rmt);
+        } else if (par_us == next_us) {
+            par_fill(next_us + 1);
+        } else if (lp_us == next_us) {
+            lp_poll();
+        } else {
+            timer->next_us += (int64_t)timer->period_us;
+            if (timer->once) {
+                timer->active = false;
+            }
+            timer->cb(timer->arg);
+        }
+    }
+    if (t_us > s_now_us) {
+        s_now_us = t_us;
+    }
+}
+
+size_t pin_sim_pending(void) {
+    return s_edge_count;
+}
@@ -0,0 +1,33 @@
+/**
+ * ULP-RISC-V program of the low-power monitor (see pin_hal_lp.h). The ULP
+ * timer starts it every poll period; it reads all RTC GPIOs and the RTC slow
+ * clock once, runs one poll and halts until the next period.
+ */
+
+#include <stdint.h>
+#include "ulp_riscv_utils.h"
+#include "ulp_riscv_register_ops.h"
+#include "soc/rtc_cntl_reg.h"
+#include "soc/rtc_io_reg.h"
+#include "pin_hal_lp.h"
+
+// Exported to the main CPU as ulp_lp_shared.
+volatile pin_hal_lp_shared_t lp_shared;
+
+// The RTC timer the main CPU reads with rtc_time_get().
+static uint64_t rtc_ticks(void) {
+    SET_PERI_REG_MASK(RTC_CNTL_TIME_UPDATE_REG, RTC_CNTL_TIME_UPDATE);
+    uint64_t lo = READ_PERI_REG(RTC_CNTL_TIME0_REG);
+    return lo | (uint64_t)READ_PERI_REG(RTC_CNTL_TIME1_REG) << 32;
+}
+
+int main(void) {
+    if (lp_shared.magic != PIN_HAL_LP_MAGIC) {
+        return 0;
+    }
+    uint32_t inputs = REG_GET_FIELD(RTC_GPIO_IN_REG, RTC_GPIO_IN_NEXT);
+    if (pin_hal_lp_poll(&lp_shared, inputs, rtc_ticks())) {
+        ulp_riscv_wakeup_main_processor();
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Where formatted messages go (MQTT on the device, a recorder in the
+ *        simulator). Returns a negative value if the message was not sent.
+ */
+typedef int (*pin_pipeline_sink_t)(const char *topic, const char *msg, void *ctx);
+
+/**
+ * @brief Set the publish sink. Messages are counted as failed while it is NULL.
+ */
+void pin_pipeline_set_sink(pin_pipeline_sink_t sink, void *ctx);
+
+/**
+ * @brief Start the consumer task that drains the event rings and reports
+ *        stats and latency every interval. Producers notify it once started.
+ */
+esp_err_t pin_pipeline_start(void);
+
+/**
+ * @brief Publish everything queued in the rings, then the coalesced records.
+ *        Called by the consumer task; the simulator calls it directly.
+ *
+ * @return Number of messages handed to the sink
+ */
+size_t pin_pipeline_drain(void);
+
+/**
+ * @brief Periodic report: dispatch latency log, adaptive windows, pipeline
+ *        stats and latency percentiles (each resets its interval).
+ */
+void pin_pipeline_report(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,382 @@
+/**
+ * @file pin_pipeline.c
+ * @brief Consumer side of the GPIO event pipeline: drains the per-lane event
+ *        rings and the coalesced overflow records, formats each event and hands
+ *        it to the publish sink, and reports pipeline stats and latency.
+ *
+ * Kept free of MQTT and Wi-Fi so the same code runs on the device and in the
+ * linux-target simulator.
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#include "pin_hal.h"
+#include "debounce.h"
+#include "app_shared.h"
+#include "pin_pipeline.h"
+
+static const char *TAG = "PinPipeline";
+
+// ==== GLOBALS (single definitions; extern in app_shared.h) ====
+gpio_event_ring_t gpio_event_rings[GPIO_EVENT_LANE_COUNT];
+TaskHandle_t gpio_event_consumer = NULL;
+
+#define LATENCY_REPORT_INTERVAL_MS 60000
+#define DIAG_TOPIC "/pinMonitor/diag"
+
+#define STATS_TOPIC DIAG_TOPIC "/stats"
+#define LATENCY_TOPIC DIAG_TOPIC "/latency"
+#define ALERT_TOPIC DIAG_TOPIC "/alert"
+#define LATENCY_ALERT_MIN_SAMPLES 20  // Fewer events make p99 meaningless
+
+static pin_pipeline_sink_t s_sink = NULL;
+static void *s_sink_ctx = NULL;
+
+// Single exit point, so every publish is counted in the pipeline stats.
+static void publish(const char *topic, const char *msg)
+{
+    int msg_id = s_sink ? s_sink(topic, msg, s_sink_ctx) : -1;
+    gpio_stats_stage_inc(msg_id < 0 ? GPIO_STAGE_STAT_PUBLISH_FAILED : GPIO_STAGE_STAT_PUBLISHED);
+}
+
+// Interrupt moderation started or ended on a pin; goes to the diagnostics topic.
+static void publish_chatter(const gpio_event_t *evt)
+{
+    char msg[96];
+    bool start = (evt->kind == GPIO_EVENT_CHATTER_START);
+    snprintf(msg, sizeof(msg), "GPIO %d chatter %s level=%s seq=%" PRIu32 " confirm_us=%" PRIu32,
+             evt->pin, start ? "start" : "end", evt->level ? "HIGH" : "LOW",
+             evt->seq, evt->confirm_us);
+
+    publish(DIAG_TOPIC, msg);
+    ESP_LOGW(TAG, "Published: %s", msg);
+}
+
+/**
+ * Pulse counter window: the figures live in the debounce component, one
+ * window per pin. An event overtaken by a newer window is skipped; that
+ * window's own event follows and its total covers the pulses of both.
+ */
+static void publish_count(const gpio_event_t *evt)
+{
+    debounce_count_t win;
+    if (debounce_get_count((gpio_num_t)evt->pin, &win) != ESP_OK ||
+        (uint32_t)win.window_start_us != evt->edge_us) {
+        return;
+    }
+
+    char msg[192];
+    snprintf(msg, sizeof(msg),
+             "GPIO %d count total=%" PRIu64 " delta=%" PRIu32 " rate=%" PRIu32 ".%03" PRIu32
+             "/s window_us=%" PRIu32 " seq=%" PRIu32 " confirm_us=%" PRIu32,
+             evt->pin, win.total, win.delta, win.rate_milli_hz / 1000, win.rate_milli_hz % 1000,
+             win.window_us, evt->seq, evt->confirm_us);
+
+    const char *topic = debounce_get_topic((gpio_num_t)evt->pin);
+    publish(topic ? topic : "/pinMonitor/event", msg);
+    ESP_LOGD(TAG, "Published: %s", msg);
+}
+
+// Encoder report; stale events are skipped the same way as for counts.
+static void publish_position(const gpio_event_t *evt)
+{
+    debounce_position_t pos;
+    if (debounce_get_position((gpio_num_t)evt->pin, &pos) != ESP_OK ||
+        (uint32_t)pos.since_us != evt->edge_us) {
+        return;
+    }
+
+    char msg[192];
+    snprintf(msg, sizeof(msg),
+             "GPIO %d position=%" PRId64 " delta=%" PRId32 " velocity=%" PRId32
+             "/s interval_us=%" PRIu32 " seq=%" PRIu32 " confirm_us=%" PRIu32,
+             evt->pin, pos.position, pos.delta, pos.velocity, pos.interval_us,
+             evt->seq, evt->confirm_us);
+
+    const char *topic = debounce_get_topic((gpio_num_t)evt->pin);
+    publish(topic ? topic : "/pinMonitor/event", msg);
+    ESP_LOGD(TAG, "Published: %s", msg);
+}
+
+/**
+ * PWM capture window as min/mean/max triplets, duty in percent; stale events
+ * are skipped the same way as for counts.
+ */
+static void publish_pwm(const gpio_event_t *evt)
+{
+    debounce_pwm_t win;
+    if (debounce_get_pwm((gpio_num_t)evt->pin, &win) != ESP_OK ||
+        (uint32_t)win.window_start_us != evt->edge_us) {
+        return;
+    }
+
+    char msg[256];
+    snprintf(msg, sizeof(msg),
+             "GPIO %d pwm cycles=%" PRIu32 " period_ns=%" PRIu32 "/%" PRIu32 "/%" PRIu32
+             " high_ns=%" PRIu32 "/%" PRIu32 "/%" PRIu32 " duty=%u.%02u/%u.%02u/%u.%02u%%"
+             " level=%s window_us=%" PRIu32 " seq=%" PRIu32 " confirm_us=%" PRIu32,
+             evt->pin, win.cycles, win.period_min_ns, win.period_mean_ns, win.period_max_ns,
+             win.high_min_ns, win.high_mean_ns, win.high_max_ns,
+             win.duty_min_bp / 100, win.duty_min_bp % 100, win.duty_mean_bp / 100,
+             win.duty_mean_bp % 100, win.duty_max_bp / 100, win.duty_max_bp % 100,
+             win.level ? "HIGH" : "LOW", win.window_us, evt->seq, evt->confirm_us);
+
+    const char *topic = debounce_get_topic((gpio_num_t)evt->pin);
+    publish(topic ? topic : "/pinMonitor/event", msg);
+    ESP_LOGD(TAG, "Published: %s", msg);
+}
+
+/**
+ * Decoded burst frame, payload in hex ("-" for a frame without bits, such as
+ * an IR repeat code); stale events are skipped the same way as for counts.
+ */
+static void publish_frame(const gpio_event_t *evt)
+{
+    debounce_frame_t frame;
+    if (debounce_get_frame((gpio_num_t)evt->pin, &frame) != ESP_OK ||
+        (uint32_t)frame.start_us != evt->edge_us) {
+        return;
+    }
+
+    char data[2 * sizeof(frame.data) + 1] = "-";
+    size_t bytes = ((size_t)frame.bits + 7) / 8;
+    for (size_t i = 0; i < bytes && i < sizeof(frame.data); i++) {
+        snprintf(&data[2 * i], 3, "%02x", frame.data[i]);
+    }
+
+    char msg[192];
+    snprintf(msg, sizeof(msg),
+             "GPIO %d frame protocol=%s bits=%u data=%s valid=%s duration_us=%" PRIu32
+             " seq=%" PRIu32 " confirm_us=%" PRIu32,
+             evt->pin, frame.protocol, frame.bits, data, frame.valid ? "yes" : "no",
+             frame.duration_us, evt->seq, evt->confirm_us);
+
+    const char *topic = debounce_get_topic((gpio_num_t)evt->pin);
+    publish(topic ? topic : "/pinMonitor/event", msg);
+    ESP_LOGI(TAG, "Published: %s", msg);
+}
+
+static void publish_event(const gpio_event_t *evt, uint32_t dequeue_us)
+{
+    if (evt->kind == GPIO_EVENT_COUNT) {
+        publish_count(evt);
+        return;
+    }
+    if (evt->kind == GPIO_EVENT_POSITION) {
+        publish_position(evt);
+        return;
+    }
+    if (evt->kind == GPIO_EVENT_PWM) {
+        publish_pwm(evt);
+        return;
+    }
+    if (evt->kind == GPIO_EVENT_FRAME) {
+        publish_frame(evt);
+        return;
+    }
+    if (evt->kind != GPIO_EVENT_LEVEL) {
+        publish_chatter(evt);
+        return;
+    }
+
+    // The *_us fields are the 32-bit timestamps of gpio_event_t and wrap every
+    // ~71.6 min; subscribers must difference them modulo 2^32.
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "GPIO %d is now %s seq=%" PRIu32 " edge_us=%" PRIu32
+             " confirm_us=%" PRIu32 " dequeue_us=%" PRIu32,
+             evt->pin, evt->level ? "HIGH" : "LOW",
+             evt->seq, evt->edge_us, evt->confirm_us, dequeue_us);
+
+    const char *topic = debounce_get_topic((gpio_num_t)evt->pin);
+    publish(topic ? topic : "/pinMonitor/event", msg);
+    uint32_t published_us = (uint32_t)pin_hal_time_us();
+
+    gpio_latency_record(evt->pin, GPIO_LAT_STAGE_CONFIRM, (uint32_t)(evt->confirm_us - evt->edge_us));
+    gpio_latency_record(evt->pin, GPIO_LAT_STAGE_DEQUEUE, (uint32_t)(dequeue_us - evt->confirm_us));
+    gpio_latency_record(evt->pin, GPIO_LAT_STAGE_PUBLISH, (uint32_t)(published_us - dequeue_us));
+    gpio_latency_record(evt->pin, GPIO_LAT_STAGE_TOTAL, (uint32_t)(published_us - evt->edge_us));
+    ESP_LOGI(TAG, "Published: %s", msg);
+}
+
+// Several transitions merged on ring overflow; the final level is always current.
+static void publish_coalesced(const gpio_event_coalesced_t *rec, uint32_t dequeue_us)
+{
+    char msg[192];
+    snprintf(msg, sizeof(msg),
+             "GPIO %d: %" PRIu32 " transitions, final level %s seq=%" PRIu32 "-%" PRIu32
+             " first_us=%" PRIu32 " last_us=%" PRIu32 " dequeue_us=%" PRIu32,
+             rec->pin, rec->transitions, rec->level ? "HIGH" : "LOW",
+             rec->first_seq, rec->last_seq, rec->first_us, rec->last_us, dequeue_us);
+
+    const char *topic = debounce_get_topic((gpio_num_t)rec->pin);
+    publish(topic ? topic : "/pinMonitor/event", msg);
+    ESP_LOGW(TAG, "Published (coalesced): %s", msg);
+}
+
+/**
+ * Publish and reset the pipeline stats: one JSON message for the stages and
+ * ring high-water marks, then one per pin that saw activity. Rates are per
+ * second over the interval since the last reset.
+ */
+static void publish_stats(void)
+{
+    static gpio_stats_snapshot_t snap;  // ~1.3 KiB, kept off the task stack
+    char msg[384];
+
+    gpio_stats_snapshot(&snap, true);
+    int64_t interval_ms = (pin_hal_time_us() - snap.since_us) / 1000;
+    if (interval_ms <= 0) {
+        interval_ms = 1;
+    }
+
+    int len = snprintf(msg, sizeof(msg), "{\"interval_ms\":%lld", (long long)interval_ms);
+    for (int i = 0; i < GPIO_STAGE_STAT_COUNT && len < (int)sizeof(msg); i++) {
+        len += snprintf(msg + len, sizeof(msg) - len, ",\"%s\":%" PRIu32,
+                        gpio_stats_stage_stat_name(i), snap.stage[i]);
+    }
+    for (int lane = 0; lane < GPIO_EVENT_LANE_COUNT && len < (int)sizeof(msg); lane++) {
+        len += snprintf(msg + len, sizeof(msg) - len, "%s%" PRIu32,
+                        lane == 0 ? ",\"ring_hwm\":[" : ",", snap.ring_hwm[lane]);
+    }
+    if (len < (int)sizeof(msg)) {
+        snprintf(msg + len, sizeof(msg) - len, "]}");
+    }
+    publish(STATS_TOPIC, msg);
+    ESP_LOGI(TAG, "Stats: %s", msg);
+
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        const uint32_t *c = snap.pin[pin];
+        if (!c[GPIO_PIN_STAT_EDGES] && !c[GPIO_PIN_STAT_BURSTS]) {
+            continue;
+        }
+        len = snprintf(msg, sizeof(msg), "{\"pin\":%d,\"edges_per_s\":%" PRIu32, pin,
+                       (uint32_t)((uint64_t)c[GPIO_PIN_STAT_EDGES] * 1000 / interval_ms));
+        for (int i = 0; i < GPIO_PIN_STAT_COUNT && len < (int)sizeof(msg); i++) {
+            len += snprintf(msg + len, sizeof(msg) - len, ",\"%s\":%" PRIu32,
+                            gpio_stats_pin_stat_name(i), c[i]);
+        }
+        if (len < (int)sizeof(msg)) {
+            snprintf(msg + len, sizeof(msg) - len, "}");
+        }
+        publish(STATS_TOPIC, msg);
+    }
+}
+
+/**
+ * Publish p50/p99/p99.9/max per stage for every pin with samples, check the
+ * end-to-end p99 against CONFIG_APP_LATENCY_P99_BUDGET_US, then start a new
+ * interval.
+ */
+static void publish_latency(void)
+{
+#if CONFIG_APP_LATENCY_HIST
+    char msg[384];
+    gpio_latency_summary_t sum;
+
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        if (!gpio_latency_summary(pin, GPIO_LAT_STAGE_TOTAL, &sum)) {
+            continue;
+        }
+        int len = snprintf(msg, sizeof(msg), "{\"pin\":%d,\"n\":%" PRIu32, pin, sum.count);
+        for (int stage = 0; stage < GPIO_LAT_STAGE_COUNT && len < (int)sizeof(msg); stage++) {
+            if (!gpio_latency_summary(pin, stage, &sum)) {
+                continue;
+            }
+            len += snprintf(msg + len, sizeof(msg) - len,
+                            ",\"%s\":{\"p50\":%" PRIu32 ",\"p99\":%" PRIu32
+                            ",\"p999\":%" PRIu32 ",\"max\":%" PRIu32 "}",
+                            gpio_latency_stage_name(stage),
+                            sum.p50_us, sum.p99_us, sum.p999_us, sum.max_us);
+        }
+        if (len < (int)sizeof(msg)) {
+            snprintf(msg + len, sizeof(msg) - len, "}");
+        }
+        publish(LATENCY_TOPIC, msg);
+        ESP_LOGI(TAG, "Latency: %s", msg);
+
+        (void)gpio_latency_summary(pin, GPIO_LAT_STAGE_TOTAL, &sum);
+        if (CONFIG_APP_LATENCY_P99_BUDGET_US > 0 && sum.count >= LATENCY_ALERT_MIN_SAMPLES &&
+            sum.p99_us > CONFIG_APP_LATENCY_P99_BUDGET_US) {
+            snprintf(msg, sizeof(msg),
+                     "GPIO %d p99 edge->publish %" PRIu32 "us exceeds budget %dus (n=%" PRIu32 ")",
+                     pin, sum.p99_us, CONFIG_APP_LATENCY_P99_BUDGET_US, sum.count);
+            publish(ALERT_TOPIC, msg);
+            ESP_LOGW(TAG, "%s", msg);
+        }
+    }
+    gpio_latency_reset();
+#endif
+}
+
+void pin_pipeline_report(void)
+{
+    debounce_log_latency_stats(true);
+    debounce_adapt_run();
+    publish_stats();
+    publish_latency();
+}
+
+size_t pin_pipeline_drain(void)
+{
+    gpio_event_t evt;
+    gpio_event_coalesced_t rec;
+    size_t count = 0;
+
+    while (gpio_event_take(&evt))
+    {
+        gpio_stats_stage_inc(GPIO_STAGE_STAT_CONSUMED);
+        publish_event(&evt, (uint32_t)pin_hal_time_us());
+        count++;
+    }
+    // Overflow records come after the rings: anything still in a ring
+    // for a dirty pin is older than its record.
+    while (gpio_event_coalesce_take(&rec))
+    {
+        gpio_stats_stage_inc(GPIO_STAGE_STAT_CONSUMED);
+        publish_coalesced(&rec, (uint32_t)pin_hal_time_us());
+        count++;
+    }
+    return count;
+}
+
+static void gpio_task(void *arg)
+{
+    TickType_t last_report = xTaskGetTickCount();
+    for (;;)
+    {
+        if (xTaskGetTickCount() - last_report >= pdMS_TO_TICKS(LATENCY_REPORT_INTERVAL_MS))
+        {
+            pin_pipeline_report();
+            last_report = xTaskGetTickCount();
+        }
+
+        // One notification covers everything queued since the rings went empty.
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LATENCY_REPORT_INTERVAL_MS));
+        (void)pin_pipeline_drain();
+    }
+}
+
+void pin_pipeline_set_sink(pin_pipeline_sink_t sink, void *ctx)
+{
+    s_sink_ctx = ctx;
+    s_sink = sink;
+}
+
+esp_err_t pin_pipeline_start(void)
+{
+    if (gpio_event_consumer) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Rings are static; the task handle is what producers notify.
+    if (xTaskCreate(gpio_task, "gpio_task", 4096, NULL, 10, &gpio_event_consumer) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create gpio_task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
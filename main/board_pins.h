@@ -0,0 +1,23 @@
+#pragma once
+
+/**
+ * Pin map of this board: GPIO, MQTT topic, then debounce_config_t fields.
+ * Checked at compile time and registered in one go by pin_monitor_init().
+ */
+
+#include "debounce_table.h"
+
+#define BOARD_PINS(X)                                                            \
+    /* Button: report the press at once */                                       \
+    X(4, "/pinMonitor/gpio4", .intr_type = GPIO_INTR_POSEDGE, .pull_up = true,  \
+      .debounce_time_us = 50000, .policy = DEBOUNCE_POLICY_LEADING,              \
+      .state_change_only = true)                                                 \
+    /* Worst-case window, learned down from here */                              \
+    X(5, "/pinMonitor/gpio5", .intr_type = GPIO_INTR_NEGEDGE, .pull_up = true,  \
+      .debounce_time_us = 75000, .adaptive = true)
+
+// Unused GPIO the logic analyzer loops its sample clock through.
+#define BOARD_LA_CLOCK_PIN GPIO_NUM_40
+
+// Pins whose changes wake a battery build (CONFIG_PIN_MONITOR_LOW_POWER) at once.
+#define BOARD_ULP_PRIORITY_PINS (1ULL << 4)
@@ -11,6 +11,7 @@
  * - MQTT client setup and event publishing.
  * - GPIO pin monitoring with configurable debounce logic.
  * - Task-based event handling using FreeRTOS.
+ * - Optional battery mode: ULP monitoring in deep sleep, batched uploads.
  *
  * Modules Used:
  * - ESP-IDF Wi-Fi, MQTT, GPIO, FreeRTOS, and timer APIs.
@@ -33,86 +34,82 @@
 // Git test 8/18/2025 1620
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_system.h"
 #include "mqtt_client.h"
 #include "esp_event.h"
 #include "esp_netif.h"
 #include "nvs_flash.h"
 #include "esp_wifi.h"
-#include "esp_timer.h"
+#include "lwip/sockets.h"
 
 #include "debounce.h"
+#include "debounce_la.h"
+#include "debounce_ulp.h"
+#include "board_pins.h"
 #include "wifi_manager.h"
 #include "wifi_provisioning.h"
-#include "app_shared.h"
+#include "pin_pipeline.h"
 
 static EventGroupHandle_t wifi_event_group;
 static const char *TAG = "PinMonitor";
 
-// ==== GLOBALS (single definitions; extern in main_priv.h) ====
-QueueHandle_t gpio_event_queue = NULL;
-esp_mqtt_client_handle_t mqtt_client = NULL;
+static esp_mqtt_client_handle_t mqtt_client = NULL;
+static volatile int mqtt_published_id = -1;
 
 void mqtt_app_start(void);
 static void pin_monitor_init(void);
-static void gpio_task(void *arg);
 
 #define WIFI_CONNECTED_BIT BIT0
+#define MQTT_CONNECTED_BIT BIT1
+#define MQTT_PUBLISHED_BIT BIT2
 #define ESP_INTR_FLAG_DEFAULT 0
 
-// ---- GPIO event handling task (publishes MQTT from main context) ----
-static void gpio_task(void *arg)
+#define CMD_TOPIC      "/pinMonitor/cmd"
+#define CAPTURE_TOPIC  "/pinMonitor/capture"
+#define CAPTURE_PINS   DEBOUNCE_TABLE_MASK(BOARD_PINS)
+#define LA_PORT        9300
+#define LA_SAMPLE_HZ   1000000
+#define LA_PRE_SAMPLES 100000
+#define LA_POST_SAMPLES 900000
+#define BATCH_TOPIC    "/pinMonitor/batch"
+#define LP_CONNECT_MS  20000
+#define LP_PUBLISH_MS  10000
+
+DEBOUNCE_TABLE_CHECK(BOARD_PINS);
+DEBOUNCE_TABLE_DEFINE(board_pins, BOARD_PINS);
+static const gpio_num_t la_pins[] = DEBOUNCE_TABLE_PINS(BOARD_PINS);
+
+// MQTT publish sink for the event pipeline.
+static int mqtt_sink(const char *topic, const char *msg, void *ctx)
 {
-    gpio_event_t evt;
-    for (;;)
-    {
-        if (xQueueReceive(gpio_event_queue, &evt, portMAX_DELAY))
-        {
-            char msg[64];
-            snprintf(msg, sizeof(msg),
-                     "GPIO %d is now %s",
-                     evt.pin, evt.level ? "HIGH" : "LOW");
-
-            if (mqtt_client) {
-                esp_mqtt_client_publish(mqtt_client, evt.topic ? evt.topic : "/pinMonitor/event",
-                                        msg, 0, 1, 0);
-            }
-            ESP_LOGI(TAG, "Published: %s", msg);
-        }
-    }
+    return mqtt_client ? esp_mqtt_client_publish(mqtt_client, topic, msg, 0, 1, 0) : -1;
 }
 
-// ---- Debounce + queue setup (GPIO handling happens in main) ----
+static void la_server_task(void *arg);
+
+// ---- Debounce + event pipeline setup (event handling lives in pin_pipeline) ----
 static void pin_monitor_init(void)
 {
     debounce_init();
 
-    // Queue holds gpio_event_t sent by debounce.c timer callback
-    gpio_event_queue = xQueueCreate(10, sizeof(gpio_event_t));
-    xTaskCreate(gpio_task, "gpio_task", 4096, NULL, 10, NULL);
+    pin_pipeline_set_sink(mqtt_sink, NULL);
+    ESP_ERROR_CHECK(pin_pipeline_start());
 
-    debounce_config_t pin4_cfg = {
-        .pin = GPIO_NUM_4,
-        .intr_type = GPIO_INTR_POSEDGE,
-        .pull_up = true,
-        .debounce_time_us = 50000,
-        .mqtt_topic = "/pinMonitor/gpio4"
-    };
-    debounce_register_pin(&pin4_cfg);
-
-    debounce_config_t pin5_cfg = {
-        .pin = GPIO_NUM_5,
-        .intr_type = GPIO_INTR_NEGEDGE,
-        .pull_up = true,
-        .debounce_time_us = 75000,
-        .mqtt_topic = "/pinMonitor/gpio5"
-    };
-    debounce_register_pin(&pin5_cfg);
+    ESP_ERROR_CHECK(debounce_register_pins(board_pins, DEBOUNCE_TABLE_COUNT(BOARD_PINS)));
+
+    // Flight recorder: keep the latest raw edges for "capture upload".
+    debounce_capture_start(CAPTURE_PINS);
+
+    // Logic analyzer captures ("la arm") are downloaded over TCP.
+    xTaskCreate(la_server_task, "la_server", 4096, NULL, 3, NULL);
 }
 
 // ---- Basic Wi-Fi station init using creds from NVS "wifi_store" ----
@@ -133,7 +130,7 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
     }
 }
 
-void wifi_init_sta_ext(void)
+bool wifi_init_sta_ext(TickType_t timeout)
 {
     wifi_event_group = xEventGroupCreate();
 
@@ -153,7 +150,7 @@ void wifi_init_sta_ext(void)
     if (err != ESP_OK)
     {
         ESP_LOGE(TAG, "Error opening NVS handle: %s", esp_err_to_name(err));
-        return;
+        return false;
     }
 
     char ssid[32] = {0};
@@ -166,7 +163,7 @@ void wifi_init_sta_ext(void)
     {
         ESP_LOGE(TAG, "SSID not found in NVS: %s", esp_err_to_name(err));
         nvs_close(nvs_handle);
-        return;
+        return false;
     }
 
     // Unified on "password" key
@@ -175,7 +172,7 @@ void wifi_init_sta_ext(void)
     {
         ESP_LOGE(TAG, "Password not found in NVS: %s", esp_err_to_name(err));
         nvs_close(nvs_handle);
-        return;
+        return false;
     }
 
     nvs_close(nvs_handle);
@@ -190,12 +187,18 @@ void wifi_init_sta_ext(void)
     if (err != ESP_OK)
     {
         ESP_LOGE(TAG, "Failed to start WiFi: %s", esp_err_to_name(err));
-        return;
+        return false;
     }
 
     // Wait for connection
-    xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT, false, true, portMAX_DELAY);
+    if (!(xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT, false, true, timeout) &
+          WIFI_CONNECTED_BIT))
+    {
+        ESP_LOGW(TAG, "WiFi connection timed out");
+        return false;
+    }
     ESP_LOGI(TAG, "Connected to WiFi (NVS)");
+    return true;
 }
 
 void print_ip_info(esp_netif_t *netif)
@@ -208,6 +211,286 @@ void print_ip_info(esp_netif_t *netif)
     ESP_LOGI("NETIF", "Netmask:   " IPSTR, IP2STR(&ip_info.netmask));
 }
 
+// ---- Raw edge capture over MQTT ----
+// Stop the capture, publish it as one binary message and resume recording.
+static void capture_upload(void)
+{
+    debounce_capture_stop();
+    size_t cap = debounce_capture_export_size();
+    uint8_t *buf = cap ? malloc(cap) : NULL;
+    size_t len = 0;
+    if (buf && debounce_capture_export(buf, cap, &len) == ESP_OK)
+    {
+        int msg_id = esp_mqtt_client_publish(mqtt_client, CAPTURE_TOPIC, (const char *)buf,
+                                             (int)len, 1, 0);
+        ESP_LOGI(TAG, "Capture upload: %u bytes, msg_id=%d", (unsigned)len, msg_id);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Capture upload failed");
+    }
+    free(buf);
+    debounce_capture_start(CAPTURE_PINS);
+}
+
+// ---- Logic analyzer over TCP ----
+// Arm a capture of the board pins. The trigger is a hex mask and value over the
+// pins in table order, entered as a pattern; without them it fires at once.
+static void la_arm(const char *args)
+{
+    unsigned mask = 0;
+    unsigned value = 0;
+    if (sscanf(args, "%x %x", &mask, &value) != 2)
+    {
+        mask = value = 0;
+    }
+    const debounce_la_config_t config = {
+        .pins = la_pins,
+        .pin_count = sizeof(la_pins) / sizeof(la_pins[0]),
+        .clock_pin = BOARD_LA_CLOCK_PIN,
+        .sample_hz = LA_SAMPLE_HZ,
+        .trigger_mask = mask,
+        .trigger_value = value,
+        .trigger_edge = true,
+        .pre_samples = LA_PRE_SAMPLES,
+        .post_samples = LA_POST_SAMPLES,
+    };
+    esp_err_t err = debounce_la_arm(&config);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Logic analyzer arm failed: %s", esp_err_to_name(err));
+    }
+}
+
+static esp_err_t la_send(const void *data, size_t len, void *ctx)
+{
+    int sock = *(int *)ctx;
+    const uint8_t *p = data;
+    while (len > 0)
+    {
+        int sent = send(sock, p, len, 0);
+        if (sent < 0)
+        {
+            return ESP_FAIL;
+        }
+        p += sent;
+        len -= (size_t)sent;
+    }
+    return ESP_OK;
+}
+
+// A client connecting to LA_PORT receives the finished capture as written by
+// debounce_la_export(), once the capture running at the time has ended:
+//     nc <device> 9300 > capture.la && tools/la_convert.py capture.la capture.vcd
+static void la_server_task(void *arg)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(LA_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    int listener = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listener, 1) != 0)
+    {
+        ESP_LOGE(TAG, "Logic analyzer server failed on port %d", LA_PORT);
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+        vTaskDelete(NULL);
+        return;
+    }
+    for (;;)
+    {
+        int sock = accept(listener, NULL, NULL);
+        if (sock < 0)
+        {
+            continue;
+        }
+        debounce_la_status_t status;
+        debounce_la_get_status(&status);
+        while (status.state == DEBOUNCE_LA_ARMED || status.state == DEBOUNCE_LA_TRIGGERED)
+        {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            debounce_la_get_status(&status);
+        }
+        esp_err_t err = debounce_la_export(la_send, &sock);
+        ESP_LOGI(TAG, "Logic analyzer download: %s", esp_err_to_name(err));
+        close(sock);
+    }
+}
+
+// Commands on CMD_TOPIC: "capture start", "capture stop", "capture upload",
+// "la arm [<mask> <value>]", "la stop".
+static void handle_command(const char *data, int len)
+{
+    if (len == 13 && memcmp(data, "capture start", 13) == 0)
+    {
+        debounce_capture_start(CAPTURE_PINS);
+    }
+    else if (len == 12 && memcmp(data, "capture stop", 12) == 0)
+    {
+        debounce_capture_stop();
+    }
+    else if (len == 14 && memcmp(data, "capture upload", 14) == 0)
+    {
+        capture_upload();
+    }
+    else if (len >= 6 && len < 64 && memcmp(data, "la arm", 6) == 0)
+    {
+        char args[64];
+        memcpy(args, data + 6, len - 6);
+        args[len - 6] = '\0';
+        la_arm(args);
+    }
+    else if (len == 7 && memcmp(data, "la stop", 7) == 0)
+    {
+        debounce_la_stop();
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Unknown command: %.*s", len, data);
+    }
+}
+
+static void mqtt_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    esp_mqtt_event_handle_t event = event_data;
+    if (event_id == MQTT_EVENT_CONNECTED)
+    {
+        esp_mqtt_client_subscribe(mqtt_client, CMD_TOPIC, 1);
+        xEventGroupSetBits(wifi_event_group, MQTT_CONNECTED_BIT);
+    }
+    else if (event_id == MQTT_EVENT_PUBLISHED)
+    {
+        mqtt_published_id = event->msg_id;
+        xEventGroupSetBits(wifi_event_group, MQTT_PUBLISHED_BIT);
+    }
+    else if (event_id == MQTT_EVENT_DATA && event->topic_len == (int)strlen(CMD_TOPIC) &&
+             memcmp(event->topic, CMD_TOPIC, event->topic_len) == 0)
+    {
+        handle_command(event->data, event->data_len);
+    }
+}
+
+// ---- Low-power mode: ULP monitoring in deep sleep, batched uploads ----
+#if CONFIG_PIN_MONITOR_LOW_POWER
+static const char *wake_name(uint32_t bit)
+{
+    switch (bit)
+    {
+    case DEBOUNCE_ULP_WAKE_WATERMARK:
+        return "watermark";
+    case DEBOUNCE_ULP_WAKE_PRIORITY:
+        return "priority";
+    case DEBOUNCE_ULP_WAKE_LATENCY:
+        return "latency";
+    default:
+        return "heartbeat";
+    }
+}
+
+// Format the queued events as one message on BATCH_TOPIC:
+//     {"wake":["priority"],"lost":0,"events":[[4,0,1520],[5,1,230]]}
+// wake is empty after a cold boot; each event is [gpio, level, ms before upload].
+static char *batch_format(const debounce_ulp_event_t *events, size_t n, uint32_t cause, uint32_t lost)
+{
+    size_t cap = 128 + n * 24;  // Every wake name and a 10-digit lost fit in 128
+    char *msg = malloc(cap);
+    if (!msg)
+    {
+        return NULL;
+    }
+    int len = snprintf(msg, cap, "{\"wake\":[");
+    for (uint32_t bits = cause; bits; bits &= bits - 1)
+    {
+        len += snprintf(msg + len, cap - len, "%s\"%s\"", bits == cause ? "" : ",",
+                        wake_name(bits & -bits));
+    }
+    len += snprintf(msg + len, cap - len, "],\"lost\":%" PRIu32 ",\"events\":[", lost);
+    for (size_t i = 0; i < n; i++)
+    {
+        len += snprintf(msg + len, cap - len, "%s[%d,%d,%" PRIu32 "]", i ? "," : "",
+                        (int)events[i].pin, events[i].level, (uint32_t)(events[i].age_us / 1000));
+    }
+    snprintf(msg + len, cap - len, "]}");
+    return msg;
+}
+
+// Publish the queued events and wait for the broker's ack; only then are they
+// removed from the ULP queue, so a failed upload is retried on the next wake-up.
+static void batch_upload(uint32_t cause)
+{
+    static debounce_ulp_event_t events[PIN_HAL_LP_EVENTS];
+    uint32_t lost = 0;
+    size_t n = debounce_ulp_peek(events, PIN_HAL_LP_EVENTS, &lost);
+    char *msg = batch_format(events, n, cause, lost);
+    if (!msg)
+    {
+        return;
+    }
+    xEventGroupClearBits(wifi_event_group, MQTT_PUBLISHED_BIT);
+    int msg_id = esp_mqtt_client_publish(mqtt_client, BATCH_TOPIC, msg, 0, 1, 0);
+    free(msg);
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(LP_PUBLISH_MS);
+    while (msg_id >= 0 && mqtt_published_id != msg_id)
+    {
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(deadline - now) <= 0)
+        {
+            break;
+        }
+        xEventGroupWaitBits(wifi_event_group, MQTT_PUBLISHED_BIT, true, true, deadline - now);
+    }
+    if (msg_id >= 0 && mqtt_published_id == msg_id)
+    {
+        debounce_ulp_consume(n);
+        ESP_LOGI(TAG, "Batch upload: %u events, %" PRIu32 " lost", (unsigned)n, lost);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Batch upload failed; %u events kept for the next wake-up", (unsigned)n);
+    }
+}
+
+// Every boot of a battery build: resume (or start) ULP monitoring, upload what
+// it queued and go back to deep sleep. Returns only if the ULP cannot monitor
+// the board pins.
+static void low_power_cycle(void)
+{
+    const debounce_ulp_config_t ulp = {
+        .priority_mask = BOARD_ULP_PRIORITY_PINS,
+    };
+    esp_err_t err = debounce_ulp_start(board_pins, DEBOUNCE_TABLE_COUNT(BOARD_PINS), &ulp, NULL);
+    if (err != ESP_OK)
+    {
+        return;
+    }
+    uint32_t cause = debounce_ulp_wake_cause();
+    ESP_LOGI(TAG, "Wake-up cause 0x%" PRIx32, cause);
+
+    if (wifi_init_sta_ext(pdMS_TO_TICKS(LP_CONNECT_MS)))
+    {
+        mqtt_app_start();
+        if (xEventGroupWaitBits(wifi_event_group, MQTT_CONNECTED_BIT, false, true,
+                                pdMS_TO_TICKS(LP_CONNECT_MS)) & MQTT_CONNECTED_BIT)
+        {
+            batch_upload(cause);
+        }
+        else
+        {
+            ESP_LOGW(TAG, "MQTT connection timed out");
+        }
+        esp_mqtt_client_stop(mqtt_client);
+    }
+    esp_wifi_stop();
+    err = debounce_ulp_sleep();
+    ESP_LOGE(TAG, "Deep sleep failed: %s", esp_err_to_name(err));
+    esp_restart();
+}
+#endif
+
 // ---- MQTT setup ----
 void mqtt_app_start(void)
 {
@@ -221,6 +504,7 @@ void mqtt_app_start(void)
         }
     };
     mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
+    esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
     esp_mqtt_client_start(mqtt_client);
 }
 
@@ -269,7 +553,11 @@ void app_main(void)
     else
     {
         ESP_LOGI(TAG, "Wi-Fi credentials found in NVS, starting normal Wi-Fi...");
-        wifi_init_sta_ext(); // Use credentials from NVS
+#if CONFIG_PIN_MONITOR_LOW_POWER
+        low_power_cycle(); // Returns only if the ULP could not be started
+        ESP_LOGW(TAG, "Low-power mode unavailable, monitoring from the main CPU");
+#endif
+        wifi_init_sta_ext(portMAX_DELAY); // Use credentials from NVS
         esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
         if (netif) {
             print_ip_info(netif);
@@ -277,7 +565,7 @@ void app_main(void)
             ESP_LOGW(TAG, "WIFI_STA_DEF netif not found");
         }
         mqtt_app_start(); // Now safe to start MQTT
-        pin_monitor_init(); // start debounce + queue + task
+        pin_monitor_init(); // start debounce + event rings + task
         ESP_LOGI(TAG, "PinMonitor started");
     }
 }
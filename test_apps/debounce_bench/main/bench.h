@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+ * Debounce benchmark: edge traces with known ground truth, the algorithms
+ * under test and the scoring shared by bench_main.c.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BENCH_WINDOW_US    5000  // Target debounce window for every algorithm
+#define BENCH_SAMPLE_US    1000  // Sample period of the sampling algorithms
+#define BENCH_SAMPLES      5     // Agreeing samples the sampling algorithms need
+
+typedef struct {
+    int64_t t_us;
+    uint8_t level;
+} bench_edge_t;
+
+// One recorded or synthetic input with its intended logical transitions.
+typedef struct {
+    const char   *name;
+    bench_edge_t *edges;       // Raw edges, time-ordered, starting from level 0
+    size_t        edge_count;
+    bench_edge_t *truth;       // Intended transitions (time of the first edge)
+    size_t        truth_count;
+    int64_t       duration_us;
+} bench_trace_t;
+
+// Confirmed output of an algorithm.
+typedef struct {
+    bench_edge_t *reports;
+    size_t        count;
+    size_t        capacity;
+} bench_output_t;
+
+// ---- Traces (bench_traces.c) ----
+
+size_t bench_trace_count(void);
+// Build trace i (allocates; release with bench_trace_free()).
+bool   bench_trace_build(size_t i, uint32_t seed, bench_trace_t *out);
+void   bench_trace_free(bench_trace_t *trace);
+
+// ---- Sample-based algorithms run in the bench itself (bench_algos.c) ----
+
+typedef struct {
+    const char *name;
+    size_t      state_bytes;                  // Per-pin state
+    void      (*reset)(void *state, int level);
+    // Feed one raw sample; returns true and sets *level when the output flips.
+    bool      (*step)(void *state, int sample, int *level);
+} bench_sampled_algo_t;
+
+size_t                      bench_sampled_algo_count(void);
+const bench_sampled_algo_t *bench_sampled_algo(size_t i);
+
+// ---- C++ Debouncer template on a manual clock (bench_tpl.cpp) ----
+
+size_t      bench_tpl_algo_count(void);
+const char *bench_tpl_algo_name(size_t i);
+size_t      bench_tpl_state_bytes(void);
+void        bench_tpl_run(size_t i, const bench_trace_t *trace, bench_output_t *out);
+// Same walk over the trace with no engine, for the cost baseline.
+void        bench_tpl_baseline(const bench_trace_t *trace);
+
+// ---- Output recording ----
+
+bool bench_output_push(bench_output_t *out, int64_t t_us, int level);
+void bench_output_free(bench_output_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,82 @@
+/**
+ * Sample-based reference algorithms, fed one raw sample per BENCH_SAMPLE_US.
+ * The interrupt-driven timer engine and the vertical counters are the real
+ * debounce component, driven through the simulated pin_hal backend.
+ */
+
+#include "bench.h"
+
+// Integrator (Kuhn): count towards BENCH_SAMPLES on 1, towards 0 on 0; the
+// output follows only at the rails, so isolated glitches cancel out.
+typedef struct {
+    uint8_t count;
+    uint8_t out;
+} integrator_t;
+
+static void integrator_reset(void *state, int level) {
+    integrator_t *s = state;
+    s->out = (uint8_t)level;
+    s->count = level ? BENCH_SAMPLES : 0;
+}
+
+static bool integrator_step(void *state, int sample, int *level) {
+    integrator_t *s = state;
+    if (sample) {
+        if (s->count < BENCH_SAMPLES) {
+            s->count++;
+        }
+    } else if (s->count > 0) {
+        s->count--;
+    }
+    if (s->count == BENCH_SAMPLES && !s->out) {
+        s->out = 1;
+    } else if (s->count == 0 && s->out) {
+        s->out = 0;
+    } else {
+        return false;
+    }
+    *level = s->out;
+    return true;
+}
+
+// Shift register (Ganssle): flip once the last BENCH_SAMPLES samples all agree.
+typedef struct {
+    uint8_t history;
+    uint8_t out;
+} shift_t;
+
+#define SHIFT_MASK ((uint8_t)((1u << BENCH_SAMPLES) - 1))
+_Static_assert(BENCH_SAMPLES <= 8, "history is one byte");
+
+static void shift_reset(void *state, int level) {
+    shift_t *s = state;
+    s->out = (uint8_t)level;
+    s->history = level ? SHIFT_MASK : 0;
+}
+
+static bool shift_step(void *state, int sample, int *level) {
+    shift_t *s = state;
+    s->history = (uint8_t)(((s->history << 1) | (sample & 1)) & SHIFT_MASK);
+    if (s->history == SHIFT_MASK && !s->out) {
+        s->out = 1;
+    } else if (s->history == 0 && s->out) {
+        s->out = 0;
+    } else {
+        return false;
+    }
+    *level = s->out;
+    return true;
+}
+
+static const bench_sampled_algo_t s_algos[] = {
+    { "integrator",     sizeof(integrator_t), integrator_reset, integrator_step },
+    { "shift_register", sizeof(shift_t),      shift_reset,      shift_step },
+};
+
+size_t bench_sampled_algo_count(void) {
+    return sizeof(s_algos) / sizeof(s_algos[0]);
+}
+
+const bench_sampled_algo_t *bench_sampled_algo(size_t i) {
+    return i < bench_sampled_algo_count() ? &s_algos[i] : NULL;
+}
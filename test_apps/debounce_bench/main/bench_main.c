@@ -0,0 +1,386 @@
+/**
+ * @file bench_main.c
+ * @brief Debounce algorithm benchmark on identical edge traces (linux target).
+ *
+ * The timer engine (trailing and leading policy) and the vertical-counter
+ * sampling engine are the real debounce component, driven through the
+ * simulated pin_hal backend; the C++ Debouncer template runs on a manual
+ * clock (bench_tpl.cpp); the integrator and shift register are reference
+ * implementations in bench_algos.c. Every algorithm sees the same seeded
+ * traces and is scored against their ground truth:
+ *
+ * - detected / false_neg: intended transitions reported / missed. A report
+ *   counts if it has the right level and arrives before the next intended
+ *   transition.
+ * - false_pos: reports matching no intended transition (fp_rate is their
+ *   share of all reports, fn_rate the share of transitions missed).
+ * - latency: report time minus the first edge of the transition.
+ * - cost_per_edge: host CPU per raw edge above a baseline run of the same
+ *   trace without the algorithm (TSC cycles on x86, ns elsewhere).
+ * - mem_bytes: per-pin state on this host (pointers are 8 bytes here).
+ *
+ * Results are printed as CSV and JSON between BENCH_* markers and, if
+ * BENCH_OUT_DIR is set, written to debounce_bench.csv/.json there.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include "esp_log.h"
+
+#include "pin_hal.h"
+#include "pin_sim.h"
+#include "debounce.h"
+#include "private/debounce_internal.h"
+#include "app_shared.h"
+#include "bench.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define COST_UNIT "cycles"
+static inline uint64_t bench_clock(void) {
+    return __rdtsc();
+}
+#else
+#define COST_UNIT "ns"
+static inline uint64_t bench_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+static const char *TAG = "DebounceBench";
+
+#define BENCH_SEED     0xb0bce5u
+#define DRAIN_STEP_US  1000
+#define MAX_RESULTS    32
+
+// Vertical-counter state per sampled pin: level, two counter bits and three
+// mask bits, one bit each in 64-bit words, rounded up to a byte.
+#define VERTICAL_COUNTER_BYTES 1
+
+typedef struct {
+    const char        *name;
+    debounce_engine_t  engine;
+    debounce_policy_t  policy;
+} engine_algo_t;
+
+static const engine_algo_t s_engines[] = {
+    { "timer_trailing",   DEBOUNCE_ENGINE_TIMER,   DEBOUNCE_POLICY_TRAILING },
+    { "timer_leading",    DEBOUNCE_ENGINE_TIMER,   DEBOUNCE_POLICY_LEADING },
+    { "vertical_counter", DEBOUNCE_ENGINE_SAMPLED, DEBOUNCE_POLICY_TRAILING },
+};
+
+typedef struct {
+    const char *algo;
+    const char *trace;
+    size_t      edges;
+    size_t      truth;
+    size_t      detected;
+    size_t      false_pos;
+    size_t      false_neg;
+    double      lat_mean_us;
+    uint32_t    lat_p50_us;
+    uint32_t    lat_p99_us;
+    uint32_t    lat_max_us;
+    double      cost_per_edge;
+    size_t      mem_bytes;
+} bench_result_t;
+
+static bench_result_t s_results[MAX_RESULTS];
+static size_t s_result_count = 0;
+
+bool bench_output_push(bench_output_t *out, int64_t t_us, int level) {
+    if (out->count == out->capacity) {
+        size_t cap = out->capacity ? 2 * out->capacity : 256;
+        bench_edge_t *reports = realloc(out->reports, cap * sizeof(*reports));
+        if (!reports) {
+            return false;
+        }
+        out->reports = reports;
+        out->capacity = cap;
+    }
+    out->reports[out->count++] = (bench_edge_t){ .t_us = t_us, .level = (uint8_t)level };
+    return true;
+}
+
+void bench_output_free(bench_output_t *out) {
+    free(out->reports);
+    memset(out, 0, sizeof(*out));
+}
+
+// ---- Runners ----
+
+// Each engine run gets a pin nobody has driven yet, so it starts at level 0.
+static gpio_num_t next_fresh_pin(void) {
+    static int s_next = 1;
+    while (s_next < GPIO_NUM_MAX && !GPIO_IS_VALID_GPIO(s_next)) {
+        s_next++;
+    }
+    return s_next < GPIO_NUM_MAX ? (gpio_num_t)s_next++ : GPIO_NUM_NC;
+}
+
+/**
+ * Replay a trace on a fresh simulated pin, debounced by the given engine (or
+ * by nothing, for the baseline), and collect its level events. Returns the
+ * host time spent advancing the simulation.
+ */
+static uint64_t run_engine(const bench_trace_t *trace, const engine_algo_t *algo,
+                           bench_output_t *out) {
+    gpio_num_t pin = next_fresh_pin();
+    if (pin == GPIO_NUM_NC) {
+        ESP_LOGE(TAG, "Out of fresh pins");
+        return 0;
+    }
+    if (algo) {
+        debounce_config_t cfg = {
+            .pin = pin,
+            .intr_type = GPIO_INTR_ANYEDGE,
+            .pull_up = false,
+            .debounce_time_us = BENCH_WINDOW_US,
+            .engine = algo->engine,
+            .policy = algo->policy,
+            .state_change_only = true,
+        };
+        if (debounce_register_pin(&cfg) != ESP_OK) {
+            ESP_LOGE(TAG, "Register failed for %s", algo->name);
+            return 0;
+        }
+    }
+
+    int64_t base = pin_sim_now() + DRAIN_STEP_US;
+    for (size_t i = 0; i < trace->edge_count; i++) {
+        (void)pin_sim_schedule(pin, base + trace->edges[i].t_us, trace->edges[i].level);
+    }
+
+    gpio_event_t evt;
+    gpio_event_coalesced_t rec;
+    uint64_t start = bench_clock();
+    while (pin_sim_now() < base + trace->duration_us) {
+        pin_sim_run_until(pin_sim_now() + DRAIN_STEP_US);
+        while (gpio_event_take(&evt)) {
+            if (evt.pin == pin && evt.kind == GPIO_EVENT_LEVEL) {
+                bench_output_push(out, (uint32_t)(evt.confirm_us - (uint32_t)base), evt.level);
+            }
+        }
+        while (gpio_event_coalesce_take(&rec)) {
+            if (rec.pin == pin) {
+                bench_output_push(out, (uint32_t)(rec.last_us - (uint32_t)base), rec.level);
+            }
+        }
+    }
+    uint64_t elapsed = bench_clock() - start;
+
+    if (algo) {
+        (void)debounce_unregister_pin(pin);
+    }
+    return elapsed;
+}
+
+// Feed one raw sample per BENCH_SAMPLE_US to a reference algorithm (or to nothing).
+static uint64_t run_sampled(const bench_trace_t *trace, const bench_sampled_algo_t *algo,
+                            bench_output_t *out) {
+    uint64_t state[2] = {0};
+    volatile int sink = 0;
+    size_t idx = 0;
+    int raw = 0;
+
+    if (algo) {
+        algo->reset(state, 0);
+    }
+    uint64_t start = bench_clock();
+    for (int64_t t = BENCH_SAMPLE_US; t <= trace->duration_us; t += BENCH_SAMPLE_US) {
+        while (idx < trace->edge_count && trace->edges[idx].t_us <= t) {
+            raw = trace->edges[idx++].level;
+        }
+        int level;
+        if (!algo) {
+            sink = raw;
+        } else if (algo->step(state, raw, &level)) {
+            bench_output_push(out, t, level);
+        }
+    }
+    (void)sink;
+    return bench_clock() - start;
+}
+
+// ---- Scoring ----
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void score(const bench_trace_t *trace, const bench_output_t *out, bench_result_t *res) {
+    uint32_t *lat = calloc(trace->truth_count ? trace->truth_count : 1, sizeof(*lat));
+    bool *matched = calloc(trace->truth_count ? trace->truth_count : 1, sizeof(*matched));
+    size_t seg = 0;  // Truth transitions at or before the current report
+    double lat_sum = 0;
+
+    res->edges = trace->edge_count;
+    res->truth = trace->truth_count;
+    for (size_t r = 0; r < out->count; r++) {
+        const bench_edge_t *rep = &out->reports[r];
+        while (seg < trace->truth_count && trace->truth[seg].t_us <= rep->t_us) {
+            seg++;
+        }
+        // Level 0 before the first transition is the trace's idle state, already "reported".
+        size_t cur = seg - 1;
+        if (seg == 0 || matched[cur] || trace->truth[cur].level != rep->level) {
+            res->false_pos++;
+            continue;
+        }
+        matched[cur] = true;
+        lat[res->detected] = (uint32_t)(rep->t_us - trace->truth[cur].t_us);
+        lat_sum += lat[res->detected];
+        res->detected++;
+    }
+    res->false_neg = trace->truth_count - res->detected;
+
+    if (res->detected) {
+        qsort(lat, res->detected, sizeof(*lat), cmp_u32);
+        res->lat_mean_us = lat_sum / res->detected;
+        res->lat_p50_us = lat[(res->detected - 1) * 50 / 100];
+        res->lat_p99_us = lat[(res->detected - 1) * 99 / 100];
+        res->lat_max_us = lat[res->detected - 1];
+    }
+    free(lat);
+    free(matched);
+}
+
+static void add_result(const char *algo, const bench_trace_t *trace, const bench_output_t *out,
+                       uint64_t cost, uint64_t baseline, size_t mem_bytes) {
+    if (s_result_count == MAX_RESULTS) {
+        return;
+    }
+    bench_result_t *res = &s_results[s_result_count++];
+    memset(res, 0, sizeof(*res));
+    res->algo = algo;
+    res->trace = trace->name;
+    res->mem_bytes = mem_bytes;
+    res->cost_per_edge = (cost > baseline && trace->edge_count)
+                         ? (double)(cost - baseline) / trace->edge_count : 0;
+    score(trace, out, res);
+}
+
+// ---- Output ----
+
+static double fp_rate(const bench_result_t *r) {
+    size_t reports = r->detected + r->false_pos;
+    return reports ? (double)r->false_pos / reports : 0;
+}
+
+static double fn_rate(const bench_result_t *r) {
+    return r->truth ? (double)r->false_neg / r->truth : 0;
+}
+
+static void write_csv(FILE *f) {
+    fprintf(f, "algorithm,trace,edges,truth,detected,false_pos,false_neg,fp_rate,fn_rate,"
+               "lat_mean_us,lat_p50_us,lat_p99_us,lat_max_us,cost_per_edge,cost_unit,mem_bytes\n");
+    for (size_t i = 0; i < s_result_count; i++) {
+        const bench_result_t *r = &s_results[i];
+        fprintf(f, "%s,%s,%zu,%zu,%zu,%zu,%zu,%.4f,%.4f,%.1f,%" PRIu32 ",%" PRIu32 ",%" PRIu32
+                   ",%.1f,%s,%zu\n",
+                r->algo, r->trace, r->edges, r->truth, r->detected, r->false_pos, r->false_neg,
+                fp_rate(r), fn_rate(r), r->lat_mean_us, r->lat_p50_us, r->lat_p99_us,
+                r->lat_max_us, r->cost_per_edge, COST_UNIT, r->mem_bytes);
+    }
+}
+
+static void write_json(FILE *f) {
+    fprintf(f, "{\"seed\":%u,\"window_us\":%d,\"sample_us\":%d,\"cost_unit\":\"%s\",\"results\":[",
+            (unsigned)BENCH_SEED, BENCH_WINDOW_US, BENCH_SAMPLE_US, COST_UNIT);
+    for (size_t i = 0; i < s_result_count; i++) {
+        const bench_result_t *r = &s_results[i];
+        fprintf(f, "%s{\"algorithm\":\"%s\",\"trace\":\"%s\",\"edges\":%zu,\"truth\":%zu,"
+                   "\"detected\":%zu,\"false_pos\":%zu,\"false_neg\":%zu,\"fp_rate\":%.4f,"
+                   "\"fn_rate\":%.4f,\"lat_mean_us\":%.1f,\"lat_p50_us\":%" PRIu32
+                   ",\"lat_p99_us\":%" PRIu32 ",\"lat_max_us\":%" PRIu32
+                   ",\"cost_per_edge\":%.1f,\"mem_bytes\":%zu}",
+                i ? "," : "", r->algo, r->trace, r->edges, r->truth, r->detected, r->false_pos,
+                r->false_neg, fp_rate(r), fn_rate(r), r->lat_mean_us, r->lat_p50_us,
+                r->lat_p99_us, r->lat_max_us, r->cost_per_edge, r->mem_bytes);
+    }
+    fprintf(f, "]}\n");
+}
+
+static void write_file(const char *dir, const char *name, void (*writer)(FILE *)) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        ESP_LOGE(TAG, "Cannot write %s", path);
+        return;
+    }
+    writer(f);
+    fclose(f);
+    ESP_LOGI(TAG, "Wrote %s", path);
+}
+
+void app_main(void)
+{
+    esp_log_level_set("Debounce", ESP_LOG_WARN);
+    esp_log_level_set("DebounceSampler", ESP_LOG_WARN);
+    pin_sim_seed(BENCH_SEED);
+    debounce_init();
+
+    for (size_t t = 0; t < bench_trace_count(); t++) {
+        bench_trace_t trace;
+        if (!bench_trace_build(t, BENCH_SEED + (uint32_t)t, &trace)) {
+            ESP_LOGE(TAG, "Failed to build trace %u", (unsigned)t);
+            continue;
+        }
+        bench_output_t out = {0};
+
+        uint64_t baseline = run_engine(&trace, NULL, &out);
+        for (size_t a = 0; a < sizeof(s_engines) / sizeof(s_engines[0]); a++) {
+            out.count = 0;
+            uint64_t cost = run_engine(&trace, &s_engines[a], &out);
+            size_t mem = sizeof(debounce_entry_t) +
+                         (s_engines[a].engine == DEBOUNCE_ENGINE_SAMPLED ? VERTICAL_COUNTER_BYTES : 0);
+            add_result(s_engines[a].name, &trace, &out, cost, baseline, mem);
+        }
+
+        out.count = 0;
+        uint64_t start = bench_clock();
+        bench_tpl_baseline(&trace);
+        baseline = bench_clock() - start;
+        for (size_t a = 0; a < bench_tpl_algo_count(); a++) {
+            out.count = 0;
+            start = bench_clock();
+            bench_tpl_run(a, &trace, &out);
+            uint64_t cost = bench_clock() - start;
+            add_result(bench_tpl_algo_name(a), &trace, &out, cost, baseline, bench_tpl_state_bytes());
+        }
+
+        out.count = 0;
+        baseline = run_sampled(&trace, NULL, &out);
+        for (size_t a = 0; a < bench_sampled_algo_count(); a++) {
+            const bench_sampled_algo_t *algo = bench_sampled_algo(a);
+            out.count = 0;
+            uint64_t cost = run_sampled(&trace, algo, &out);
+            add_result(algo->name, &trace, &out, cost, baseline, algo->state_bytes);
+        }
+
+        bench_output_free(&out);
+        bench_trace_free(&trace);
+    }
+
+    printf("BENCH_CSV_BEGIN\n");
+    write_csv(stdout);
+    printf("BENCH_CSV_END\n");
+    printf("BENCH_JSON_BEGIN\n");
+    write_json(stdout);
+    printf("BENCH_JSON_END\n");
+
+    const char *dir = getenv("BENCH_OUT_DIR");
+    if (dir && *dir) {
+        write_file(dir, "debounce_bench.csv", write_csv);
+        write_file(dir, "debounce_bench.json", write_json);
+    }
+    printf("BENCH done: %u results\n", (unsigned)s_result_count);
+}
@@ -0,0 +1,80 @@
+/**
+ * The C++ Debouncer template (debounce.hpp) on a manual clock: the trace is
+ * replayed as discrete events, jumping straight to each edge or deadline, so
+ * the template runs exactly as it would on target with a perfect tick.
+ */
+
+#include "debounce.hpp"
+#include "bench.h"
+
+namespace {
+
+constexpr gpio_num_t kPin = GPIO_NUM_4;
+
+template <class Policy>
+using Engine = debounce::Debouncer<Policy, debounce::ManualClock, 1>;
+
+template <class Policy>
+void run(const bench_trace_t *trace, bench_output_t *out) {
+    Engine<Policy> engine;
+    auto sink = [out](const debounce::Report &r) {
+        bench_output_push(out, r.confirm_us, r.level);
+    };
+
+    debounce::ManualClock::t_us = 0;
+    engine.add(kPin, BENCH_WINDOW_US, 0);
+    int64_t next = Engine<Policy>::never;
+    for (size_t i = 0; i < trace->edge_count; i++) {
+        const bench_edge_t &e = trace->edges[i];
+        while (next <= e.t_us) {
+            debounce::ManualClock::t_us = next;
+            next = engine.poll(sink);
+        }
+        debounce::ManualClock::t_us = e.t_us;
+        debounce::Report r;
+        if (engine.edge(kPin, e.level, r)) {
+            sink(r);
+        }
+        next = engine.poll(sink);
+    }
+    while (next <= trace->duration_us) {
+        debounce::ManualClock::t_us = next;
+        next = engine.poll(sink);
+    }
+}
+
+struct TplAlgo {
+    const char *name;
+    void      (*run)(const bench_trace_t *, bench_output_t *);
+};
+
+const TplAlgo s_algos[] = {
+    { "tpl_trailing", run<debounce::Trailing> },
+    { "tpl_leading",  run<debounce::Leading> },
+};
+
+} // namespace
+
+extern "C" size_t bench_tpl_algo_count(void) {
+    return sizeof(s_algos) / sizeof(s_algos[0]);
+}
+
+extern "C" const char *bench_tpl_algo_name(size_t i) {
+    return s_algos[i].name;
+}
+
+extern "C" size_t bench_tpl_state_bytes(void) {
+    return sizeof(debounce::Slot);
+}
+
+extern "C" void bench_tpl_run(size_t i, const bench_trace_t *trace, bench_output_t *out) {
+    s_algos[i].run(trace, out);
+}
+
+extern "C" void bench_tpl_baseline(const bench_trace_t *trace) {
+    volatile int sink = 0;
+    for (size_t i = 0; i < trace->edge_count; i++) {
+        sink = trace->edges[i].level;
+    }
+    (void)sink;
+}
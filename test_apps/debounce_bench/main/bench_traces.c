@@ -0,0 +1,188 @@
+/**
+ * Synthetic edge traces with ground truth. Every trace starts at level 0 and
+ * is generated from a seeded xorshift32, so all algorithms see exactly the
+ * same edges on every run.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+typedef struct {
+    bench_edge_t *items;
+    size_t        count;
+    size_t        capacity;
+} edge_vec_t;
+
+static uint32_t s_rng = 1;
+
+static uint32_t rng(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+// Uniform in [lo, hi].
+static int64_t rng_range(int64_t lo, int64_t hi) {
+    return hi > lo ? lo + (int64_t)(rng() % (uint32_t)(hi - lo + 1)) : lo;
+}
+
+static bool vec_push(edge_vec_t *v, int64_t t_us, int level) {
+    if (v->count == v->capacity) {
+        size_t cap = v->capacity ? 2 * v->capacity : 256;
+        bench_edge_t *items = realloc(v->items, cap * sizeof(*items));
+        if (!items) {
+            return false;
+        }
+        v->items = items;
+        v->capacity = cap;
+    }
+    v->items[v->count++] = (bench_edge_t){ .t_us = t_us, .level = (uint8_t)level };
+    return true;
+}
+
+static void sort_offsets(uint32_t *off, size_t n) {
+    for (size_t i = 1; i < n; i++) {
+        uint32_t v = off[i];
+        size_t j = i;
+        while (j > 0 && off[j - 1] > v) {
+            off[j] = off[j - 1];
+            j--;
+        }
+        off[j] = v;
+    }
+}
+
+/**
+ * Mechanical switch: 400 transitions 25 ms apart (+/-500 us jitter), each
+ * followed by 2-10 glitch pairs spread over up to 3 ms.
+ */
+static bool build_mech_bounce(edge_vec_t *edges, edge_vec_t *truth, int64_t *duration_us) {
+    uint32_t off[20];
+    int level = 0;
+    int64_t t = 0;
+
+    for (int i = 0; i < 400; i++) {
+        t = 10000 + (int64_t)i * 25000 + rng_range(-500, 500);
+        level = !level;
+        if (!vec_push(truth, t, level) || !vec_push(edges, t, level)) {
+            return false;
+        }
+        size_t glitches = 2 * (size_t)rng_range(2, 10);
+        uint32_t span = (uint32_t)rng_range(500, 3000);
+        for (size_t g = 0; g < glitches; g++) {
+            off[g] = 1 + rng() % span;
+        }
+        sort_offsets(off, glitches);
+        for (size_t g = 0; g < glitches; g++) {
+            if (!vec_push(edges, t + off[g], (g & 1) ? level : !level)) {
+                return false;
+            }
+        }
+    }
+    *duration_us = t + 50000;
+    return true;
+}
+
+/**
+ * Clean transitions every 100 ms with electrical noise in between: about 20
+ * spikes of 2-40 us per interval, never within 1 ms of a real transition.
+ */
+static bool build_emi_spikes(edge_vec_t *edges, edge_vec_t *truth, int64_t *duration_us) {
+    const int64_t interval_us = 100000;
+    uint32_t starts[32];
+    int level = 0;
+
+    for (int i = 0; i < 100; i++) {
+        int64_t t = 10000 + (int64_t)i * interval_us;
+        if (i > 0) {
+            level = !level;
+            if (!vec_push(truth, t, level) || !vec_push(edges, t, level)) {
+                return false;
+            }
+        }
+        size_t spikes = (size_t)rng_range(10, 30);
+        for (size_t s = 0; s < spikes; s++) {
+            starts[s] = 1000 + rng() % (uint32_t)(interval_us - 2100);
+        }
+        sort_offsets(starts, spikes);
+        int64_t free_from = t + 1000;
+        for (size_t s = 0; s < spikes; s++) {
+            int64_t at = t + starts[s];
+            if (at < free_from) {
+                at = free_from;
+            }
+            int64_t width = rng_range(2, 40);
+            if (!vec_push(edges, at, !level) || !vec_push(edges, at + width, level)) {
+                return false;
+            }
+            free_from = at + width + 1;
+        }
+    }
+    *duration_us = 10000 + 100 * interval_us;
+    return true;
+}
+
+// Clean square wave; every edge is a real transition.
+static bool build_pulse_train(edge_vec_t *edges, edge_vec_t *truth, int64_t *duration_us,
+                              uint32_t half_period_us, int count) {
+    int level = 0;
+    int64_t t = 0;
+    for (int i = 0; i < count; i++) {
+        t = 10000 + (int64_t)i * half_period_us + rng_range(-20, 20);
+        level = !level;
+        if (!vec_push(truth, t, level) || !vec_push(edges, t, level)) {
+            return false;
+        }
+    }
+    *duration_us = t + 50000;
+    return true;
+}
+
+static const char *const s_names[] = {
+    "mech_bounce",
+    "emi_spikes",
+    "pulse_train_slow",  // 50 Hz: above every window, must pass cleanly
+    "pulse_train_fast",  // 200 Hz: half period below the window, must be rejected
+};
+
+size_t bench_trace_count(void) {
+    return sizeof(s_names) / sizeof(s_names[0]);
+}
+
+bool bench_trace_build(size_t i, uint32_t seed, bench_trace_t *out) {
+    edge_vec_t edges = {0};
+    edge_vec_t truth = {0};
+    int64_t duration_us = 0;
+    bool ok = false;
+
+    s_rng = seed ? seed : 1;
+    switch (i) {
+    case 0: ok = build_mech_bounce(&edges, &truth, &duration_us); break;
+    case 1: ok = build_emi_spikes(&edges, &truth, &duration_us); break;
+    case 2: ok = build_pulse_train(&edges, &truth, &duration_us, 10000, 1000); break;
+    case 3: ok = build_pulse_train(&edges, &truth, &duration_us, 2500, 2000); break;
+    default: break;
+    }
+    if (!ok) {
+        free(edges.items);
+        free(truth.items);
+        return false;
+    }
+    *out = (bench_trace_t){
+        .name = s_names[i],
+        .edges = edges.items,
+        .edge_count = edges.count,
+        .truth = truth.items,
+        .truth_count = truth.count,
+        .duration_us = duration_us,
+    };
+    return true;
+}
+
+void bench_trace_free(bench_trace_t *trace) {
+    free(trace->edges);
+    free(trace->truth);
+    memset(trace, 0, sizeof(*trace));
+}
@@ -0,0 +1,40 @@
+# SPDX-License-Identifier: CC0-1.0
+import csv
+import io
+import os
+
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+
+# Leading-edge reporting passes every spike through by design.
+SPIKE_TRANSPARENT = {'timer_leading', 'tpl_leading'}
+
+
+def read_block(dut: IdfDut, name: str) -> str:
+    dut.expect_exact(f'BENCH_{name}_BEGIN', timeout=300)
+    return dut.expect(rf'([\s\S]*?)BENCH_{name}_END', timeout=30).group(1).decode('utf-8').strip()
+
+
+@pytest.mark.linux
+@pytest.mark.host_test
+def test_debounce_bench(dut: IdfDut) -> None:
+    csv_text = read_block(dut, 'CSV')
+    json_text = read_block(dut, 'JSON')
+
+    out_dir = os.environ.get('BENCH_OUT_DIR')
+    if out_dir:
+        os.makedirs(out_dir, exist_ok=True)
+        with open(os.path.join(out_dir, 'debounce_bench.csv'), 'w') as f:
+            f.write(csv_text + '\n')
+        with open(os.path.join(out_dir, 'debounce_bench.json'), 'w') as f:
+            f.write(json_text + '\n')
+
+    rows = list(csv.DictReader(io.StringIO(csv_text)))
+    assert rows, 'no benchmark results'
+    for row in rows:
+        key = f"{row['algorithm']}/{row['trace']}"
+        if row['trace'] in ('mech_bounce', 'pulse_train_slow'):
+            assert int(row['false_neg']) == 0, f'{key} missed transitions'
+            assert int(row['false_pos']) == 0, f'{key} reported bounce'
+        elif row['trace'] == 'emi_spikes' and row['algorithm'] not in SPIKE_TRANSPARENT:
+            assert int(row['false_pos']) == 0, f'{key} reported spikes'
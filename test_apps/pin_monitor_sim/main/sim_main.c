@@ -0,0 +1,1157 @@
+/**
+ * @file sim_main.c
+ * @brief Deterministic host tests of the debounce engine and event pipeline.
+ *
+ * Runs on the linux target against the simulated pin_hal backend. Each
+ * scenario scripts edge waveforms (bounce, jitter, bursts) at microsecond
+ * resolution, advances virtual time while draining the pipeline once per
+ * simulated millisecond, and checks what reached the publish sink. Results
+ * are printed as "SIM <scenario>: PASS|FAIL ..." lines for pytest; the
+ * message hash is stable for a given seed and build configuration.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include "esp_log.h"
+
+#include "pin_hal.h"
+#include "pin_sim.h"
+#include "debounce.h"
+#include "debounce_decoder.h"
+#include "debounce_la.h"
+#include "debounce_ulp.h"
+#include "app_shared.h"
+#include "pin_pipeline.h"
+
+static const char *TAG = "PinMonitorSim";
+
+#define SIM_SEED        0x5eed1234u
+#define DRAIN_STEP_US   1000  // Consumer runs once per simulated millisecond
+#define THROUGHPUT_PINS 8
+#define TRACE_MAX       256
+#define PWM_TRACE_MAX   16
+#define FRAME_TRACE_MAX 8
+#define LA_EDGES_MAX    64
+
+typedef struct {
+    uint32_t events[GPIO_NUM_MAX];     // Level events per pin
+    int8_t   last_level[GPIO_NUM_MAX]; // -1 until the first event
+    uint32_t repeats[GPIO_NUM_MAX];    // Same level reported twice in a row
+    uint32_t coalesced;
+    uint32_t chatter_start;
+    uint32_t chatter_end;
+    uint32_t count_windows;            // Pulse counter windows published
+    uint32_t count_backwards;          // Windows whose total went down
+    uint32_t count_max_delta;
+    uint64_t count_delta_sum;
+    uint64_t count_total;              // Total of the latest window
+    uint32_t position_reports;         // Encoder reports
+    uint32_t position_wrong_way;       // Reports moving against the commanded direction
+    int32_t  position_max_delta;       // Largest move between two reports
+    int32_t  velocity_max;             // Largest speed either way
+    int64_t  position_delta_sum;
+    int64_t  position;                 // Latest position
+    int8_t   position_dir;             // Direction being commanded (+1/-1)
+    uint32_t pwm_count;                // PWM windows published
+    struct {
+        uint32_t cycles;
+        uint32_t period_ns[3];         // min, mean, max
+        uint32_t duty_bp[3];
+        uint8_t  level;
+    } pwm[PWM_TRACE_MAX];
+    uint32_t frame_count;              // Burst frames published
+    struct {
+        char     protocol[12];
+        uint32_t bits;
+        char     data[40];             // Hex, as published
+        uint8_t  valid;
+        uint32_t duration_us;
+    } frame[FRAME_TRACE_MAX];
+    uint32_t hash;                     // FNV-1a over every topic and message
+    uint32_t trace_count;              // Level events in arrival order, all pins
+    struct {
+        uint8_t  pin;
+        uint8_t  level;
+        uint32_t edge_us;
+        uint32_t confirm_us;
+    } trace[TRACE_MAX];
+} sim_recorder_t;
+
+static sim_recorder_t s_rec;
+
+static uint32_t fnv1a(uint32_t hash, const char *s) {
+    while (*s) {
+        hash = (hash ^ (uint8_t)*s++) * 16777619u;
+    }
+    return hash;
+}
+
+static int sim_sink(const char *topic, const char *msg, void *ctx) {
+    sim_recorder_t *rec = (sim_recorder_t *)ctx;
+    int pin;
+    char level[8];
+    uint32_t edge_us = 0;
+    uint32_t confirm_us = 0;
+    uint64_t total = 0;
+    uint32_t delta = 0;
+    int64_t position = 0;
+    int32_t pos_delta = 0;
+    int32_t velocity = 0;
+    uint32_t cycles = 0;
+    uint32_t period[3];
+    uint32_t duty[6];
+    char protocol[12];
+    char data[40];
+    char valid[4];
+    uint32_t bits = 0;
+    uint32_t duration_us = 0;
+
+    rec->hash = fnv1a(fnv1a(rec->hash, topic), msg);
+    if (sscanf(msg, "GPIO %d is now %7s seq=%*u edge_us=%" SCNu32 " confirm_us=%" SCNu32,
+               &pin, level, &edge_us, &confirm_us) >= 2 && pin >= 0 && pin < GPIO_NUM_MAX) {
+        int8_t lvl = (level[0] == 'H');
+        if (rec->trace_count < TRACE_MAX) {
+            rec->trace[rec->trace_count].pin = (uint8_t)pin;
+            rec->trace[rec->trace_count].level = (uint8_t)lvl;
+            rec->trace[rec->trace_count].edge_us = edge_us;
+            rec->trace[rec->trace_count].confirm_us = confirm_us;
+        }
+        rec->trace_count++;
+        if (rec->last_level[pin] == lvl) {
+            rec->repeats[pin]++;
+        }
+        rec->last_level[pin] = lvl;
+        rec->events[pin]++;
+    } else if (sscanf(msg, "GPIO %d count total=%" SCNu64 " delta=%" SCNu32,
+                      &pin, &total, &delta) == 3) {
+        rec->count_backwards += (total < rec->count_total);
+        rec->count_total = total;
+        rec->count_delta_sum += delta;
+        rec->count_max_delta = delta > rec->count_max_delta ? delta : rec->count_max_delta;
+        rec->count_windows++;
+    } else if (sscanf(msg, "GPIO %d position=%" SCNd64 " delta=%" SCNd32 " velocity=%" SCNd32,
+                      &pin, &position, &pos_delta, &velocity) == 4) {
+        rec->position_wrong_way += (pos_delta * rec->position_dir < 0);
+        pos_delta = pos_delta < 0 ? -pos_delta : pos_delta;
+        velocity = velocity < 0 ? -velocity : velocity;
+        rec->position_max_delta = pos_delta > rec->position_max_delta ? pos_delta
+                                                                      : rec->position_max_delta;
+        rec->velocity_max = velocity > rec->velocity_max ? velocity : rec->velocity_max;
+        rec->position_delta_sum += position - rec->position;
+        rec->position = position;
+        rec->position_reports++;
+    } else if (sscanf(msg, "GPIO %d pwm cycles=%" SCNu32 " period_ns=%" SCNu32 "/%" SCNu32
+                      "/%" SCNu32 " high_ns=%*u/%*u/%*u duty=%" SCNu32 ".%" SCNu32 "/%" SCNu32
+                      ".%" SCNu32 "/%" SCNu32 ".%" SCNu32 "%% level=%7s",
+                      &pin, &cycles, &period[0], &period[1], &period[2], &duty[0], &duty[1],
+                      &duty[2], &duty[3], &duty[4], &duty[5], level) == 12) {
+        if (rec->pwm_count < PWM_TRACE_MAX) {
+            rec->pwm[rec->pwm_count].cycles = cycles;
+            for (int i = 0; i < 3; i++) {
+                rec->pwm[rec->pwm_count].period_ns[i] = period[i];
+                rec->pwm[rec->pwm_count].duty_bp[i] = duty[2 * i] * 100 + duty[2 * i + 1];
+            }
+            rec->pwm[rec->pwm_count].level = (level[0] == 'H');
+        }
+        rec->pwm_count++;
+    } else if (sscanf(msg, "GPIO %d frame protocol=%11s bits=%" SCNu32 " data=%39s valid=%3s"
+                      " duration_us=%" SCNu32, &pin, protocol, &bits, data, valid,
+                      &duration_us) == 6) {
+        if (rec->frame_count < FRAME_TRACE_MAX) {
+            strcpy(rec->frame[rec->frame_count].protocol, protocol);
+            strcpy(rec->frame[rec->frame_count].data, data);
+            rec->frame[rec->frame_count].bits = bits;
+            rec->frame[rec->frame_count].valid = (valid[0] == 'y');
+            rec->frame[rec->frame_count].duration_us = duration_us;
+        }
+        rec->frame_count++;
+    } else if (strstr(msg, "chatter start")) {
+        rec->chatter_start++;
+    } else if (strstr(msg, "chatter end")) {
+        rec->chatter_end++;
+    } else if (strstr(msg, "transitions, final level")) {
+        rec->coalesced++;
+    }
+    return 0;
+}
+
+static void recorder_reset(void) {
+    uint32_t hash = s_rec.hash; // Accumulates across scenarios
+    memset(&s_rec, 0, sizeof(s_rec));
+    memset(s_rec.last_level, -1, sizeof(s_rec.last_level));
+    s_rec.hash = hash;
+    gpio_stats_reset();
+    gpio_latency_reset();
+}
+
+// Advance virtual time, letting the consumer drain the rings every step.
+static void run_until(int64_t t_us) {
+    while (pin_sim_now() < t_us) {
+        int64_t step = pin_sim_now() + DRAIN_STEP_US;
+        pin_sim_run_until(step < t_us ? step : t_us);
+        (void)pin_pipeline_drain();
+    }
+}
+
+static uint32_t stage_count(const gpio_stats_snapshot_t *snap, gpio_stage_stat_t stat) {
+    return snap->stage[stat];
+}
+
+static bool report(const char *name, bool pass, const char *detail) {
+    printf("SIM %s: %s %s\n", name, pass ? "PASS" : "FAIL", detail);
+    return pass;
+}
+
+static esp_err_t register_pin(gpio_num_t pin, uint32_t window_us, debounce_policy_t policy,
+                              bool pull_up, bool changes_only) {
+    debounce_config_t cfg = {
+        .pin = pin,
+        .intr_type = GPIO_INTR_ANYEDGE,
+        .pull_up = pull_up,
+        .debounce_time_us = window_us,
+        .mqtt_topic = NULL,
+        .policy = policy,
+        .state_change_only = changes_only,
+    };
+    return debounce_register_pin(&cfg);
+}
+
+/**
+ * Bouncy push button with the trailing policy: every press and release must
+ * come out as exactly one event, confirmed one window after the bounce ends.
+ */
+static bool scenario_trailing_bounce(void) {
+    const gpio_num_t pin = GPIO_NUM_4;
+    const uint32_t window_us = 5000;
+    const pin_sim_bounce_t shape = { .bounces = 6, .bounce_us = 2000, .jitter_us = 300 };
+    const int cycles = 20;
+    char detail[160];
+
+    recorder_reset();
+    if (register_pin(pin, window_us, DEBOUNCE_POLICY_TRAILING, true, false) != ESP_OK) {
+        return report("trailing_bounce", false, "register failed");
+    }
+    int64_t t0 = pin_sim_now() + 10000;
+    for (int i = 0; i < cycles; i++) {
+        pin_sim_transition(pin, t0 + i * 40000, 0, &shape);
+        pin_sim_transition(pin, t0 + i * 40000 + 20000, 1, &shape);
+    }
+    run_until(t0 + cycles * 40000 + 20000);
+
+    gpio_latency_summary_t confirm = {0};
+    (void)gpio_latency_summary(pin, GPIO_LAT_STAGE_CONFIRM, &confirm);
+    (void)debounce_unregister_pin(pin);
+
+    // Confirm = bounce span + window, rounded up to the wheel tick.
+    uint32_t max_confirm = shape.bounce_us + window_us + 2 * CONFIG_DEBOUNCE_WHEEL_TICK_US;
+    bool pass = s_rec.events[pin] == 2 * cycles && s_rec.repeats[pin] == 0 &&
+                s_rec.last_level[pin] == 1 &&
+                (!CONFIG_APP_LATENCY_HIST ||
+                 (confirm.p50_us >= window_us && confirm.max_us <= max_confirm));
+    snprintf(detail, sizeof(detail),
+             "events=%" PRIu32 "/%d repeats=%" PRIu32 " confirm_p50=%" PRIu32 "us max=%" PRIu32 "us",
+             s_rec.events[pin], 2 * cycles, s_rec.repeats[pin], confirm.p50_us, confirm.max_us);
+    return report("trailing_bounce", pass, detail);
+}
+
+/**
+ * Leading-edge policy: the press is reported from the first edge with no
+ * added latency, and the bounce behind it is locked out.
+ */
+static bool scenario_leading_edge(void) {
+    const gpio_num_t pin = GPIO_NUM_5;
+    const pin_sim_bounce_t shape = { .bounces = 4, .bounce_us = 1500, .jitter_us = 200 };
+    const int cycles = 10;
+    char detail[160];
+
+    recorder_reset();
+    if (register_pin(pin, 20000, DEBOUNCE_POLICY_LEADING, true, true) != ESP_OK) {
+        return report("leading_edge", false, "register failed");
+    }
+    int64_t t0 = pin_sim_now() + 10000;
+    for (int i = 0; i < cycles; i++) {
+        pin_sim_transition(pin, t0 + i * 60000, 0, &shape);
+        pin_sim_transition(pin, t0 + i * 60000 + 30000, 1, &shape);
+    }
+    run_until(t0 + cycles * 60000 + 30000);
+
+    gpio_latency_summary_t confirm = {0};
+    (void)gpio_latency_summary(pin, GPIO_LAT_STAGE_CONFIRM, &confirm);
+    (void)debounce_unregister_pin(pin);
+
+    bool pass = s_rec.events[pin] == 2 * cycles && s_rec.repeats[pin] == 0 &&
+                (!CONFIG_APP_LATENCY_HIST || confirm.max_us == 0);
+    snprintf(detail, sizeof(detail),
+             "events=%" PRIu32 "/%d repeats=%" PRIu32 " confirm_max=%" PRIu32 "us",
+             s_rec.events[pin], 2 * cycles, s_rec.repeats[pin], confirm.max_us);
+    return report("leading_edge", pass, detail);
+}
+
+/**
+ * Several pins toggling with staggered, jittered clean edges. Nothing may be
+ * dropped or coalesced at this rate; prints simulated event rate, the
+ * end-to-end p99 and how long the host took.
+ */
+static bool scenario_throughput(void) {
+    const int transitions = 400;
+    const uint32_t period_us = 2500;
+    const pin_sim_bounce_t shape = { .jitter_us = 50 };
+    static gpio_stats_snapshot_t snap;
+    char detail[192];
+
+    recorder_reset();
+    debounce_config_t cfgs[THROUGHPUT_PINS];
+    for (int i = 0; i < THROUGHPUT_PINS; i++) {
+        cfgs[i] = (debounce_config_t){
+            .pin = (gpio_num_t)(6 + i),
+            .intr_type = GPIO_INTR_ANYEDGE,
+            .debounce_time_us = 1000,
+        };
+    }
+    // Registered as one table: a single GPIO configuration for all pins.
+    if (debounce_register_pins(cfgs, THROUGHPUT_PINS) != ESP_OK) {
+        return report("throughput", false, "register failed");
+    }
+    int64_t t0 = pin_sim_now() + 10000;
+    for (int n = 0; n < transitions; n++) {
+        for (int i = 0; i < THROUGHPUT_PINS; i++) {
+            pin_sim_transition((gpio_num_t)(6 + i), t0 + (int64_t)n * period_us + i * 150,
+                               !(n & 1), &shape);
+        }
+    }
+    int64_t t_end = t0 + (int64_t)transitions * period_us + 10000;
+
+    clock_t host_start = clock();
+    run_until(t_end);
+    double host_ms = (double)(clock() - host_start) * 1000.0 / CLOCKS_PER_SEC;
+
+    uint32_t events = 0;
+    uint32_t p99_total = 0;
+    bool per_pin_ok = true;
+    for (int i = 0; i < THROUGHPUT_PINS; i++) {
+        gpio_latency_summary_t total = {0};
+        events += s_rec.events[6 + i];
+        per_pin_ok &= (s_rec.events[6 + i] == (uint32_t)transitions && s_rec.repeats[6 + i] == 0);
+        if (gpio_latency_summary(6 + i, GPIO_LAT_STAGE_TOTAL, &total) && total.p99_us > p99_total) {
+            p99_total = total.p99_us;
+        }
+        (void)debounce_unregister_pin((gpio_num_t)(6 + i));
+    }
+    gpio_stats_snapshot(&snap, false);
+
+    double sim_s = (double)(t_end - t0) / 1e6;
+    bool pass = per_pin_ok && s_rec.coalesced == 0 &&
+                stage_count(&snap, GPIO_STAGE_STAT_DROPPED) == 0 &&
+                stage_count(&snap, GPIO_STAGE_STAT_COALESCED) == 0;
+    snprintf(detail, sizeof(detail),
+             "events=%" PRIu32 "/%d rate=%.0f/s p99_total=%" PRIu32 "us dropped=%" PRIu32
+             " host_ms=%.1f",
+             events, transitions * THROUGHPUT_PINS, events / sim_s, p99_total,
+             stage_count(&snap, GPIO_STAGE_STAT_DROPPED), host_ms);
+    return report("throughput", pass, detail);
+}
+
+/**
+ * A pin toggling far above the chatter limit gets its interrupt switched off,
+ * reports chatter start/end once each and settles on its final level.
+ */
+static bool scenario_chatter(void) {
+#if CONFIG_DEBOUNCE_CHATTER_MODERATION
+    const gpio_num_t pin = GPIO_NUM_14;
+    char detail[160];
+
+    recorder_reset();
+    if (register_pin(pin, 5000, DEBOUNCE_POLICY_TRAILING, true, false) != ESP_OK) {
+        return report("chatter", false, "register failed");
+    }
+    int64_t t0 = pin_sim_now() + 10000;
+    // Four times the edge limit per window, for three windows.
+    uint32_t edges = 12 * CONFIG_DEBOUNCE_CHATTER_MAX_EDGES;
+    uint32_t half_period_us = CONFIG_DEBOUNCE_CHATTER_WINDOW_MS * 1000 /
+                              (4 * CONFIG_DEBOUNCE_CHATTER_MAX_EDGES);
+    int64_t t_last = pin_sim_burst(pin, t0, half_period_us ? half_period_us : 1, edges | 1, 10);
+    int settled = pin_sim_final_level(pin);
+    run_until(t_last + (int64_t)(CONFIG_DEBOUNCE_CHATTER_CALM_POLLS + 5) *
+                           CONFIG_DEBOUNCE_CHATTER_POLL_MS * 1000);
+    (void)debounce_unregister_pin(pin);
+
+    bool pass = s_rec.chatter_start == 1 && s_rec.chatter_end == 1 &&
+                s_rec.last_level[pin] == settled;
+    snprintf(detail, sizeof(detail), "start=%" PRIu32 " end=%" PRIu32 " level=%d/%d",
+             s_rec.chatter_start, s_rec.chatter_end, s_rec.last_level[pin], settled);
+    return report("chatter", pass, detail);
+#else
+    return report("chatter", true, "skipped (moderation disabled)");
+#endif
+}
+
+/**
+ * A 2.5 kHz pulse train on a pulse counter pin, long enough to wrap the
+ * counter twice, with zero-width glitches mixed in: the glitches are
+ * filtered out, every window is reported and the windows add up to the
+ * 64-bit total, which matches the rising edges exactly.
+ */
+static bool scenario_pulse_count(void) {
+#if CONFIG_DEBOUNCE_PCNT
+    const gpio_num_t pin = GPIO_NUM_6;
+    const uint32_t half_period_us = 200;
+    const uint32_t window_ms = 100;
+    const uint32_t chunk_edges = 50000;  // Keeps each chunk within the edge queue
+    const int chunks = 3;
+    char detail[160];
+
+    debounce_config_t cfg = {
+        .pin = pin,
+        .intr_type = GPIO_INTR_POSEDGE,
+        .engine = DEBOUNCE_ENGINE_PCNT,
+        .count_window_ms = window_ms,
+        .glitch_ns = 1000,
+    };
+    recorder_reset();
+    int64_t t_start = pin_sim_now();
+    if (debounce_register_pin(&cfg) != ESP_OK) {
+        return report("pulse_count", false, "register failed");
+    }
+    uint32_t glitches = 0;
+    int64_t t = t_start + 1000;
+    for (int c = 0; c < chunks; c++) {
+        // The pin starts each chunk LOW, so odd half periods are LOW too.
+        int64_t t_last = pin_sim_burst(pin, t, half_period_us, chunk_edges, 0);
+        for (uint32_t k = 1; k < chunk_edges; k += 500) {
+            int64_t at = t + (int64_t)k * half_period_us + half_period_us / 2;
+            pin_sim_schedule(pin, at, 1);
+            pin_sim_schedule(pin, at, 0);
+            glitches++;
+        }
+        run_until(t_last + half_period_us);
+        t = t_last + 2 * half_period_us;
+    }
+    run_until(t + 2 * window_ms * 1000);
+    (void)debounce_unregister_pin(pin);
+
+    uint64_t expected = (uint64_t)chunks * chunk_edges / 2;
+    uint32_t windows = (uint32_t)((pin_sim_now() - t_start) / (window_ms * 1000));
+    uint32_t per_window = window_ms * 1000 / (2 * half_period_us);
+    bool pass = s_rec.count_total == expected && s_rec.count_delta_sum == expected &&
+                s_rec.count_backwards == 0 && s_rec.count_windows == windows &&
+                s_rec.count_max_delta <= per_window + 1;
+    snprintf(detail, sizeof(detail),
+             "total=%" PRIu64 "/%" PRIu64 " windows=%" PRIu32 "/%" PRIu32
+             " max_delta=%" PRIu32 " glitches=%" PRIu32,
+             s_rec.count_total, expected, s_rec.count_windows, windows,
+             s_rec.count_max_delta, glitches);
+    return report("pulse_count", pass, detail);
+#else
+    return report("pulse_count", true, "skipped (pulse counter disabled)");
+#endif
+}
+
+// Encoder outputs per quadrature phase, (B << 1) | A, A leading when going up.
+static const uint8_t s_quadrature[4] = { 0, 1, 3, 2 };
+
+// Schedule quadrature steps (negative: backwards) from t, one every step_us,
+// continuing from *phase. Returns the time of the last step.
+static int64_t encoder_steps(gpio_num_t a, gpio_num_t b, int64_t t, int32_t steps,
+                             uint32_t step_us, int *phase) {
+    int dir = steps < 0 ? -1 : 1;
+    for (int32_t n = 0; n < steps * dir; n++, t += step_us) {
+        uint8_t from = s_quadrature[*phase & 3];
+        *phase += dir;
+        uint8_t to = s_quadrature[*phase & 3];
+        if ((from ^ to) & 1) {
+            pin_sim_schedule(a, t, to & 1);
+        } else {
+            pin_sim_schedule(b, t, to >> 1);
+        }
+    }
+    return t - step_us;
+}
+
+/**
+ * An encoder turning 40000 counts forward and 80000 back at 50k counts/s,
+ * wrapping the counter both ways, with glitches on A: every report moves the
+ * commanded way by about the threshold, and the reports add up to the
+ * 64-bit position, which ends exactly at -40000.
+ */
+static bool scenario_encoder(void) {
+#if CONFIG_DEBOUNCE_PCNT
+    const gpio_num_t a = GPIO_NUM_7;
+    const gpio_num_t b = GPIO_NUM_8;
+    const uint32_t step_us = 20;
+    const uint32_t threshold = 1000;
+    static const int32_t moves[] = { 40000, -40000, -40000 }; // Within the edge queue each
+    char detail[192];
+
+    debounce_config_t cfg = {
+        .pin = a,
+        .engine = DEBOUNCE_ENGINE_ENCODER,
+        .encoder_b_pin = b,
+        .encoder_threshold = threshold,
+        .count_window_ms = 200,
+        .glitch_ns = 1000,
+    };
+    recorder_reset();
+    if (debounce_register_pin(&cfg) != ESP_OK) {
+        return report("encoder", false, "register failed");
+    }
+    cfg.pin = b;
+    bool b_refused = (debounce_register_pin(&cfg) == ESP_ERR_INVALID_STATE);
+    // A config that leaves encoder_b_pin out does not get GPIO 0.
+    debounce_config_t no_b = { .pin = GPIO_NUM_47, .engine = DEBOUNCE_ENGINE_ENCODER };
+    b_refused = b_refused && debounce_register_pin(&no_b) == ESP_ERR_INVALID_ARG;
+
+    int phase = 0;
+    int64_t expected = 0;
+    int64_t t = pin_sim_now() + 1000;
+    for (size_t m = 0; m < sizeof(moves) / sizeof(moves[0]); m++) {
+        int dir = moves[m] < 0 ? -1 : 1;
+        int start_phase = phase;
+        s_rec.position_dir = (int8_t)dir;
+        int64_t t_last = encoder_steps(a, b, t, moves[m], step_us, &phase);
+        // Zero-width glitches on A halfway between steps k and k + 1.
+        for (int32_t k = 0; k < 40; k++) {
+            int64_t at = t + (int64_t)k * 997 * step_us + step_us / 2;
+            int level = s_quadrature[(start_phase + dir * (k * 997 + 1)) & 3] & 1;
+            pin_sim_schedule(a, at, !level);
+            pin_sim_schedule(a, at, level);
+        }
+        expected += moves[m];
+        run_until(t_last + step_us);
+        t = t_last + 1000;
+    }
+    run_until(t + 400000);
+    (void)debounce_unregister_pin(a);
+
+    // An undriven B input floats to its pull-up while the encoder owns it, and
+    // not once it is unregistered.
+    cfg.pin = GPIO_NUM_47;
+    cfg.encoder_b_pin = GPIO_NUM_48;
+    cfg.pull_up = true;
+    bool b_pulled = debounce_register_pin(&cfg) == ESP_OK &&
+                    ((pin_hal_read_levels() >> GPIO_NUM_48) & 1);
+    (void)debounce_unregister_pin(GPIO_NUM_47);
+    bool b_released = b_pulled && !((pin_hal_read_levels() >> GPIO_NUM_48) & 1);
+
+    int32_t speed = (int32_t)(1000000 / step_us);
+    uint32_t poll_counts = CONFIG_DEBOUNCE_ENCODER_POLL_MS * 1000 / step_us;
+    bool pass = b_refused && b_released && s_rec.position == expected && s_rec.position_delta_sum == expected &&
+                s_rec.position_wrong_way == 0 &&
+                s_rec.position_max_delta <= (int32_t)(threshold + poll_counts) &&
+                s_rec.velocity_max >= speed * 9 / 10 && s_rec.velocity_max <= speed;
+    snprintf(detail, sizeof(detail),
+             "position=%" PRId64 "/%" PRId64 " reports=%" PRIu32 " max_delta=%" PRId32
+             " velocity_max=%" PRId32 " wrong_way=%" PRIu32 " b_refused=%d b_released=%d",
+             s_rec.position, expected, s_rec.position_reports, s_rec.position_max_delta,
+             s_rec.velocity_max, s_rec.position_wrong_way, b_refused, b_released);
+    return report("encoder", pass, detail);
+#else
+    return report("encoder", true, "skipped (pulse counter disabled)");
+#endif
+}
+
+// Schedule a PWM signal from t: cycles of period_us, high for high_us, each
+// edge moved by a repeatable -2..+2us. Returns the time of the closing rise.
+static int64_t pwm_cycles(gpio_num_t pin, int64_t t, uint32_t cycles, uint32_t period_us,
+                          uint32_t high_us) {
+    for (uint32_t k = 0; k < cycles; k++, t += period_us) {
+        pin_sim_schedule(pin, t + (int32_t)(k * 7 % 5) - 2, 1);
+        pin_sim_schedule(pin, t + high_us + (int32_t)(k * 3 % 5) - 2, 0);
+    }
+    return pin_sim_schedule(pin, t, 1);
+}
+
+// Period and duty figures of a window match a signal within the edge jitter.
+static bool pwm_window_ok(int w, uint32_t period_us, uint32_t duty_bp) {
+    const uint32_t period_ns = period_us * 1000;
+    const uint32_t duty_tol = 4 * 10000 / period_us;  // 4us either way
+    return s_rec.pwm[w].cycles == 100000 / period_us &&
+           s_rec.pwm[w].period_ns[0] >= period_ns - 4000 &&
+           s_rec.pwm[w].period_ns[2] <= period_ns + 4000 &&
+           s_rec.pwm[w].period_ns[1] + 100 >= period_ns &&
+           s_rec.pwm[w].period_ns[1] <= period_ns + 100 &&
+           s_rec.pwm[w].duty_bp[0] + duty_tol >= duty_bp &&
+           s_rec.pwm[w].duty_bp[2] <= duty_bp + duty_tol &&
+           s_rec.pwm[w].duty_bp[1] + 20 >= duty_bp && s_rec.pwm[w].duty_bp[1] <= duty_bp + 20;
+}
+
+/**
+ * A PWM line at 1 kHz / 25% then 2 kHz / 60%, with a few microseconds of edge
+ * jitter, then stuck HIGH, in 100 ms windows: whole windows of each signal
+ * report its period and duty within the jitter, and the stuck windows report
+ * no cycles at a duty of 100%.
+ */
+static bool scenario_pwm_capture(void) {
+#if CONFIG_DEBOUNCE_PWM
+    const gpio_num_t pin = GPIO_NUM_9;
+    char detail[192];
+
+    debounce_config_t cfg = {
+        .pin = pin,
+        .engine = DEBOUNCE_ENGINE_PWM,
+        .count_window_ms = 100,
+    };
+    recorder_reset();
+    int64_t t = pin_sim_now();
+    if (debounce_register_pin(&cfg) != ESP_OK) {
+        return report("pwm_capture", false, "register failed");
+    }
+    t = pwm_cycles(pin, t + 1000, 300, 1000, 250);
+    t = pwm_cycles(pin, t, 600, 500, 300);
+    run_until(t + 500000);
+    (void)debounce_unregister_pin(pin);
+
+    // Windows 1-2: first signal, 4-5: second, 7-10: stuck HIGH; the others straddle.
+    bool pass = s_rec.pwm_count >= 11 && s_rec.pwm_count <= PWM_TRACE_MAX;
+    for (int w = 1; pass && w < 3; w++) {
+        pass = pwm_window_ok(w, 1000, 2500);
+    }
+    for (int w = 4; pass && w < 6; w++) {
+        pass = pwm_window_ok(w, 500, 6000);
+    }
+    for (int w = 7; pass && w < 11; w++) {
+        pass = s_rec.pwm[w].cycles == 0 && s_rec.pwm[w].level && s_rec.pwm[w].duty_bp[1] == 10000;
+    }
+    snprintf(detail, sizeof(detail),
+             "windows=%" PRIu32 " w1=%" PRIu32 "c/%" PRIu32 "ns/%" PRIu32 "bp w5=%" PRIu32
+             "c/%" PRIu32 "ns/%" PRIu32 "bp w8=%" PRIu32 "c/%" PRIu32 "bp",
+             s_rec.pwm_count, s_rec.pwm[1].cycles, s_rec.pwm[1].period_ns[1],
+             s_rec.pwm[1].duty_bp[1], s_rec.pwm[5].cycles, s_rec.pwm[5].period_ns[1],
+             s_rec.pwm[5].duty_bp[1], s_rec.pwm[8].cycles, s_rec.pwm[8].duty_bp[1]);
+    return report("pwm_capture", pass, detail);
+#else
+    return report("pwm_capture", true, "skipped (PWM capture disabled)");
+#endif
+}
+
+// Wiegand: 50us low pulse on D0 (0) or D1 (1) every 2ms, MSB first.
+static int64_t wiegand_frame(gpio_num_t d0, gpio_num_t d1, int64_t t, uint32_t word,
+                             unsigned bits) {
+    for (unsigned i = 0; i < bits; i++, t += 2000) {
+        gpio_num_t pin = (word >> (bits - 1 - i)) & 1 ? d1 : d0;
+        pin_sim_schedule(pin, t, 0);
+        pin_sim_schedule(pin, t + 50, 1);
+    }
+    return t;
+}
+
+// 26-bit Wiegand word for a 24-bit payload: even parity, payload, odd parity.
+static uint32_t wiegand26(uint32_t payload) {
+    uint32_t lead = __builtin_popcount(payload >> 12) & 1;
+    uint32_t trail = !(__builtin_popcount(payload & 0xfff) & 1);
+    return lead << 25 | payload << 1 | trail;
+}
+
+// NEC from an active-low receiver; repeat sends the repeat code instead.
+static int64_t nec_frame(gpio_num_t pin, int64_t t, uint8_t addr, uint8_t cmd, bool repeat) {
+    uint32_t word = addr | (uint32_t)(uint8_t)~addr << 8 | (uint32_t)cmd << 16 |
+                    (uint32_t)(uint8_t)~cmd << 24;
+    pin_sim_schedule(pin, t, 0);
+    pin_sim_schedule(pin, t + 9000, 1);
+    t += repeat ? 11250 : 13500;
+    for (unsigned i = 0; !repeat && i < 32; i++) {
+        pin_sim_schedule(pin, t, 0);
+        pin_sim_schedule(pin, t + 560, 1);
+        t += (word >> i) & 1 ? 2250 : 1120;
+    }
+    pin_sim_schedule(pin, t, 0);
+    return pin_sim_schedule(pin, t + 560, 1);
+}
+
+/**
+ * A Wiegand reader on two lines and an IR receiver, both received as RMT
+ * bursts: a 26-bit read whose D1 pulses are split into two bursts by a long
+ * run of zeros, with a zero-width glitch on D0; the same read with its odd
+ * parity bit flipped; an NEC code and its repeat. Every frame comes out once
+ * with its payload and verdict, and the Wiegand D1 pin cannot be registered.
+ */
+static bool scenario_burst_decode(void) {
+#if CONFIG_DEBOUNCE_BURST
+    const gpio_num_t d0 = GPIO_NUM_19;
+    const gpio_num_t d1 = GPIO_NUM_20;
+    const gpio_num_t ir = GPIO_NUM_21;
+    const uint32_t payload = 0x80003f; // Facility 0x80, card 63: 17 zeros in a row
+    char detail[192];
+    char expected[16];
+
+    debounce_config_t reader = {
+        .pin = d0,
+        .pull_up = true,
+        .engine = DEBOUNCE_ENGINE_BURST,
+        .decoder = &debounce_decoder_wiegand,
+        .burst_b_pin = d1,
+    };
+    debounce_config_t remote = {
+        .pin = ir,
+        .pull_up = true,
+        .engine = DEBOUNCE_ENGINE_BURST,
+        .decoder = &debounce_decoder_nec,
+    };
+    recorder_reset();
+    if (debounce_register_pin(&reader) != ESP_OK || debounce_register_pin(&remote) != ESP_OK) {
+        return report("burst_decode", false, "register failed");
+    }
+    bool b_refused = (register_pin(d1, 1000, DEBOUNCE_POLICY_TRAILING, true, false) ==
+                      ESP_ERR_INVALID_STATE);
+
+    // A second reader gets the last receive channel for D0 but none for D1;
+    // its undriven D1 must not keep the pull-up, then or after an unregister.
+    debounce_config_t spare = reader;
+    spare.pin = GPIO_NUM_45;
+    spare.burst_b_pin = GPIO_NUM_46;
+    bool b_released = debounce_register_pin(&spare) == ESP_ERR_NOT_FOUND &&
+                      !((pin_hal_read_levels() >> GPIO_NUM_46) & 1);
+
+    uint32_t word = wiegand26(payload);
+    int64_t t = pin_sim_now() + 1000;
+    wiegand_frame(d0, d1, t, word, 26);
+    pin_sim_schedule(d0, t + 21001, 0);
+    pin_sim_schedule(d0, t + 21001, 1);
+    wiegand_frame(d0, d1, t + 300000, word ^ 1, 26);
+    int64_t nec = nec_frame(ir, t + 600000, 0x04, 0x08, false);
+    nec_frame(ir, t + 708000, 0x04, 0x08, true);
+    run_until(nec + 400000);
+    (void)debounce_unregister_pin(d0);
+    (void)debounce_unregister_pin(ir);
+    b_released = b_released && debounce_register_pin(&spare) == ESP_OK &&
+                 ((pin_hal_read_levels() >> GPIO_NUM_46) & 1);
+    (void)debounce_unregister_pin(GPIO_NUM_45);
+    b_released = b_released && !((pin_hal_read_levels() >> GPIO_NUM_46) & 1);
+
+    snprintf(expected, sizeof(expected), "%08" PRIx32, word << 6);
+    bool pass = b_refused && b_released && s_rec.frame_count == 4 &&
+                !strcmp(s_rec.frame[0].protocol, "wiegand") && s_rec.frame[0].bits == 26 &&
+                !strcmp(s_rec.frame[0].data, expected) && s_rec.frame[0].valid &&
+                s_rec.frame[0].duration_us == 25 * 2000 + 50 &&
+                s_rec.frame[1].bits == 26 && !s_rec.frame[1].valid &&
+                !strcmp(s_rec.frame[2].protocol, "nec") && s_rec.frame[2].bits == 32 &&
+                !strcmp(s_rec.frame[2].data, "04fb08f7") && s_rec.frame[2].valid &&
+                s_rec.frame[3].bits == 0 && !strcmp(s_rec.frame[3].data, "-") &&
+                s_rec.frame[3].valid;
+    snprintf(detail, sizeof(detail),
+             "frames=%" PRIu32 " wiegand=%s/%" PRIu32 "/%s/%" PRIu32 "us bad_parity_valid=%d"
+             " nec=%s/%d repeat_bits=%" PRIu32 " b_refused=%d b_released=%d",
+             s_rec.frame_count, s_rec.frame[0].data, s_rec.frame[0].bits,
+             s_rec.frame[0].valid ? "ok" : "bad", s_rec.frame[0].duration_us,
+             s_rec.frame[1].valid, s_rec.frame[2].data, s_rec.frame[2].valid,
+             s_rec.frame[3].bits, b_refused, b_released);
+    return report("burst_decode", pass, detail);
+#else
+    return report("burst_decode", true, "skipped (burst capture disabled)");
+#endif
+}
+
+static bool s_replay_done;
+
+static void replay_done(void *arg) {
+    (void)arg;
+    s_replay_done = true;
+}
+
+// Run a replay to its last edge plus settle time; returns its start time.
+static int64_t replay_run(const uint8_t *blob, size_t len, const gpio_num_t *pin_map,
+                          int64_t settle_us, esp_err_t *err) {
+    debounce_replay_config_t cfg = {
+        .data = blob, .len = len, .pin_map = pin_map, .done = replay_done,
+    };
+    s_replay_done = false;
+    int64_t start = pin_sim_now();
+    *err = debounce_replay_start(&cfg);
+    while (*err == ESP_OK && !s_replay_done) {
+        run_until(pin_sim_now() + DRAIN_STEP_US);
+    }
+    run_until(pin_sim_now() + settle_us);
+    debounce_replay_stop();
+    return start;
+}
+
+/**
+ * Capture a trailing and a leading pin while they bounce, then replay the
+ * capture onto two fresh pins: every event must come out with the same level
+ * and the same edge and confirm offsets from the start, to the microsecond.
+ */
+static bool scenario_capture_replay(void) {
+#if CONFIG_DEBOUNCE_CAPTURE
+    static const gpio_num_t src[2] = { GPIO_NUM_15, GPIO_NUM_17 };
+    static gpio_num_t pin_map[GPIO_NUM_MAX];
+    static sim_recorder_t captured;
+    static uint8_t blob[4096];
+    const pin_sim_bounce_t shape = { .bounces = 5, .bounce_us = 1800, .jitter_us = 400 };
+    char detail[160];
+
+    recorder_reset();
+    if (register_pin(src[0], 4000, DEBOUNCE_POLICY_TRAILING, true, false) != ESP_OK ||
+        register_pin(src[1], 15000, DEBOUNCE_POLICY_LEADING, true, true) != ESP_OK) {
+        return report("capture_replay", false, "register failed");
+    }
+    if (debounce_capture_start((1ULL << src[0]) | (1ULL << src[1])) != ESP_OK) {
+        return report("capture_replay", false, "capture start failed");
+    }
+    int64_t t_capture = pin_sim_now();
+    int64_t t0 = t_capture + 10000;
+    for (int i = 0; i < 12; i++) {
+        pin_sim_transition(src[i & 1], t0 + i * 23000, 0, &shape);
+        pin_sim_transition(src[i & 1], t0 + i * 23000 + 11000, 1, &shape);
+    }
+    run_until(t0 + 12 * 23000 + 40000);
+    debounce_capture_stop();
+
+    size_t len = 0;
+    esp_err_t err = debounce_capture_export(blob, sizeof(blob), &len);
+    captured = s_rec;
+    (void)debounce_unregister_pin(src[0]);
+    (void)debounce_unregister_pin(src[1]);
+    if (err != ESP_OK) {
+        return report("capture_replay", false, "export failed");
+    }
+
+    for (int i = 0; i < GPIO_NUM_MAX; i++) {
+        pin_map[i] = GPIO_NUM_NC;
+    }
+    pin_map[src[0]] = GPIO_NUM_16;
+    pin_map[src[1]] = GPIO_NUM_18;
+    recorder_reset();
+    int64_t t_replay = replay_run(blob, len, pin_map, 40000, &err);
+
+    bool same = err == ESP_OK && captured.trace_count == s_rec.trace_count &&
+                captured.trace_count > 0 && captured.trace_count <= TRACE_MAX;
+    for (uint32_t i = 0; same && i < captured.trace_count; i++) {
+        same = pin_map[captured.trace[i].pin] == s_rec.trace[i].pin &&
+               captured.trace[i].level == s_rec.trace[i].level &&
+               captured.trace[i].edge_us - (uint32_t)t_capture == s_rec.trace[i].edge_us - (uint32_t)t_replay &&
+               captured.trace[i].confirm_us - (uint32_t)t_capture ==
+                   s_rec.trace[i].confirm_us - (uint32_t)t_replay;
+    }
+    snprintf(detail, sizeof(detail), "bytes=%u events=%" PRIu32 "/%" PRIu32 " identical=%s",
+             (unsigned)len, s_rec.trace_count, captured.trace_count, same ? "yes" : "no");
+    return report("capture_replay", same, detail);
+#else
+    return report("capture_replay", true, "skipped (capture disabled)");
+#endif
+}
+
+typedef struct {
+    int64_t at_us;
+    uint8_t bit;
+    uint8_t level;
+} la_edge_t;
+
+static la_edge_t s_la_edges[LA_EDGES_MAX]; // Scheduled, kept in time order
+static size_t s_la_edge_count;
+static uint8_t s_la_blob[4096];
+static size_t s_la_blob_len;
+static bool s_la_done;
+
+static void la_schedule(gpio_num_t pin, uint8_t bit, int64_t at_us, int level) {
+    pin_sim_schedule(pin, at_us, level);
+    if (s_la_edge_count == LA_EDGES_MAX) {
+        return;
+    }
+    size_t i = s_la_edge_count++;
+    while (i > 0 && s_la_edges[i - 1].at_us > at_us) {
+        s_la_edges[i] = s_la_edges[i - 1];
+        i--;
+    }
+    s_la_edges[i] = (la_edge_t){ at_us, bit, (uint8_t)level };
+}
+
+static esp_err_t la_write(const void *data, size_t len, void *ctx) {
+    (void)ctx;
+    if (s_la_blob_len + len > sizeof(s_la_blob)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(s_la_blob + s_la_blob_len, data, len);
+    s_la_blob_len += len;
+    return ESP_OK;
+}
+
+static void la_done(void *arg) {
+    (void)arg;
+    s_la_done = true;
+}
+
+static uint64_t get_le(const uint8_t *p, int bytes) {
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/**
+ * Logic analyzer on a bouncing button and a toggling line next to it at 1 MHz,
+ * triggered on the button's first fall with 500 samples of history: the
+ * exported run-length records must decode to exactly the scheduled edges
+ * inside the window, to the microsecond, while the button pin keeps being
+ * debounced into one event per press and release.
+ */
+static bool scenario_logic_capture(void) {
+#if CONFIG_DEBOUNCE_LA
+    static const gpio_num_t pins[2] = { GPIO_NUM_38, GPIO_NUM_39 };
+    const uint32_t pre = 500;
+    const uint32_t post = 20000;
+    char detail[192];
+
+    recorder_reset();
+    s_la_edge_count = 0;
+    s_la_blob_len = 0;
+    s_la_done = false;
+    if (register_pin(pins[0], 2000, DEBOUNCE_POLICY_TRAILING, true, false) != ESP_OK) {
+        return report("logic_capture", false, "register failed");
+    }
+    const debounce_la_config_t la = {
+        .pins = pins, .pin_count = 2, .clock_pin = GPIO_NUM_40, .sample_hz = 1000000,
+        .trigger_mask = 0x1, .trigger_value = 0x0, .trigger_edge = true,
+        .pre_samples = pre, .post_samples = post, .on_done = la_done,
+    };
+    if (debounce_la_arm(&la) != ESP_OK) {
+        (void)debounce_unregister_pin(pins[0]);
+        return report("logic_capture", false, "arm failed");
+    }
+
+    int64_t t = pin_sim_now() + 10000;  // The trigger
+    for (int i = 0; i < 30; i++) {
+        la_schedule(pins[1], 1, t - 2050 + 100 * i, !(i & 1));
+    }
+    la_schedule(pins[0], 0, t, 0);
+    la_schedule(pins[0], 0, t + 30, 1);
+    la_schedule(pins[0], 0, t + 61, 0);
+    la_schedule(pins[0], 0, t + 15000, 1);
+    la_schedule(pins[0], 0, t + 19999, 0);  // Last sample of the window
+    la_schedule(pins[0], 0, t + 20000, 1);  // Just past it
+    run_until(t + 40000);
+    (void)debounce_unregister_pin(pins[0]);
+
+    debounce_la_status_t st;
+    debounce_la_get_status(&st);
+    esp_err_t err = debounce_la_export(la_write, NULL);
+    const uint8_t *b = s_la_blob;
+    bool header = err == ESP_OK && s_la_blob_len >= 42 && !memcmp(b, "DBLA", 4) && b[4] == 1 &&
+                  b[5] == 2 && b[6] == 1 && b[7] == 0x01 && b[40] == pins[0] && b[41] == pins[1];
+    uint32_t records = header ? (uint32_t)get_le(b + 12, 4) : 0;
+    uint64_t total = header ? get_le(b + 16, 8) : 0;
+    uint64_t trigger = header ? get_le(b + 24, 8) : 0;
+    int64_t first_us = header ? (int64_t)get_le(b + 32, 8) : 0;
+    header = header && get_le(b + 8, 4) == 1000000 && s_la_blob_len == 42 + 4 * records;
+
+    // Every change between records is one edge per changed bit.
+    size_t expected = 0;
+    size_t decoded = 0;
+    size_t mismatched = 0;
+    uint64_t at = 0;
+    uint32_t prev = 0;
+    for (uint32_t r = 0; header && r < records; r++) {
+        uint32_t rec = (uint32_t)get_le(b + 42 + 4 * r, 4);
+        uint32_t value = rec >> 24;
+        for (uint8_t bit = 0; r && bit < 2; bit++) {
+            if (((value ^ prev) >> bit) & 1) {
+                while (expected < s_la_edge_count && s_la_edges[expected].at_us <= first_us) {
+                    expected++;
+                }
+                const la_edge_t *e = expected < s_la_edge_count ? &s_la_edges[expected++] : NULL;
+                mismatched += !e || e->at_us != first_us + (int64_t)at || e->bit != bit ||
+                              e->level != ((value >> bit) & 1);
+                decoded++;
+            }
+        }
+        prev = value;
+        at += rec & 0xffffff;
+    }
+    size_t in_window = 0;
+    for (size_t i = 0; i < s_la_edge_count; i++) {
+        int64_t off = s_la_edges[i].at_us - first_us;
+        in_window += off > 0 && off < (int64_t)total;
+    }
+
+    // The blip at the end of the window settles back at 1: a repeat report,
+    // except on the template engine, which reports changes only.
+#if CONFIG_DEBOUNCE_TPL
+    const uint32_t want_events = 2;
+#else
+    const uint32_t want_events = 3;
+#endif
+    bool debounced = s_rec.events[pins[0]] == want_events && s_rec.trace_count >= want_events &&
+                     s_rec.trace[0].level == 0 && s_rec.trace[0].edge_us == (uint32_t)t;
+    bool pass = s_la_done && st.state == DEBOUNCE_LA_DONE && header && at == total &&
+                total == pre + post && trigger == pre && first_us == t - pre &&
+                decoded == in_window && mismatched == 0 && debounced;
+    snprintf(detail, sizeof(detail),
+             "records=%" PRIu32 " samples=%" PRIu64 " trigger=%" PRIu64 " edges=%u/%u"
+             " mismatched=%u debounced_events=%" PRIu32 " bytes=%u",
+             records, total, trigger, (unsigned)decoded, (unsigned)in_window,
+             (unsigned)mismatched, s_rec.events[pins[0]], (unsigned)s_la_blob_len);
+    return report("logic_capture", pass, detail);
+#else
+    return report("logic_capture", true, "skipped (logic analyzer disabled)");
+#endif
+}
+
+/**
+ * Deep-sleep monitoring on the emulated ULP: a bouncing button is queued
+ * until the watermark wakes the CPU, with ages that match the script; a batch
+ * that is peeked but not consumed does not wake it again before the
+ * heartbeat; a priority pin wakes it at once and a lone change after the
+ * latency limit.
+ */
+static bool scenario_ulp_batch(void) {
+#if CONFIG_DEBOUNCE_ULP
+    const gpio_num_t button = GPIO_NUM_2;
+    const gpio_num_t alarm = GPIO_NUM_3;
+    const uint32_t window_us = 20000;
+    const uint32_t poll_us = 5000;
+    const pin_sim_bounce_t shape = { .bounces = 4, .bounce_us = 3000, .jitter_us = 200 };
+    const debounce_config_t pins[] = {
+        { .pin = button, .pull_up = true, .debounce_time_us = window_us },
+        { .pin = alarm, .pull_up = true, .debounce_time_us = window_us },
+        { .pin = GPIO_NUM_38, .pull_up = true, .debounce_time_us = window_us },  // Not RTC
+    };
+    const debounce_ulp_config_t ulp = {
+        .poll_us = poll_us, .watermark = 8, .priority_mask = 1ULL << alarm,
+        .max_latency_ms = 2000, .heartbeat_s = 30,
+    };
+    const int64_t slack_us = shape.bounce_us + shape.jitter_us + poll_us;
+    debounce_ulp_event_t ev[16];
+    int64_t at[8];  // Settling edges
+    uint32_t lost = 0;
+    char detail[192];
+
+    // Watermark: four presses and releases.
+    bool resumed = true;
+    bool ok = debounce_ulp_start(pins, 3, &ulp, &resumed) == ESP_OK && !resumed;
+    int64_t t0 = pin_sim_now() + 20000;
+    for (int i = 0; i < 4; i++) {
+        at[2 * i] = pin_sim_transition(button, t0 + i * 100000, 0, &shape);
+        at[2 * i + 1] = pin_sim_transition(button, t0 + i * 100000 + 50000, 1, &shape);
+    }
+    ok = ok && debounce_ulp_sleep() == ESP_OK;
+    uint32_t wake_watermark = debounce_ulp_wake_cause();
+    int64_t woke_us = pin_sim_now() - at[7];
+    size_t n = debounce_ulp_peek(ev, 16, &lost);
+    size_t aged = 0;
+    for (size_t i = 0; i < n && i < 8; i++) {
+        int64_t age = pin_sim_now() - at[i];
+        aged += ev[i].pin == button && ev[i].level == (int)(i & 1) &&
+                ev[i].age_us >= age - (int64_t)poll_us && ev[i].age_us <= age + slack_us;
+    }
+    bool watermark = ok && wake_watermark == DEBOUNCE_ULP_WAKE_WATERMARK && n == 8 &&
+                     aged == 8 && lost == 0 && woke_us >= window_us - (int64_t)poll_us &&
+                     woke_us <= window_us + 2 * (int64_t)poll_us;
+
+    // Not consumed: nothing new, so only the heartbeat wakes the CPU.
+    int64_t slept = pin_sim_now();
+    ok = debounce_ulp_start(pins, 3, &ulp, &resumed) == ESP_OK && resumed &&
+         debounce_ulp_sleep() == ESP_OK;
+    slept = pin_sim_now() - slept;
+    uint32_t wake_heartbeat = debounce_ulp_wake_cause();
+    size_t again = debounce_ulp_peek(ev, 16, &lost);
+    bool kept = again == 8 && ev[0].age_us >= pin_sim_now() - at[0] - (int64_t)poll_us;
+    debounce_ulp_consume(again);
+    bool heartbeat = ok && wake_heartbeat == DEBOUNCE_ULP_WAKE_HEARTBEAT &&
+                     slept == 30 * 1000000LL && kept && debounce_ulp_peek(ev, 16, NULL) == 0;
+
+    // Priority: one change wakes the CPU once it is debounced.
+    int64_t t = pin_sim_transition(alarm, pin_sim_now() + 20000, 0, &shape);
+    ok = debounce_ulp_start(pins, 3, &ulp, &resumed) == ESP_OK && debounce_ulp_sleep() == ESP_OK;
+    int64_t priority_us = pin_sim_now() - t;
+    n = debounce_ulp_peek(ev, 16, &lost);
+    debounce_ulp_consume(n);
+    bool priority = ok && debounce_ulp_wake_cause() == DEBOUNCE_ULP_WAKE_PRIORITY && n == 1 &&
+                    ev[0].pin == alarm && ev[0].level == 0 &&
+                    priority_us <= window_us + 2 * (int64_t)poll_us;
+
+    // Latency: a lone change waits max_latency_ms.
+    t = pin_sim_transition(button, pin_sim_now() + 20000, 0, &shape);
+    ok = debounce_ulp_start(pins, 3, &ulp, &resumed) == ESP_OK && debounce_ulp_sleep() == ESP_OK;
+    int64_t latency_us = pin_sim_now() - t;
+    n = debounce_ulp_peek(ev, 16, &lost);
+    debounce_ulp_consume(n);
+    bool latency = ok && debounce_ulp_wake_cause() == DEBOUNCE_ULP_WAKE_LATENCY && n == 1 &&
+                   ev[0].pin == button && lost == 0 && latency_us >= 2000000 - (int64_t)poll_us &&
+                   latency_us <= 2000000 + 2 * (int64_t)poll_us;
+
+    snprintf(detail, sizeof(detail),
+             "watermark=%u events=%u/8 aged=%u woke=%" PRId64 "us heartbeat=%u kept=%u"
+             " priority=%" PRId64 "us latency=%" PRId64 "us",
+             (unsigned)wake_watermark, (unsigned)again, (unsigned)aged, woke_us,
+             (unsigned)wake_heartbeat, (unsigned)kept, priority_us, latency_us);
+    return report("ulp_batch", watermark && heartbeat && priority && latency, detail);
+#else
+    return report("ulp_batch", true, "skipped (ULP monitoring disabled)");
+#endif
+}
+
+/**
+ * Replay a capture uploaded from the field (path in PIN_SIM_CAPTURE) through
+ * the engine on its original pins and print what came out. Skipped when the
+ * variable is not set.
+ */
+static bool scenario_replay_file(void) {
+    const char *path = getenv("PIN_SIM_CAPTURE");
+    if (!path || !CONFIG_DEBOUNCE_CAPTURE) {
+        return true;
+    }
+    char detail[160];
+    FILE *f = fopen(path, "rb");
+    static uint8_t blob[1 << 18];
+    size_t len = f ? fread(blob, 1, sizeof(blob), f) : 0;
+    if (f) {
+        fclose(f);
+    }
+    if (len == 0) {
+        return report("replay_file", false, "cannot read capture");
+    }
+
+    recorder_reset();
+    esp_err_t err;
+    int64_t t_replay = replay_run(blob, len, NULL, 1000000, &err);
+    for (uint32_t i = 0; i < s_rec.trace_count && i < TRACE_MAX; i++) {
+        printf("REPLAY pin=%u level=%u edge_us=%" PRIu32 " confirm_us=%" PRIu32 "\n",
+               s_rec.trace[i].pin, s_rec.trace[i].level,
+               s_rec.trace[i].edge_us - (uint32_t)t_replay,
+               s_rec.trace[i].confirm_us - (uint32_t)t_replay);
+    }
+    snprintf(detail, sizeof(detail), "bytes=%u events=%" PRIu32 " err=%s",
+             (unsigned)len, s_rec.trace_count, esp_err_to_name(err));
+    return report("replay_file", err == ESP_OK, detail);
+}
+
+void app_main(void)
+{
+    esp_log_level_set("PinPipeline", ESP_LOG_WARN);
+    esp_log_level_set("Debounce", ESP_LOG_WARN);
+    esp_log_level_set("DebounceCapture", ESP_LOG_WARN);
+    esp_log_level_set("DebounceReplay", ESP_LOG_WARN);
+    esp_log_level_set("DebouncePcnt", ESP_LOG_WARN);
+    esp_log_level_set("DebounceBurst", ESP_LOG_WARN);
+    esp_log_level_set("DebounceLA", ESP_LOG_WARN);
+    esp_log_level_set("DebounceULP", ESP_LOG_WARN);
+
+    pin_sim_seed(SIM_SEED);
+    s_rec.hash = 2166136261u;
+    debounce_init();
+    pin_pipeline_set_sink(sim_sink, &s_rec);
+
+    int failed = 0;
+    failed += !scenario_trailing_bounce();
+    failed += !scenario_leading_edge();
+    failed += !scenario_throughput();
+    failed += !scenario_chatter();
+    failed += !scenario_pulse_count();
+    failed += !scenario_encoder();
+    failed += !scenario_pwm_capture();
+    failed += !scenario_burst_decode();
+    failed += !scenario_capture_replay();
+    failed += !scenario_logic_capture();
+    failed += !scenario_ulp_batch();
+    failed += !scenario_replay_file();
+
+    printf("SIM hash=%08" PRIx32 " seed=%08x\n", s_rec.hash, (unsigned)SIM_SEED);
+    if (failed) {
+        ESP_LOGE(TAG, "%d scenario(s) failed", failed);
+        printf("SIM result: FAIL\n");
+    } else {
+        printf("SIM result: PASS\n");
+    }
+}
@@ -0,0 +1,20 @@
+# SPDX-License-Identifier: CC0-1.0
+import re
+
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+
+SCENARIOS = ('trailing_bounce', 'leading_edge', 'throughput', 'chatter', 'pulse_count',
+             'encoder', 'pwm_capture', 'burst_decode', 'capture_replay',
+             'logic_capture', 'ulp_batch')
+
+
+@pytest.mark.linux
+@pytest.mark.host_test
+@pytest.mark.parametrize('config', ['default', 'tpl', 'tpl_global_isr'], indirect=True)
+def test_pin_monitor_sim(dut: IdfDut) -> None:
+    for name in SCENARIOS:
+        line = dut.expect(re.compile(rf'SIM {name}: (PASS|FAIL)([^\r\n]*)'), timeout=60)
+        status, detail = (g.decode('utf-8') for g in line.groups())
+        assert status == 'PASS', f'{name}:{detail}'
+    dut.expect_exact('SIM result: PASS', timeout=10)
@@ -0,0 +1,2 @@
+# Timer-engine pins on the C++ Debouncer template, fed by per-pin GPIO ISRs
+CONFIG_DEBOUNCE_TPL=y
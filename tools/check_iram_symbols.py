@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""Fail the build if a function on the GPIO edge capture path is not in IRAM.
+
+Runs objdump -t on the final ELF and checks the section of every hot-path
+function. Static helpers are matched by their source file (the FILE symbol
+they follow) and may be inlined away, so only functions that exist are
+checked; at least one GPIO ISR entry point must be found.
+
+Usage: check_iram_symbols.py [--objdump <objdump>] <app.elf>
+"""
+import argparse
+import subprocess
+import sys
+
+# Entry points: whichever GPIO interrupt mode is configured must be present.
+ISR_ENTRY = ('gpio_isr_handler', 'gpio_global_isr')
+
+# Everything the ISRs and the ISR-dispatched wheel can reach, by source file.
+HOT_PATH = {
+    'debounce.c': ISR_ENTRY + (
+        'arm_edge_group', 'chatter_on_edge', 'chatter_poll', 'handle_expiry', 'emit',
+        'report_level', 'on_burst_start', 'edge_window_us', 'tracks_state', 'build_event',
+        'record_latency', 'debounce_emit_event_from_isr', 'debounce_wheel_expired_isr',
+        'debounce_tpl_report'),
+    'debounce_tpl.cpp': ('debounce_tpl_edge',),
+    'debounce_wheel.c': (
+        'debounce_wheel_arm', 'debounce_wheel_arm_batch', 'debounce_wheel_cancel',
+        'wheel_arm_locked', 'wheel_insert', 'wheel_tick_callback', 'list_unlink', 'list_push'),
+    'debounce_adapt.c': ('debounce_adapt_record', 'bucket_of'),
+    'debounce_capture.c': ('debounce_capture_record',),
+    'debounce_pwm.c': ('on_capture', 'cycle_add', 'duty_bp'),
+    'debounce_burst.c': ('on_done', 'line_receive'),
+    'debounce_la.c': ('on_buffer',),
+    'pin_hal_par.c': ('on_eof',),
+    'event_coalesce.c': ('gpio_event_coalesce',),
+}
+
+# ESP-IDF globals; in IRAM through ESP_TIMER_IN_IRAM, GPIO_CTRL_FUNC_IN_IRAM,
+# RMT_RECV_FUNC_IN_IRAM and FREERTOS_IN_IRAM.
+IDF_HOT_PATH = (
+    'esp_timer_get_time', 'esp_timer_start_periodic', 'esp_timer_start_once', 'esp_timer_stop',
+    'gpio_intr_enable', 'gpio_intr_disable', 'vTaskGenericNotifyGiveFromISR', 'rmt_receive',
+)
+
+
+def function_sections(objdump, elf):
+    """Return {(file or None, name): section} for every function symbol."""
+    out = subprocess.run([objdump, '-t', elf], check=True, capture_output=True, text=True).stdout
+    functions = {}
+    current_file = None
+    for line in out.splitlines():
+        # <addr> <flags...> <section>\t<size> <name>
+        if '\t' not in line:
+            continue
+        head, tail = line.split('\t', 1)
+        fields = head.split()
+        parts = tail.split()
+        if len(fields) < 3 or len(parts) < 2:
+            continue
+        flags, section, name = fields[1:-1], fields[-1], parts[-1]
+        if 'df' in flags:
+            current_file = name
+        elif 'F' in flags:
+            local = 'l' in flags
+            functions[(current_file if local else None, name)] = section
+    return functions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--objdump', default='objdump')
+    parser.add_argument('elf')
+    args = parser.parse_args()
+
+    functions = function_sections(args.objdump, args.elf)
+    wanted = [(None, name) for name in IDF_HOT_PATH]
+    for source, names in HOT_PATH.items():
+        wanted += [(source, name) for name in names] + [(None, name) for name in names]
+
+    found = {key: functions[key] for key in wanted if key in functions}
+    if not any(key[1] in ISR_ENTRY for key in found):
+        print('check_iram_symbols: no GPIO ISR entry point found in {}'.format(args.elf))
+        return 1
+
+    bad = sorted('{} ({})'.format(name, section)
+                 for (_, name), section in found.items() if not section.startswith('.iram'))
+    if bad:
+        print('check_iram_symbols: hot-path functions outside IRAM:')
+        for entry in bad:
+            print('  ' + entry)
+        return 1
+    print('check_iram_symbols: {} hot-path functions checked, all in IRAM'.format(len(found)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
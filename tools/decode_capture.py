@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""Print a raw edge capture uploaded by the debounce component as CSV.
+
+Reads the version 1 format written by debounce_capture_export() (see
+debounce.h) and prints the captured pin configurations as comments, then
+one line per edge: time since the start of the capture, pin and level.
+
+Usage: decode_capture.py <capture.bin>
+"""
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct('<4sBBHIIIQ')
+PIN = struct.Struct('<BBBBBBHIII')
+ENGINES = ('timer', 'sampled', 'pcnt', 'encoder', 'pwm', 'burst')
+POLICIES = ('trailing', 'leading', 'asymmetric')
+
+
+def varint(data, pos):
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7f) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('capture')
+    args = parser.parse_args()
+
+    with open(args.capture, 'rb') as f:
+        data = f.read()
+    magic, version, pins, _, edges, lost, start_us, levels = HEADER.unpack_from(data)
+    if magic != b'DBCP' or version != 1:
+        print('decode_capture: not a version 1 capture', file=sys.stderr)
+        return 1
+
+    print('# edges={} lost={} start_us={} levels=0x{:x}'.format(edges, lost, start_us, levels))
+    pos = HEADER.size
+    for _ in range(pins):
+        pin, engine, policy, intr, flags, dispatch, _, window, press, release = \
+            PIN.unpack_from(data, pos)
+        pos += PIN.size
+        print('# pin={} engine={} policy={} intr_type={} pull_up={} changes_only={} '
+              'adaptive={} dispatch={} window_us={} press_us={} release_us={}'.format(
+                  pin, ENGINES[engine], POLICIES[policy], intr, flags & 1, (flags >> 1) & 1,
+                  (flags >> 2) & 1, dispatch, window, press, release))
+
+    print('t_us,pin,level')
+    t_us = 0
+    for _ in range(edges):
+        byte = data[pos]
+        dt_us, pos = varint(data, pos + 1)
+        t_us += dt_us
+        print('{},{},{}'.format(t_us, byte & 0x7f, byte >> 7))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
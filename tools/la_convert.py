@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""Convert a logic analyzer capture from the debounce component to VCD or sigrok.
+
+Reads the version 1 format written by debounce_la_export() (see
+debounce_la.h): a header, the GPIO of every bit and run-length records of
+the samples. The output format follows the extension of the output file:
+.vcd for a value change dump (GTKWave, PulseView), .sr for a sigrok session
+that PulseView opens with its sample rate and channel names. The VCD header
+notes the time of the trigger.
+
+Usage: la_convert.py <capture.la> <out.vcd|out.sr>
+"""
+import argparse
+import struct
+import sys
+import zipfile
+
+HEADER = struct.Struct('<4sBBBBIIQQq')
+FLAG_TRIGGERED = 0x01
+FLAG_TRUNCATED = 0x02
+FLAG_OVERRUN = 0x04
+SR_CHUNK = 4 << 20  # Bytes of samples per file in a sigrok session
+
+
+def read_capture(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    magic, version, pins, width, flags, rate, records, samples, trigger, start_us = \
+        HEADER.unpack_from(data)
+    if magic != b'DBLA' or version != 1:
+        raise ValueError('not a version 1 logic analyzer capture')
+    gpios = list(data[HEADER.size:HEADER.size + pins])
+    pos = HEADER.size + pins
+    len_bits = 32 - 8 * width
+    runs = []
+    for (record,) in struct.iter_unpack('<I', data[pos:pos + 4 * records]):
+        runs.append((record >> len_bits, record & ((1 << len_bits) - 1)))
+    return {
+        'gpios': gpios, 'width': width, 'flags': flags, 'rate': rate, 'samples': samples,
+        'trigger': trigger, 'start_us': start_us, 'runs': runs,
+    }
+
+
+def write_vcd(cap, path):
+    ids = [chr(33 + i) for i in range(len(cap['gpios']))]
+    ns_per_sample = 1e9 / cap['rate']
+    with open(path, 'w') as f:
+        f.write('$comment debounce logic analyzer, {} Hz, start {} us'.format(
+            cap['rate'], cap['start_us']))
+        if cap['flags'] & FLAG_TRIGGERED:
+            f.write(', trigger at {} ns'.format(round(cap['trigger'] * ns_per_sample)))
+        f.write(' $end\n$timescale 1 ns $end\n$scope module la $end\n')
+        for gpio, ident in zip(cap['gpios'], ids):
+            f.write('$var wire 1 {} gpio{} $end\n'.format(ident, gpio))
+        f.write('$upscope $end\n$enddefinitions $end\n')
+
+        at = 0
+        prev = None
+        for value, length in cap['runs']:
+            changed = [i for i in range(len(ids))
+                       if prev is None or ((value ^ prev) >> i) & 1]
+            if changed:
+                f.write('#{}\n'.format(round(at * ns_per_sample)))
+                for i in changed:
+                    f.write('{}{}\n'.format((value >> i) & 1, ids[i]))
+            prev = value
+            at += length
+        f.write('#{}\n'.format(round(at * ns_per_sample)))
+
+
+def rate_string(rate):
+    for scale, unit in ((1000000000, 'GHz'), (1000000, 'MHz'), (1000, 'kHz')):
+        if rate % scale == 0:
+            return '{} {}'.format(rate // scale, unit)
+    return '{} Hz'.format(rate)
+
+
+def write_sigrok(cap, path):
+    width = cap['width']
+    names = ''.join('probe{}=gpio{}\n'.format(i + 1, gpio) for i, gpio in enumerate(cap['gpios']))
+    metadata = ('[global]\nsigrok version=0.5.2\n\n[device 1]\ncapturefile=logic-1\n'
+                'total probes={}\nsamplerate={}\ntotal analog=0\n{}unitsize={}\n').format(
+                    len(cap['gpios']), rate_string(cap['rate']), names, width)
+    with zipfile.ZipFile(path, 'w', zipfile.ZIP_DEFLATED) as z:
+        z.writestr('version', '2')
+        z.writestr('metadata', metadata)
+        chunk = bytearray()
+        index = 1
+        for value, length in cap['runs']:
+            sample = value.to_bytes(width, 'little')
+            while length:
+                n = min(length, (SR_CHUNK - len(chunk)) // width)
+                chunk += sample * n
+                length -= n
+                if len(chunk) + width > SR_CHUNK:
+                    z.writestr('logic-1-{}'.format(index), bytes(chunk))
+                    index += 1
+                    chunk = bytearray()
+        if chunk or index == 1:
+            z.writestr('logic-1-{}'.format(index), bytes(chunk))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('capture')
+    parser.add_argument('output')
+    args = parser.parse_args()
+
+    try:
+        cap = read_capture(args.capture)
+    except (OSError, ValueError, struct.error) as e:
+        print('la_convert: {}'.format(e), file=sys.stderr)
+        return 1
+    if args.output.endswith('.vcd'):
+        write_vcd(cap, args.output)
+    elif args.output.endswith('.sr'):
+        write_sigrok(cap, args.output)
+    else:
+        print('la_convert: output must end in .vcd or .sr', file=sys.stderr)
+        return 1
+
+    notes = []
+    if not cap['flags'] & FLAG_TRIGGERED:
+        notes.append('not triggered')
+    if cap['flags'] & FLAG_TRUNCATED:
+        notes.append('truncated')
+    if cap['flags'] & FLAG_OVERRUN:
+        notes.append('overrun')
+    print('{} samples at {} Hz on GPIO {}, {} runs{}'.format(
+        cap['samples'], cap['rate'], ','.join(str(g) for g in cap['gpios']), len(cap['runs']),
+        ' ({})'.format(', '.join(notes)) if notes else ''))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())